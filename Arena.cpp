@@ -0,0 +1,132 @@
+#include "Arena.h"
+#include <cstdlib>
+
+using namespace std;
+
+Arena::Arena(size_t chunkSize) {
+
+	this->chunkSize = chunkSize;
+	current = 0;
+	offset = 0;
+	allocations = 0;
+	heapAllocations = 0;
+	bytesUsed = 0;
+
+}
+
+Arena::~Arena() {
+
+	for (size_t i = 0; i < chunks.size(); i++) {
+		::operator delete(chunks[i].memory);
+	}
+
+}
+
+void* Arena::allocate(size_t size, size_t alignment) {
+
+	allocations++;
+	bytesUsed += size;
+
+	// Carry on through the chunks kept from earlier rounds before asking
+	// the heap for another
+	while (current < chunks.size()) {
+		uintptr_t base = (uintptr_t)chunks[current].memory;
+		size_t start = (size_t)(((base + offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base);
+		if (start + size <= chunks[current].size) {
+			offset = start + size;
+			return chunks[current].memory + start;
+		}
+		current++;
+		offset = 0;
+	}
+
+	Chunk chunk;
+	chunk.size = size + alignment > chunkSize ? size + alignment : chunkSize;
+	chunk.memory = (uint8_t*)::operator new(chunk.size);
+	chunks.push_back(chunk);
+	heapAllocations++;
+	current = chunks.size() - 1;
+
+	uintptr_t base = (uintptr_t)chunk.memory;
+	size_t start = (size_t)(((base + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base);
+	offset = start + size;
+	return chunk.memory + start;
+
+}
+
+void Arena::reset() {
+
+	current = 0;
+	offset = 0;
+	allocations = 0;
+	bytesUsed = 0;
+
+}
+
+size_t Arena::getBytesReserved() const {
+
+	size_t total = 0;
+	for (size_t i = 0; i < chunks.size(); i++) {
+		total += chunks[i].size;
+	}
+	return total;
+
+}
+
+#ifdef LIGHTCYCLES_COUNT_ALLOCATIONS
+
+#include <atomic>
+
+static atomic<unsigned long long> heapAllocationCount(0);
+
+void* operator new(size_t size) {
+
+	heapAllocationCount++;
+	void* memory = malloc(size > 0 ? size : 1);
+	if (memory == nullptr) {
+		throw bad_alloc();
+	}
+	return memory;
+
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept {
+
+	heapAllocationCount++;
+	return malloc(size > 0 ? size : 1);
+
+}
+
+void operator delete(void* memory) noexcept {
+
+	free(memory);
+
+}
+
+void operator delete(void* memory, size_t) noexcept {
+
+	free(memory);
+
+}
+
+void operator delete(void* memory, const nothrow_t&) noexcept {
+
+	free(memory);
+
+}
+
+unsigned long long HeapAllocationCount() {
+
+	return heapAllocationCount;
+
+}
+
+#else
+
+unsigned long long HeapAllocationCount() {
+
+	return 0;
+
+}
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Bump allocator for everything that lives exactly one round. Memory comes
+// from the heap in large chunks and is handed out by moving a pointer;
+// nothing is freed on its own, reset() takes it all back at once and keeps
+// the chunks, so from the second round on a round costs no heap
+// allocations at all. Not thread safe: one arena per thread of work.
+class Arena {
+protected:
+	struct Chunk {
+		uint8_t* memory;
+		size_t size;
+	};
+
+	std::vector<Chunk> chunks;
+	size_t current;				// Chunk being bumped through
+	size_t offset;				// First free byte in it
+	size_t chunkSize;
+
+	unsigned long long allocations;
+	unsigned long long heapAllocations;
+	size_t bytesUsed;
+
+public:
+	Arena(size_t chunkSize = 256 * 1024);
+	~Arena();
+
+	void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+	// Forget every allocation. Their memory is reused by what comes next.
+	void reset();
+
+	// Since the last reset
+	unsigned long long getAllocations() const { return allocations; };
+	// Chunks taken from the heap, ever. Flat from round to round once warm.
+	unsigned long long getHeapAllocations() const { return heapAllocations; };
+	size_t getBytesUsed() const { return bytesUsed; };
+	size_t getBytesReserved() const;
+
+};
+
+// Lets standard containers live in an arena. A null arena means the heap,
+// which is also what copies get, so a copied container never ties itself
+// to an arena that may be reset under it.
+template <class T>
+class ArenaAllocator {
+public:
+	typedef T value_type;
+	typedef std::false_type propagate_on_container_copy_assignment;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
+	Arena* arena;
+
+	ArenaAllocator(Arena* arena = nullptr) : arena(arena) {};
+	template <class U>
+	ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {};
+
+	T* allocate(size_t count) {
+		if (arena != nullptr) {
+			return (T*)arena->allocate(count * sizeof(T), alignof(T));
+		}
+		return (T*)::operator new(count * sizeof(T));
+	};
+	void deallocate(T* pointer, size_t) {
+		if (arena == nullptr) {
+			::operator delete(pointer);
+		}
+	};
+	ArenaAllocator select_on_container_copy_construction() const { return ArenaAllocator(); };
+
+	template <class U>
+	bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; };
+	template <class U>
+	bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; };
+};
+
+// Fixed-size slots for one type, carved out of an arena and recycled
+// through a free list, for objects that come and go during a round.
+class PoolBase {
+public:
+	virtual ~PoolBase() {};
+	// Take back a slot whose object has already been destroyed
+	virtual void release(void* slot) = 0;
+	// Drop every slot, call after resetting the arena
+	virtual void reset() = 0;
+};
+
+template <class T>
+class Pool : public PoolBase {
+protected:
+	union Slot {
+		Slot* next;
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	Arena* arena;
+	Slot* freeSlots;
+	size_t live;
+
+public:
+	Pool(Arena* arena) : arena(arena), freeSlots(nullptr), live(0) {};
+
+	template <class... Args>
+	T* create(Args&&... args) {
+		Slot* slot = freeSlots;
+		if (slot != nullptr) {
+			freeSlots = slot->next;
+		}
+		else {
+			slot = (Slot*)arena->allocate(sizeof(Slot), alignof(Slot));
+		}
+		live++;
+		return new (slot->storage) T(std::forward<Args>(args)...);
+	};
+
+	void destroy(T* object) {
+		object->~T();
+		release(object);
+	};
+
+	void release(void* object) {
+		Slot* slot = (Slot*)object;
+		slot->next = freeSlots;
+		freeSlots = slot;
+		live--;
+	};
+
+	void reset() {
+		freeSlots = nullptr;
+		live = 0;
+	};
+
+	size_t getLive() const { return live; };
+
+};
+
+// Every operator new in the process, counted when the build defines
+// LIGHTCYCLES_COUNT_ALLOCATIONS (Arena.cpp then replaces the global
+// operator new). Zero otherwise.
+unsigned long long HeapAllocationCount();
+
+#endif
@@ -0,0 +1,274 @@
+#include "AssetArchive.h"
+#include "Compression.h"
+#include <cstring>
+#include <fstream>
+#include <new>
+
+using namespace std;
+
+static const uint8_t ARCHIVE_MAGIC[4] = { 'L', 'C', 'P', 'K' };
+static const uint32_t ARCHIVE_VERSION = 1;
+static const size_t HEADER_BYTES = 16;
+static const size_t ENTRY_BYTES = 64;
+static const size_t NAME_BYTES = 32;
+static const size_t BLOB_ALIGNMENT = 64;
+static const int MAX_DIMENSION = 1 << 15;
+// What a bitmap's 32-bit size fields can describe, as SaveBmp requires
+static const uint64_t MAX_PIXEL_BYTES = UINT32_MAX;
+
+static const uint32_t COMPRESSION_NONE = 0,
+					  COMPRESSION_LZ = 1;
+
+static uint32_t readU32(const uint8_t* p) {
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t readU64(const uint8_t* p) {
+	return (uint64_t)readU32(p) | ((uint64_t)readU32(p + 4) << 32);
+}
+
+static void writeU32(uint8_t* p, uint32_t value) {
+	for (int i = 0; i < 4; i++) {
+		p[i] = (uint8_t)(value >> (i * 8));
+	}
+}
+
+static void writeU64(uint8_t* p, uint64_t value) {
+	writeU32(p, (uint32_t)value);
+	writeU32(p + 4, (uint32_t)(value >> 32));
+}
+
+AssetArchive::AssetArchive() {
+
+	error = "Not loaded";
+
+}
+
+bool AssetArchive::fail(const char* message) {
+
+	file.close();
+	entries.clear();
+	error = message;
+	return false;
+
+}
+
+bool AssetArchive::open(const string& fileName) {
+
+	entries.clear();
+	if (!file.open(fileName)) {
+		return fail("Could not open file");
+	}
+	return parse();
+
+}
+
+#ifdef _WIN32
+
+bool AssetArchive::open(const wstring& fileName) {
+
+	entries.clear();
+	if (!file.open(fileName)) {
+		return fail("Could not open file");
+	}
+	return parse();
+
+}
+
+#endif
+
+void AssetArchive::close() {
+
+	file.close();
+	entries.clear();
+	error = "Not loaded";
+
+}
+
+bool AssetArchive::parse() {
+
+	const uint8_t* data = file.data();
+	size_t size = file.size();
+
+	if (size < HEADER_BYTES || memcmp(data, ARCHIVE_MAGIC, 4) != 0) {
+		return fail("Not an asset archive");
+	}
+	if (readU32(data + 4) != ARCHIVE_VERSION) {
+		return fail("Unsupported archive version");
+	}
+	uint32_t count = readU32(data + 8);
+	if (count > (size - HEADER_BYTES) / ENTRY_BYTES) {
+		return fail("Truncated archive index");
+	}
+
+	entries.resize(count);
+	for (uint32_t i = 0; i < count; i++) {
+		const uint8_t* p = data + HEADER_BYTES + (size_t)i * ENTRY_BYTES;
+		Entry& entry = entries[i];
+		entry.id = readU32(p);
+		uint32_t width = readU32(p + 4);
+		uint32_t height = readU32(p + 8);
+		entry.compression = readU32(p + 12);
+		entry.offset = readU64(p + 16);
+		entry.storedSize = readU64(p + 24);
+		const char* name = (const char*)p + 32;
+		entry.name.assign(name, strnlen(name, NAME_BYTES));
+
+		if (width == 0 || height == 0 || width > MAX_DIMENSION || height > MAX_DIMENSION) {
+			return fail("Bad image dimensions");
+		}
+		entry.width = (int)width;
+		entry.height = (int)height;
+		uint64_t pixelBytes = (uint64_t)width * height * 4;
+		if (pixelBytes > MAX_PIXEL_BYTES) {
+			return fail("Image too large");
+		}
+
+		// Every blob must lie inside the file, raw ones exactly one image long
+		// and aligned so their pixels can be read in place
+		if (entry.offset > size || entry.storedSize > size - entry.offset) {
+			return fail("Blob outside the archive");
+		}
+		if (entry.compression == COMPRESSION_NONE) {
+			if (entry.storedSize != pixelBytes || entry.offset % BLOB_ALIGNMENT != 0) {
+				return fail("Bad raw blob");
+			}
+		}
+		else if (entry.compression == COMPRESSION_LZ) {
+			// Like a bitmap's pixels, an image can't claim more than its blob can hold
+			if (pixelBytes > entry.storedSize * LZ_MAX_EXPANSION) {
+				return fail("Compressed blob too small for its image");
+			}
+		}
+		else {
+			return fail("Unknown compression");
+		}
+	}
+
+	error = nullptr;
+	return true;
+
+}
+
+int AssetArchive::find(uint32_t id) const {
+
+	for (size_t i = 0; i < entries.size(); i++) {
+		if (entries[i].id == id) {
+			return (int)i;
+		}
+	}
+	return -1;
+
+}
+
+int AssetArchive::find(const string& name) const {
+
+	for (size_t i = 0; i < entries.size(); i++) {
+		if (entries[i].name == name) {
+			return (int)i;
+		}
+	}
+	return -1;
+
+}
+
+const uint32_t* AssetArchive::getPixels(int index, PixelImage& scratch) const {
+
+	if (index < 0 || index >= (int)entries.size()) {
+		return nullptr;
+	}
+	const Entry& entry = entries[index];
+	const uint8_t* blob = file.data() + entry.offset;
+
+	// Pixels are stored little-endian, the byte order of every target we build for
+	if (entry.compression == COMPRESSION_NONE) {
+		return (const uint32_t*)blob;
+	}
+
+	// Parsing bounded the size by the blob, but it can still be more than we can get
+	try {
+		scratch.resize(entry.width, entry.height);
+	}
+	catch (const bad_alloc&) {
+		return nullptr;
+	}
+	if (!LzDecompress(blob, (size_t)entry.storedSize, (uint8_t*)scratch.pixels.data(),
+		scratch.pixels.size() * sizeof(uint32_t))) {
+		return nullptr;
+	}
+	return scratch.pixels.data();
+
+}
+
+bool AssetArchive::readImage(int index, PixelImage& image) const {
+
+	const uint32_t* pixels = getPixels(index, image);
+	if (pixels == nullptr) {
+		return false;
+	}
+	if (pixels != image.pixels.data()) {
+		image.resize(entries[index].width, entries[index].height);
+		memcpy(image.pixels.data(), pixels, image.pixels.size() * sizeof(uint32_t));
+	}
+	return true;
+
+}
+
+void AssetArchiveWriter::add(uint32_t id, const string& name, const PixelImage& image, bool compress) {
+
+	Item item;
+	item.id = id;
+	item.name = name.substr(0, NAME_BYTES - 1);
+	item.image = image;
+	item.compress = compress;
+	items.push_back(item);
+
+}
+
+bool AssetArchiveWriter::save(const string& fileName) const {
+
+	size_t indexEnd = HEADER_BYTES + items.size() * ENTRY_BYTES;
+	vector<uint8_t> data(indexEnd, 0);
+	memcpy(&data[0], ARCHIVE_MAGIC, 4);
+	writeU32(&data[4], ARCHIVE_VERSION);
+	writeU32(&data[8], (uint32_t)items.size());
+
+	vector<uint8_t> raw, packed;
+	for (size_t i = 0; i < items.size(); i++) {
+		const Item& item = items[i];
+		if (item.image.width <= 0 || item.image.height <= 0) {
+			return false;
+		}
+
+		raw.resize(item.image.pixels.size() * 4);
+		for (size_t p = 0; p < item.image.pixels.size(); p++) {
+			writeU32(&raw[p * 4], item.image.pixels[p]);
+		}
+		uint32_t compression = COMPRESSION_NONE;
+		const vector<uint8_t>* blob = &raw;
+		if (item.compress) {
+			LzCompress(raw.data(), raw.size(), packed);
+			if (packed.size() < raw.size()) {
+				compression = COMPRESSION_LZ;
+				blob = &packed;
+			}
+		}
+
+		data.resize((data.size() + BLOB_ALIGNMENT - 1) / BLOB_ALIGNMENT * BLOB_ALIGNMENT, 0);
+		uint8_t* entry = &data[HEADER_BYTES + i * ENTRY_BYTES];
+		writeU32(entry, item.id);
+		writeU32(entry + 4, (uint32_t)item.image.width);
+		writeU32(entry + 8, (uint32_t)item.image.height);
+		writeU32(entry + 12, compression);
+		writeU64(entry + 16, data.size());
+		writeU64(entry + 24, blob->size());
+		memcpy(entry + 32, item.name.c_str(), item.name.size());
+
+		data.insert(data.end(), blob->begin(), blob->end());
+	}
+
+	ofstream out(fileName.c_str(), ios::binary | ios::trunc);
+	out.write((const char*)data.data(), data.size());
+	return (bool)out;
+
+}
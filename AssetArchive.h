@@ -0,0 +1,89 @@
+#ifndef ASSET_ARCHIVE_H
+#define ASSET_ARCHIVE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Framebuffer.h"
+#include "MappedFile.h"
+
+// Every image the game needs in one file, mapped once at start-up. Images
+// are keyed by their Resource.h ID and by name, and stored as ready to use
+// 0x00RRGGBB pixels so a raw entry is used straight from the mapping.
+// Entries may instead be LZ compressed when that saves space.
+//
+// Layout (little-endian):
+//   header  "LCPK", version, entry count, reserved           16 bytes
+//   index   id, width, height, compression, offset (64-bit),
+//           stored size (64-bit), name (NUL padded)           64 bytes each
+//   blobs   each starting on a 64-byte boundary
+class AssetArchive {
+protected:
+	struct Entry {
+		uint32_t id;
+		std::string name;
+		int width;
+		int height;
+		uint32_t compression;
+		uint64_t offset;
+		uint64_t storedSize;
+	};
+
+	MappedFile file;
+	std::vector<Entry> entries;
+	const char* error;
+
+	bool parse();
+	bool fail(const char* message);
+
+public:
+	AssetArchive();
+
+	bool open(const std::string& fileName);
+#ifdef _WIN32
+	bool open(const std::wstring& fileName);
+#endif
+	void close();
+
+	// Index of an entry, -1 if there is none
+	int find(uint32_t id) const;
+	int find(const std::string& name) const;
+
+	// Pixels of an entry, width pixels per row. Raw entries point into the
+	// mapping, compressed ones are unpacked into scratch. nullptr if the
+	// entry is corrupt.
+	const uint32_t* getPixels(int index, PixelImage& scratch) const;
+	bool readImage(int index, PixelImage& image) const;
+
+	bool isOpen() const { return file.isOpen(); };
+	int getCount() const { return (int)entries.size(); };
+	uint32_t getId(int index) const { return entries[index].id; };
+	const std::string& getName(int index) const { return entries[index].name; };
+	int getWidth(int index) const { return entries[index].width; };
+	int getHeight(int index) const { return entries[index].height; };
+	bool isCompressed(int index) const { return entries[index].compression != 0; };
+	size_t getSize() const { return file.size(); };
+	const char* getError() const { return error; };
+
+};
+
+// Builds an archive, used by the offline packing tool
+class AssetArchiveWriter {
+protected:
+	struct Item {
+		uint32_t id;
+		std::string name;
+		PixelImage image;
+		bool compress;
+	};
+
+	std::vector<Item> items;
+
+public:
+	// Compressed only if that turns out smaller
+	void add(uint32_t id, const std::string& name, const PixelImage& image, bool compress);
+	bool save(const std::string& fileName) const;
+
+};
+
+#endif
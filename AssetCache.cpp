@@ -0,0 +1,134 @@
+#include "AssetCache.h"
+
+using namespace std;
+
+AssetCache::AssetCache() {
+
+	hits = 0;
+	misses = 0;
+	residentBytes = 0;
+
+}
+
+AssetCache::~AssetCache() {
+
+	clear();
+
+}
+
+shared_ptr<BitMap> AssetCache::lookup(const wstring& key) {
+
+	map<wstring, Entry>::iterator found = entries.find(key);
+	if (found == entries.end()) {
+		misses++;
+		return nullptr;
+	}
+	hits++;
+	return found->second.bitmap;
+
+}
+
+shared_ptr<BitMap> AssetCache::store(const wstring& key, BitMap* bitmap) {
+
+	Entry& entry = entries[key];
+	residentBytes -= entry.bytes;
+
+	// A bitmap that failed to load is kept as an empty entry
+	if (bitmap != NULL && !bitmap->isLoaded()) {
+		delete bitmap;
+		bitmap = NULL;
+	}
+	entry.bitmap.reset(bitmap);
+	entry.bytes = bitmap != NULL ? bitmap->getBytes() : 0;
+	residentBytes += entry.bytes;
+
+	return entry.bitmap;
+
+}
+
+shared_ptr<BitMap> AssetCache::loadBitMap(HDC hdc, const wstring& fileName) {
+
+	wstring key = L"file:" + fileName;
+	map<wstring, Entry>::iterator found = entries.find(key);
+	if (found != entries.end()) {
+		hits++;
+		return found->second.bitmap;
+	}
+
+	misses++;
+	return store(key, new BitMap(hdc, fileName));
+
+}
+
+shared_ptr<BitMap> AssetCache::loadBitMap(HDC hdc, UINT resID, HINSTANCE instance) {
+
+	wstring key = L"res:" + to_wstring((unsigned long long)(UINT_PTR)instance) + L":" + to_wstring(resID);
+	map<wstring, Entry>::iterator found = entries.find(key);
+	if (found != entries.end()) {
+		hits++;
+		return found->second.bitmap;
+	}
+
+	misses++;
+	return store(key, new BitMap(hdc, resID, instance));
+
+}
+
+shared_ptr<BitMap> AssetCache::loadBitMap(HDC hdc, const AssetArchive& archive, UINT resID) {
+
+	wstring key = L"pack:" + to_wstring(resID);
+	map<wstring, Entry>::iterator found = entries.find(key);
+	if (found != entries.end()) {
+		hits++;
+		return found->second.bitmap;
+	}
+
+	misses++;
+	// Raw entries go from the mapping straight into the DIB section
+	int index = archive.find((uint32_t)resID);
+	PixelImage scratch;
+	const uint32_t* pixels = archive.getPixels(index, scratch);
+	BitMap* bitmap = new BitMap();
+	if (pixels != nullptr) {
+		bitmap->create(hdc, pixels, archive.getWidth(index), archive.getHeight(index));
+	}
+	return store(key, bitmap);
+
+}
+
+shared_ptr<BitMap> AssetCache::find(const wstring& key) {
+
+	return lookup(L"user:" + key);
+
+}
+
+shared_ptr<BitMap> AssetCache::insert(const wstring& key, BitMap* bitmap) {
+
+	return store(L"user:" + key, bitmap);
+
+}
+
+int AssetCache::purge() {
+
+	int dropped = 0;
+	map<wstring, Entry>::iterator entry = entries.begin();
+	while (entry != entries.end()) {
+		if (entry->second.bitmap.use_count() <= 1) {
+			residentBytes -= entry->second.bytes;
+			entry = entries.erase(entry);
+			dropped++;
+		}
+		else {
+			entry++;
+		}
+	}
+	return dropped;
+
+}
+
+void AssetCache::clear() {
+
+	entries.clear();
+	residentBytes = 0;
+
+}
@@ -0,0 +1,55 @@
+#ifndef ASSET_CACHE_H
+#define ASSET_CACHE_H
+
+#include "Windows.h"
+#include <map>
+#include <memory>
+#include <string>
+#include "BitMap.h"
+#include "AssetArchive.h"
+
+// Bitmaps loaded once and shared, keyed by file name or resource ID. The
+// cache holds one reference to each bitmap and callers hold the rest, so
+// a restart that asks for the same files gets the same bitmaps back with
+// no disk I/O. purge() lets go of whatever nobody else is using. Files
+// that fail to load are remembered too, so they aren't retried on every
+// call.
+class AssetCache {
+protected:
+	struct Entry {
+		std::shared_ptr<BitMap> bitmap;
+		size_t bytes;
+	};
+
+	std::map<std::wstring, Entry> entries;
+	unsigned long long hits;
+	unsigned long long misses;
+	size_t residentBytes;
+
+	std::shared_ptr<BitMap> lookup(const std::wstring& key);
+	std::shared_ptr<BitMap> store(const std::wstring& key, BitMap* bitmap);
+
+public:
+	AssetCache();
+	virtual ~AssetCache();
+
+	std::shared_ptr<BitMap> loadBitMap(HDC hdc, const std::wstring& fileName);
+	std::shared_ptr<BitMap> loadBitMap(HDC hdc, UINT resID, HINSTANCE instance);
+	// An image from a packed archive, keyed by its Resource.h ID
+	std::shared_ptr<BitMap> loadBitMap(HDC hdc, const AssetArchive& archive, UINT resID);
+	// Share a bitmap built some other way, e.g. a packed atlas
+	std::shared_ptr<BitMap> find(const std::wstring& key);
+	std::shared_ptr<BitMap> insert(const std::wstring& key, BitMap* bitmap);
+
+	// Drop every bitmap only the cache still holds, returns how many
+	int purge();
+	void clear();
+
+	unsigned long long getHits() { return hits; };
+	unsigned long long getMisses() { return misses; };
+	size_t getResidentBytes() { return residentBytes; };
+	size_t getCount() { return entries.size(); };
+
+};
+
+#endif
@@ -0,0 +1,181 @@
+#include "BatchRunner.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <mutex>
+
+using namespace std;
+
+BatchConfig DefaultBatchConfig(int matches, unsigned int seed) {
+
+	BatchConfig config;
+	config.sim = DefaultSimConfig();
+	config.matches = matches;
+	config.seed = seed;
+	config.maxTicks = 100000;
+	config.threads = 0;
+	config.matchesPerTask = 16;
+	return config;
+
+}
+
+unsigned int MatchSeed(unsigned int batchSeed, unsigned int match) {
+
+	// splitmix64 finaliser, so neighbouring matches get unrelated seeds
+	unsigned long long z = ((unsigned long long)batchSeed << 32 | match) + 0x9e3779b97f4a7c15ULL;
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return (unsigned int)(z ^ (z >> 31));
+
+}
+
+void PlayMatch(GameState& state, const SimConfig& config, const Policy policies[],
+	unsigned int maxTicks) {
+
+	SimStart(state, config);
+	mt19937 rng(config.seed);
+	PLAYERINPUT inputs[MAX_PLAYERS];
+
+	while (!state.over && state.tick < maxTicks) {
+		for (int i = 0; i < state.config.players; i++) {
+			inputs[i] = policies[i](state, i, rng);
+		}
+		SimStep(state, inputs);
+	}
+
+}
+
+static void addMatch(BatchStats& stats, const GameState& state) {
+
+	stats.matches++;
+	stats.ticks += state.tick;
+	if (state.tick < stats.shortest) {
+		stats.shortest = state.tick;
+	}
+	if (state.tick > stats.longest) {
+		stats.longest = state.tick;
+	}
+
+	if (!state.over) {
+		stats.unfinished++;
+	}
+	else if (state.winner < 0) {
+		stats.draws++;
+	}
+	else {
+		stats.wins[state.winner]++;
+	}
+
+}
+
+static void mergeStats(BatchStats& total, const BatchStats& part) {
+
+	total.matches += part.matches;
+	for (int i = 0; i < MAX_PLAYERS; i++) {
+		total.wins[i] += part.wins[i];
+	}
+	total.draws += part.draws;
+	total.unfinished += part.unfinished;
+	total.ticks += part.ticks;
+	if (part.shortest < total.shortest) {
+		total.shortest = part.shortest;
+	}
+	if (part.longest > total.longest) {
+		total.longest = part.longest;
+	}
+
+}
+
+static BatchStats emptyStats() {
+
+	BatchStats stats;
+	stats.matches = 0;
+	for (int i = 0; i < MAX_PLAYERS; i++) {
+		stats.wins[i] = 0;
+	}
+	stats.draws = 0;
+	stats.unfinished = 0;
+	stats.ticks = 0;
+	stats.shortest = ~0u;
+	stats.longest = 0;
+	stats.threads = 0;
+	stats.seconds = 0.0;
+	return stats;
+
+}
+
+BatchStats RunBatch(const BatchConfig& config, const Policy policies[]) {
+
+	BatchStats total = emptyStats();
+	mutex totalLock;
+	int perTask = config.matchesPerTask > 0 ? config.matchesPerTask : 1;
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	{
+		ThreadPool pool(config.threads);
+		total.threads = pool.getThreadCount();
+
+		for (int first = 0; first < config.matches; first += perTask) {
+			int last = first + perTask < config.matches ? first + perTask : config.matches;
+			pool.submit([&, first, last] {
+				BatchStats part = emptyStats();
+				GameState state;
+				SimConfig sim = config.sim;
+				for (int match = first; match < last; match++) {
+					sim.seed = MatchSeed(config.seed, (unsigned int)match);
+					PlayMatch(state, sim, policies, config.maxTicks);
+					addMatch(part, state);
+				}
+				lock_guard<mutex> guard(totalLock);
+				mergeStats(total, part);
+			});
+		}
+
+		pool.wait();
+	}
+	total.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	if (total.matches == 0) {
+		total.shortest = 0;
+	}
+
+	return total;
+
+}
+
+PLAYERINPUT RandomPolicy(const GameState& state, int player, mt19937& rng) {
+
+	const CycleState& cycle = state.cycles[player];
+
+	// Cycles sit still until their first key press
+	if (cycle.speedx == 0 && cycle.speedy == 0) {
+		return DirectionInput(cycle.direction);
+	}
+	if (cycle.changingDirection) {
+		return PI_NONE;
+	}
+
+	int x = cycle.headX(state.config);
+	int y = cycle.headY(state.config);
+	int dx, dy;
+	DirectionDelta(cycle.direction, dx, dy);
+	bool blocked = IsDeadly(state, x + dx, y + dy);
+	if (!blocked && rng() % 32 != 0) {
+		return PI_NONE;
+	}
+
+	DIRECTION sides[2] = { (DIRECTION)((cycle.direction + 1) & 3), (DIRECTION)((cycle.direction + 3) & 3) };
+	if (rng() & 1) {
+		DIRECTION swap = sides[0];
+		sides[0] = sides[1];
+		sides[1] = swap;
+	}
+	for (int i = 0; i < 2; i++) {
+		DirectionDelta(sides[i], dx, dy);
+		if (!IsDeadly(state, x + dx, y + dy)) {
+			return DirectionInput(sides[i]);
+		}
+	}
+
+	return PI_NONE;
+
+}
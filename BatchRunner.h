@@ -0,0 +1,75 @@
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include <functional>
+#include <random>
+#include "Simulation.h"
+#include "CpuPlayer.h"
+
+// Headless self-play: many independent rounds spread over a ThreadPool.
+// Match i always runs with the same seed, whichever thread picks it up, so
+// a batch is reproducible from BatchConfig::seed alone.
+
+// Called once per player per tick to choose that player's input
+typedef std::function<PLAYERINPUT(const GameState& state, int player,
+	std::mt19937& rng)> Policy;
+
+struct BatchConfig {
+	SimConfig sim;
+	int matches;
+	unsigned int seed;
+	unsigned int maxTicks;		// Rounds still running after this many ticks count as unfinished
+	int threads;				// 0 uses every core
+	int matchesPerTask;
+};
+
+struct BatchStats {
+	unsigned long long matches;
+	unsigned long long wins[MAX_PLAYERS];
+	unsigned long long draws;
+	unsigned long long unfinished;
+	unsigned long long ticks;
+	unsigned int shortest;
+	unsigned int longest;
+	int threads;
+	double seconds;
+
+	double averageLength() const { return matches ? (double)ticks / matches : 0.0; };
+	double matchesPerSecond() const { return seconds > 0.0 ? matches / seconds : 0.0; };
+	double matchesPerSecondPerCore() const {
+		return threads > 0 ? matchesPerSecond() / threads : 0.0;
+	};
+};
+
+BatchConfig DefaultBatchConfig(int matches = 1000, unsigned int seed = 1);
+
+// Seed for one match of a batch
+unsigned int MatchSeed(unsigned int batchSeed, unsigned int match);
+
+// Play one round to the end, or to maxTicks. policies[i] drives player i,
+// one for each of config.players.
+void PlayMatch(GameState& state, const SimConfig& config, const Policy policies[],
+	unsigned int maxTicks);
+
+BatchStats RunBatch(const BatchConfig& config, const Policy policies[]);
+
+// Goes straight until blocked or on a random whim, then turns to a free side
+PLAYERINPUT RandomPolicy(const GameState& state, int player, std::mt19937& rng);
+
+// Drives a cycle in the front end with a policy, for filling rounds with
+// more cycles than there are people at the keyboard
+class PolicyPlayer : public CpuPlayer {
+protected:
+	Policy policy;
+	int player;
+	std::mt19937 rng;
+
+public:
+	PolicyPlayer(int player, const Policy& policy, unsigned int seed)
+		: policy(policy), player(player), rng(seed) {};
+
+	virtual PLAYERINPUT chooseInput(const GameState& state) { return policy(state, player, rng); };
+
+};
+
+#endif
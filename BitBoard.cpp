@@ -0,0 +1,387 @@
+#include "BitBoard.h"
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+int PopCount64(uint64_t value) {
+
+#if defined(_MSC_VER) && defined(_M_X64)
+	return (int)__popcnt64(value);
+#elif defined(__GNUC__)
+	return __builtin_popcountll(value);
+#else
+	value = value - ((value >> 1) & 0x5555555555555555ULL);
+	value = (value & 0x3333333333333333ULL) + ((value >> 2) & 0x3333333333333333ULL);
+	value = (value + (value >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+	return (int)((value * 0x0101010101010101ULL) >> 56);
+#endif
+
+}
+
+BitBoard::BitBoard() {
+
+	width = 0;
+	height = 0;
+	wordsPerRow = 0;
+	lastWordMask = 0;
+
+}
+
+BitBoard::BitBoard(int w, int h) {
+
+	width = 0;
+	height = 0;
+	wordsPerRow = 0;
+	lastWordMask = 0;
+
+	resize(w, h);
+
+}
+
+void BitBoard::resize(int w, int h) {
+
+	width = w > 0 ? w : 0;
+	height = h > 0 ? h : 0;
+	wordsPerRow = (width + 63) / 64;
+	lastWordMask = (width & 63) ? (uint64_t(1) << (width & 63)) - 1 : ~uint64_t(0);
+
+	words.assign((size_t)wordsPerRow * height, 0);
+
+}
+
+void BitBoard::clear() {
+
+	if (!words.empty()) {
+		memset(words.data(), 0, words.size() * sizeof(uint64_t));
+	}
+
+}
+
+void BitBoard::fill() {
+
+	for (int y = 0; y < height; y++) {
+		uint64_t* row = &words[y * wordsPerRow];
+		for (int i = 0; i < wordsPerRow; i++) {
+			row[i] = ~uint64_t(0);
+		}
+		row[wordsPerRow - 1] = lastWordMask;
+	}
+
+}
+
+void BitBoard::copyFrom(const BitBoard& other) {
+
+	if (other.width != width || other.height != height) {
+		resize(other.width, other.height);
+	}
+
+	if (!words.empty()) {
+		memcpy(words.data(), other.words.data(), words.size() * sizeof(uint64_t));
+	}
+
+}
+
+int BitBoard::popcount() const {
+
+	int count = 0;
+	size_t size = words.size();
+	for (size_t i = 0; i < size; i++) {
+		count += PopCount64(words[i]);
+	}
+	return count;
+
+}
+
+void BitBoard::orWith(const BitBoard& other) {
+
+	size_t size = words.size();
+	for (size_t i = 0; i < size; i++) {
+		words[i] |= other.words[i];
+	}
+
+}
+
+void BitBoard::andWith(const BitBoard& other) {
+
+	size_t size = words.size();
+	for (size_t i = 0; i < size; i++) {
+		words[i] &= other.words[i];
+	}
+
+}
+
+void BitBoard::andNot(const BitBoard& other) {
+
+	size_t size = words.size();
+	for (size_t i = 0; i < size; i++) {
+		words[i] &= ~other.words[i];
+	}
+
+}
+
+bool BitBoard::equals(const BitBoard& other) const {
+
+	return width == other.width && height == other.height &&
+		(words.empty() || memcmp(words.data(), other.words.data(),
+			words.size() * sizeof(uint64_t)) == 0);
+
+}
+
+bool BitBoard::dilate(const BitBoard& blocked, BitBoard& out) const {
+
+	if (out.width != width || out.height != height) {
+		out.resize(width, height);
+	}
+
+	uint64_t changed = 0;
+	for (int y = 0; y < height; y++) {
+		const uint64_t* row = &words[y * wordsPerRow];
+		const uint64_t* above = y > 0 ? row - wordsPerRow : row;
+		const uint64_t* below = y < height - 1 ? row + wordsPerRow : row;
+		const uint64_t* walls = &blocked.words[y * wordsPerRow];
+		uint64_t* dest = &out.words[y * wordsPerRow];
+
+		for (int i = 0; i < wordsPerRow; i++) {
+			uint64_t carryIn = i > 0 ? row[i - 1] >> 63 : 0;
+			uint64_t carryOut = i < wordsPerRow - 1 ? row[i + 1] << 63 : 0;
+			uint64_t grown = row[i] | (row[i] << 1) | carryIn | (row[i] >> 1) | carryOut |
+				above[i] | below[i];
+			grown &= ~walls[i];
+			grown |= row[i];
+			if (i == wordsPerRow - 1) {
+				grown &= lastWordMask;
+			}
+			changed |= grown ^ row[i];
+			dest[i] = grown;
+		}
+	}
+
+	return changed != 0;
+
+}
+
+int BitBoard::floodFill(int x, int y, const BitBoard& blocked, BitBoard& reach,
+	BitBoard& scratch) const {
+
+	reach.resize(width, height);
+	scratch.resize(width, height);
+
+	if (x < 0 || y < 0 || x >= width || y >= height) {
+		return 0;
+	}
+
+	reach.set(x, y);
+
+	// Ping-pong between the two boards until the region stops growing
+	BitBoard* from = &reach;
+	BitBoard* to = &scratch;
+	while (from->dilate(blocked, *to)) {
+		BitBoard* swap = from;
+		from = to;
+		to = swap;
+	}
+	if (from != &reach) {
+		reach.copyFrom(*from);
+	}
+
+	return reach.popcount();
+
+}
+
+void ArenaBoard::copyFrom(const ArenaBoard& other) {
+
+	blocked.copyFrom(other.blocked);
+	for (int i = 0; i < BOARD_PLAYERS; i++) {
+		cycles[i] = other.cycles[i];
+	}
+	turnDelay = other.turnDelay;
+
+}
+
+void BoardFromState(ArenaBoard& board, const GameState& state) {
+
+	BoardFromState(board, state, 0, 0, state.arena.getWidth(), state.arena.getHeight());
+
+}
+
+void BoardFromState(ArenaBoard& board, const GameState& state, int left, int top, int width, int height) {
+
+	const SimConfig& config = state.config;
+	const OccupancyGrid& arena = state.arena;
+
+	if (board.blocked.getWidth() != width || board.blocked.getHeight() != height) {
+		board.blocked.resize(width, height);
+	}
+	int wordsPerRow = board.blocked.getWordsPerRow();
+	if (height > 0) {
+		uint64_t* words = board.blocked.getWords();
+		arena.copyTo(words, wordsPerRow, left, top, height);
+		// The last word can run past the window into the arena beyond it
+		if (width & 63) {
+			uint64_t lastWordMask = (uint64_t(1) << (width & 63)) - 1;
+			for (int y = 0; y < height; y++) {
+				words[(size_t)y * wordsPerRow + wordsPerRow - 1] &= lastWordMask;
+			}
+		}
+	}
+
+	// A centre this close to an edge means the bitmap touches the window edge
+	int edgeLeft = config.cycleWidth / 2 - left;
+	int edgeRight = config.width - config.cycleWidth + config.cycleWidth / 2 - left;
+	int edgeTop = config.cycleHeight / 2 - top;
+	int edgeBottom = config.height - config.cycleHeight + config.cycleHeight / 2 - top;
+	for (int y = 0; y < height; y++) {
+		if (y <= edgeTop || y >= edgeBottom || y == 0 || y == height - 1) {
+			for (int x = 0; x < width; x++) {
+				board.blocked.set(x, y);
+			}
+			continue;
+		}
+		for (int x = 0; x <= edgeLeft || x == 0; x++) {
+			board.blocked.set(x, y);
+		}
+		for (int x = edgeRight < width - 1 ? edgeRight : width - 1; x < width; x++) {
+			board.blocked.set(x, y);
+		}
+	}
+
+	// Every head blocks, whether or not the board follows its cycle
+	for (int i = 0; i < config.players; i++) {
+		const CycleState& cycle = state.cycles[i];
+		board.blocked.set(cycle.headX(config) - left, cycle.headY(config) - top);
+	}
+	for (int i = 0; i < BOARD_PLAYERS; i++) {
+		const CycleState& cycle = state.cycles[i];
+		BoardCycle& head = board.cycles[i];
+		head.x = cycle.headX(config) - left;
+		head.y = cycle.headY(config) - top;
+		head.direction = cycle.direction;
+		head.alive = cycle.alive && head.x >= 0 && head.y >= 0 && head.x < width && head.y < height;
+		head.cooldown = cycle.changingDirection ?
+			config.directionChangeDelay - cycle.directionChangeCounter : 0;
+	}
+	board.turnDelay = config.directionChangeDelay;
+
+}
+
+void StateFromBoard(GameState& state, const ArenaBoard& board) {
+
+	const SimConfig& config = state.config;
+	OccupancyGrid& arena = state.arena;
+	state.config.players = BOARD_PLAYERS;
+
+	if (arena.getWidth() != board.blocked.getWidth() ||
+		arena.getHeight() != board.blocked.getHeight()) {
+		arena.resize(board.blocked.getWidth(), board.blocked.getHeight());
+	}
+	if (arena.getHeight() > 0) {
+		arena.copyFrom(board.blocked.getWords(), board.blocked.getWordsPerRow());
+	}
+
+	int alive = 0;
+	int survivor = -1;
+	for (int i = 0; i < BOARD_PLAYERS; i++) {
+		const BoardCycle& head = board.cycles[i];
+		CycleState& cycle = state.cycles[i];
+		cycle.xPos = head.x - config.cycleWidth / 2;
+		cycle.yPos = head.y - config.cycleHeight / 2;
+		cycle.direction = head.direction;
+		cycle.alive = head.alive;
+		DirectionDelta(head.direction, cycle.speedx, cycle.speedy);
+		if (!head.alive) {
+			cycle.speedx = 0;
+			cycle.speedy = 0;
+		}
+		cycle.changingDirection = head.cooldown > 0;
+		cycle.directionChangeCounter = head.cooldown > 0 ? board.turnDelay - head.cooldown : 0;
+		cycle.trail.clear();
+		cycle.trail.append(head.x, head.y);
+		if (head.alive) {
+			alive++;
+			survivor = i;
+		}
+	}
+
+	state.over = alive <= 1;
+	state.winner = alive == 1 ? survivor : -1;
+
+}
+
+int LegalMoves(const ArenaBoard& board, int player, DIRECTION moves[3]) {
+
+	const BoardCycle& head = board.cycles[player];
+	int count = 0;
+
+	if (!head.alive) {
+		return 0;
+	}
+
+	for (int turn = 0; turn < 4; turn++) {
+		// Turning back onto the trail is never legal, nor is turning too soon
+		if (turn == 2 || (turn != 0 && head.cooldown > 0)) {
+			continue;
+		}
+		DIRECTION direction = (DIRECTION)((head.direction + turn) & 3);
+		int dx, dy;
+		DirectionDelta(direction, dx, dy);
+		if (!board.blocked.get(head.x + dx, head.y + dy) &&
+			head.x + dx >= 0 && head.y + dy >= 0 &&
+			head.x + dx < board.blocked.getWidth() && head.y + dy < board.blocked.getHeight()) {
+			moves[count++] = direction;
+		}
+	}
+
+	return count;
+
+}
+
+void ApplyMoves(ArenaBoard& board, const DIRECTION moves[BOARD_PLAYERS]) {
+
+	int nextX[BOARD_PLAYERS], nextY[BOARD_PLAYERS];
+	bool crashed[BOARD_PLAYERS];
+
+	for (int i = 0; i < BOARD_PLAYERS; i++) {
+		BoardCycle& head = board.cycles[i];
+		crashed[i] = false;
+		if (!head.alive) {
+			continue;
+		}
+		int dx, dy;
+		DirectionDelta(moves[i], dx, dy);
+		if (moves[i] != head.direction) {
+			head.direction = moves[i];
+			head.cooldown = board.turnDelay;
+		}
+		if (head.cooldown > 0) {
+			head.cooldown--;
+		}
+		nextX[i] = head.x + dx;
+		nextY[i] = head.y + dy;
+		crashed[i] = nextX[i] < 0 || nextY[i] < 0 ||
+			nextX[i] >= board.blocked.getWidth() || nextY[i] >= board.blocked.getHeight() ||
+			board.blocked.get(nextX[i], nextY[i]);
+		for (int j = 0; j < i; j++) {
+			if (board.cycles[j].alive && nextX[j] == nextX[i] && nextY[j] == nextY[i]) {
+				crashed[i] = crashed[j] = true;
+			}
+		}
+	}
+
+	for (int i = 0; i < BOARD_PLAYERS; i++) {
+		BoardCycle& head = board.cycles[i];
+		if (!head.alive) {
+			continue;
+		}
+		head.x = nextX[i];
+		head.y = nextY[i];
+		board.blocked.set(head.x, head.y);
+		if (crashed[i]) {
+			head.alive = false;
+		}
+	}
+
+}
@@ -0,0 +1,132 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <vector>
+#include <cstdint>
+#include "Simulation.h"
+
+// Fixed-size bit set over the arena, in the plain row layout that
+// OccupancyGrid::copyTo() and copyFrom() convert to and from (rows padded
+// to whole 64-bit words). Unlike the arena it is dense, so it is meant
+// for arenas about the size of a window. The
+// whole-board operations are plain loops over words that the compiler
+// can vectorise.
+class BitBoard {
+protected:
+	int width, height;
+	int wordsPerRow;
+	uint64_t lastWordMask;		// Valid bits of the last word in each row
+	std::vector<uint64_t> words;
+
+public:
+	BitBoard();
+	BitBoard(int w, int h);
+
+	void resize(int w, int h);
+	void clear();
+	void fill();
+
+	// Copies without allocating when both boards are the same size
+	void copyFrom(const BitBoard& other);
+
+	bool get(int x, int y) const {
+
+		if (x < 0 || y < 0 || x >= width || y >= height) {
+
+			return false;
+
+		}
+
+		return (words[y * wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+
+	};
+
+	void set(int x, int y) {
+
+		if (x < 0 || y < 0 || x >= width || y >= height) {
+
+			return;
+
+		}
+
+		words[y * wordsPerRow + (x >> 6)] |= uint64_t(1) << (x & 63);
+
+	};
+
+	void reset(int x, int y) {
+
+		if (x < 0 || y < 0 || x >= width || y >= height) {
+
+			return;
+
+		}
+
+		words[y * wordsPerRow + (x >> 6)] &= ~(uint64_t(1) << (x & 63));
+
+	};
+
+	int popcount() const;
+	void orWith(const BitBoard& other);
+	void andWith(const BitBoard& other);
+	void andNot(const BitBoard& other);
+	bool equals(const BitBoard& other) const;
+
+	// out = this plus its four neighbours, minus blocked. Returns whether
+	// out differs from this.
+	bool dilate(const BitBoard& blocked, BitBoard& out) const;
+
+	// Cells reachable from x, y without crossing blocked, written to reach.
+	// Returns how many there are.
+	int floodFill(int x, int y, const BitBoard& blocked, BitBoard& reach,
+		BitBoard& scratch) const;
+
+	int getWidth() const { return width; };
+	int getHeight() const { return height; };
+	int getWordsPerRow() const { return wordsPerRow; };
+	uint64_t* getWords() { return words.data(); };
+	const uint64_t* getWords() const { return words.data(); };
+
+};
+
+int PopCount64(uint64_t value);
+
+// A whole position for search: one blocked bit per cell plus each
+// cycle's head and heading. Moves are one cell per ply. Searches are
+// duels between blue and orange; any further cycles in the round are
+// only their trails and heads in the blocked bits.
+const int BOARD_PLAYERS = 2;
+
+struct BoardCycle {
+	int x, y;
+	DIRECTION direction;
+	bool alive;
+	int cooldown;				// Plies before the cycle may turn again
+};
+
+struct ArenaBoard {
+	BitBoard blocked;			// Trails plus the edge band a cycle centre can't enter
+	BoardCycle cycles[BOARD_PLAYERS];
+	int turnDelay;				// SimConfig::directionChangeDelay
+
+	void copyFrom(const ArenaBoard& other);
+};
+
+void BoardFromState(ArenaBoard& board, const GameState& state);
+// Only the window from (left, top) of width x height pixels, with left a
+// multiple of 64, so large arenas cost what the window does. The ring of
+// cells round the window is blocked like the arena edge, coordinates are
+// relative to the window and a cycle outside it is left for dead.
+void BoardFromState(ArenaBoard& board, const GameState& state, int left, int top, int width, int height);
+
+// Writes the board back into a live state. Trail histories can't be
+// recovered from bits, so each trail restarts at its cycle's head. The
+// state becomes a two-player round.
+void StateFromBoard(GameState& state, const ArenaBoard& board);
+
+// Directions a cycle can take next without crashing, never reversing
+int LegalMoves(const ArenaBoard& board, int player, DIRECTION moves[3]);
+
+// Move every live cycle one cell at once
+void ApplyMoves(ArenaBoard& board, const DIRECTION moves[BOARD_PLAYERS]);
+
+#endif
@@ -4,45 +4,13 @@ using namespace std;
 
 bool BitMap::create(HDC hdc, wstring fileName) {
 	free();
-	HANDLE hfile = CreateFile(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ,
-		NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-	if (hfile == INVALID_HANDLE_VALUE) {
+	// The file is mapped and validated in place, its pixels are copied
+	// once, straight into the DIB section
+	BmpFile file;
+	if (!file.open(fileName)) {
 		return false;
 	}
-	BITMAPFILEHEADER bmfh;
-	DWORD dwBytesRead;
-	bool bok = ReadFile(hfile, &bmfh, sizeof(BITMAPFILEHEADER),
-		&dwBytesRead, NULL);
-	if (!bok || (dwBytesRead != sizeof(BITMAPFILEHEADER)) ||
-		bmfh.bfType != 0x4d42) {
-		CloseHandle(hfile);
-		return false;
-	}
-	BITMAPINFO* info = new BITMAPINFO;
-	if (info != NULL) {
-		bok = ReadFile(hfile, info, sizeof(BITMAPINFO),
-			&dwBytesRead, NULL);
-		if (!bok || dwBytesRead != sizeof(BITMAPINFO)) {
-			CloseHandle(hfile);
-			free();
-			return false;
-		}
-		width = (int)(info->bmiHeader.biWidth);
-		height = (int)(info->bmiHeader.biHeight);
-		PBYTE bitmapBits;
-		hbitmap = CreateDIBSection(hdc, info, DIB_RGB_COLORS,
-			(PVOID*)(&bitmapBits), NULL, 0);
-		if (hbitmap != NULL && bitmapBits != NULL) {
-			SetFilePointer(hfile, bmfh.bfOffBits, NULL, FILE_BEGIN);
-			bok = ReadFile(hfile, bitmapBits, info->bmiHeader.biSizeImage,
-				&dwBytesRead, NULL);
-			if (bok) {
-				return true;
-			}
-		}
-	}
-	free();
-	return false;
+	return create(hdc, file.getView());
 }
 
 bool BitMap::create(HDC hdc, UINT resID, HINSTANCE hinstance) {
@@ -56,29 +24,40 @@ bool BitMap::create(HDC hdc, UINT resID, HINSTANCE hinstance) {
 	if (memBitMap == NULL) {
 		return false;
 	}
-	PBYTE bitMapImage = (BYTE*)LockResource(memBitMap);
-	if (bitMapImage == NULL) {
-		FreeResource(memBitMap);
+	// Resources hold a packed DIB, the pixels come after the header,
+	// any bit field masks and the palette
+	BmpView view;
+	const BYTE* bitMapImage = (const BYTE*)LockResource(memBitMap);
+	if (bitMapImage == NULL ||
+		!view.parseDib(bitMapImage, SizeofResource(hinstance, resinfo))) {
 		return false;
 	}
-	BITMAPINFO* info = (BITMAPINFO*)bitMapImage;
-	width = info->bmiHeader.biWidth;
-	height = info->bmiHeader.biHeight;
-	PBYTE bitMapBits;
-	hbitmap = CreateDIBSection(hdc, info, DIB_RGB_COLORS,
+	return create(hdc, view);
+}
+
+bool BitMap::create(HDC hdc, const BmpView& view) {
+	free();
+	BITMAPINFO info;
+	ZeroMemory(&info, sizeof(info));
+	info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+	info.bmiHeader.biWidth = view.getWidth();
+	info.bmiHeader.biHeight = view.isTopDown() ? -view.getHeight() : view.getHeight();
+	info.bmiHeader.biPlanes = 1;
+	info.bmiHeader.biBitCount = (WORD)view.getBitsPerPixel();
+	info.bmiHeader.biCompression = BI_RGB;
+	info.bmiHeader.biSizeImage = (DWORD)view.getPixelBytes();
+	PBYTE bitMapBits = NULL;
+	hbitmap = CreateDIBSection(hdc, &info, DIB_RGB_COLORS,
 		(PVOID*)&bitMapBits, NULL, 0);
-	if (hbitmap != NULL && bitMapBits != NULL) {
-		const PBYTE TEMPBITS = bitMapImage + info->bmiHeader.biSize
-			+ info->bmiHeader.biClrUsed + sizeof(RGBQUAD);
-		CopyMemory(bitMapBits, TEMPBITS, info->bmiHeader.biSizeImage);
-		UnlockResource(memBitMap);
-		FreeResource(memBitMap);
-		return true;
+	if (hbitmap == NULL || bitMapBits == NULL) {
+		free();
+		return false;
 	}
-	UnlockResource(memBitMap);
-	FreeResource(memBitMap);
-	free();
-	return false;
+	// Same row order and stride as the source, so one straight copy
+	CopyMemory(bitMapBits, view.getPixels(), view.getPixelBytes());
+	width = view.getWidth();
+	height = view.getHeight();
+	return true;
 }
 
 bool BitMap::create(HDC hdc, int w, int h, COLORREF color) {
@@ -168,10 +147,91 @@ void BitMap::free() {
 
 }
 
-void BitMap::draw(HDC hdc, int x, int y, bool btrans, COLORREF ctrans) {
+bool BitMap::create(HDC hdc, const PixelImage& image) {
+	return create(hdc, image.pixels.data(), image.width, image.height);
+}
+
+bool BitMap::create(HDC hdc, const uint32_t* pixels, int w, int h) {
+	free();
+	if (pixels == NULL || w <= 0 || h <= 0) {
+		return false;
+	}
+	BITMAPINFO info;
+	ZeroMemory(&info, sizeof(info));
+	info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+	info.bmiHeader.biWidth = w;
+	info.bmiHeader.biHeight = -h;	// Top-down, the framebuffer layout
+	info.bmiHeader.biPlanes = 1;
+	info.bmiHeader.biBitCount = 32;
+	info.bmiHeader.biCompression = BI_RGB;
+	PBYTE bitMapBits = NULL;
+	hbitmap = CreateDIBSection(hdc, &info, DIB_RGB_COLORS,
+		(PVOID*)&bitMapBits, NULL, 0);
+	if (hbitmap == NULL || bitMapBits == NULL) {
+		free();
+		return false;
+	}
+	CopyMemory(bitMapBits, pixels, (size_t)w * h * sizeof(uint32_t));
+	width = w;
+	height = h;
+	return true;
+}
+
+size_t BitMap::getBytes() {
+
+	BITMAP info;
+
+	if (hbitmap == NULL || GetObject(hbitmap, sizeof(BITMAP), &info) == 0) {
+
+		return 0;
+
+	}
+
+	return (size_t)info.bmWidthBytes * info.bmHeight;
+
+}
+
+bool BitMap::getPixels(HDC hdc, PixelImage& image) {
 
 	if (hbitmap == NULL) {
 
+		return false;
+
+	}
+
+	int rows = height < 0 ? -height : height;
+	BITMAPINFO info;
+	ZeroMemory(&info, sizeof(info));
+	info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+	info.bmiHeader.biWidth = width;
+	info.bmiHeader.biHeight = -rows;	// Top-down, the framebuffer layout
+	info.bmiHeader.biPlanes = 1;
+	info.bmiHeader.biBitCount = 32;
+	info.bmiHeader.biCompression = BI_RGB;
+
+	image.resize(width, rows);
+
+	return GetDIBits(hdc, hbitmap, 0, rows, image.pixels.data(), &info,
+		DIB_RGB_COLORS) == rows;
+
+}
+
+void BitMap::draw(HDC hdc, int x, int y, bool btrans, COLORREF ctrans) {
+
+	RECT source = { 0, 0, width, height };
+
+	draw(hdc, x, y, source, btrans, ctrans);
+
+}
+
+void BitMap::draw(HDC hdc, int x, int y, const RECT& source, bool btrans,
+	COLORREF ctrans) {
+
+	int w = source.right - source.left;
+	int h = source.bottom - source.top;
+
+	if (hbitmap == NULL || w <= 0 || h <= 0) {
+
 		return;
 
 	}
@@ -182,17 +242,17 @@ void BitMap::draw(HDC hdc, int x, int y, bool btrans, COLORREF ctrans) {
 
 	if (btrans) {
 
-		TransparentBlt(hdc, x, y, width, height, memDC, 0, 0,
-			width, height, ctrans);
+		TransparentBlt(hdc, x, y, w, h, memDC, source.left, source.top,
+			w, h, ctrans);
 
 	}
 	else {
 
-		BitBlt(hdc, x, y, width, height, memDC, 0, 0, SRCCOPY);
+		BitBlt(hdc, x, y, w, h, memDC, source.left, source.top, SRCCOPY);
 
 	}
 
-	DeleteObject(oldBitMap);
+	SelectObject(memDC, oldBitMap);
 	DeleteDC(memDC);
 
 }
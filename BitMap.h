@@ -3,6 +3,7 @@
 
 #include "Windows.h"
 #include <string>
+#include "BmpImage.h"
 
 class BitMap {
 protected:
@@ -18,8 +19,20 @@ public:
 	bool create(HDC, std::wstring);
 	bool create(HDC, UINT, HINSTANCE);
 	bool create(HDC, int, int, COLORREF);
+	bool create(HDC, const BmpView&);
+	bool create(HDC, const PixelImage&);
+	// 0x00RRGGBB pixels, top row first
+	bool create(HDC, const uint32_t*, int, int);
 	void draw(HDC, int, int, bool btrans = false, 
 		COLORREF ctrans = RGB(255, 0, 255));
+	// Draw only the source rectangle, e.g. one frame of a sprite sheet
+	void draw(HDC, int, int, const RECT&, bool btrans = false,
+		COLORREF ctrans = RGB(255, 0, 255));
+	// Copy the pixels out for the software renderer
+	bool getPixels(HDC, PixelImage&);
+	bool isLoaded() { return hbitmap != NULL; };
+	// Pixel memory held by the bitmap
+	size_t getBytes();
 	int getWidth() { return width; };
 	int getHeight() { return height; };
 };
@@ -0,0 +1,269 @@
+#include "BmpImage.h"
+#include <fstream>
+
+using namespace std;
+
+static const size_t FILE_HEADER_BYTES = 14;
+static const size_t INFO_HEADER_BYTES = 40;
+static const int MAX_DIMENSION = 1 << 15;
+
+static const uint32_t COMPRESSION_RGB = 0,
+					  COMPRESSION_BITFIELDS = 3;
+
+// Headers are little-endian and not necessarily aligned
+static uint16_t readU16(const uint8_t* p) {
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t readU32(const uint8_t* p) {
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void writeU16(uint8_t* p, uint16_t value) {
+	p[0] = (uint8_t)value;
+	p[1] = (uint8_t)(value >> 8);
+}
+
+static void writeU32(uint8_t* p, uint32_t value) {
+	for (int i = 0; i < 4; i++) {
+		p[i] = (uint8_t)(value >> (i * 8));
+	}
+}
+
+BmpView::BmpView() {
+
+	pixels = nullptr;
+	width = 0;
+	height = 0;
+	bitsPerPixel = 0;
+	topDown = false;
+	stride = 0;
+	error = "Not loaded";
+
+}
+
+bool BmpView::fail(const char* message) {
+
+	pixels = nullptr;
+	width = 0;
+	height = 0;
+	stride = 0;
+	error = message;
+	return false;
+
+}
+
+bool BmpView::parseInfo(const uint8_t* info, size_t available, size_t& headerBytes) {
+
+	if (available < INFO_HEADER_BYTES) {
+		return fail("Truncated BITMAPINFOHEADER");
+	}
+
+	uint32_t infoSize = readU32(info);
+	int32_t infoWidth = (int32_t)readU32(info + 4);
+	int32_t infoHeight = (int32_t)readU32(info + 8);
+	uint16_t planes = readU16(info + 12);
+	uint16_t bitCount = readU16(info + 14);
+	uint32_t compression = readU32(info + 16);
+	uint32_t colorsUsed = readU32(info + 32);
+
+	// Core headers (12 bytes) predate 32-bit sizes and aren't supported
+	if (infoSize < INFO_HEADER_BYTES || infoSize > available) {
+		return fail("Bad BITMAPINFOHEADER size");
+	}
+	if (planes != 1) {
+		return fail("Bad plane count");
+	}
+	if (bitCount != 24 && bitCount != 32) {
+		return fail("Only 24 and 32-bit bitmaps are supported");
+	}
+	if (infoWidth <= 0 || infoWidth > MAX_DIMENSION ||
+		infoHeight == 0 || infoHeight < -MAX_DIMENSION || infoHeight > MAX_DIMENSION) {
+		return fail("Bad bitmap dimensions");
+	}
+
+	headerBytes = infoSize;
+	if (compression == COMPRESSION_BITFIELDS) {
+		// Masks live inside V4/V5 headers and right after a plain one
+		if (bitCount != 32) {
+			return fail("Bit fields need 32 bits per pixel");
+		}
+		const uint8_t* masks = info + INFO_HEADER_BYTES;
+		if (infoSize == INFO_HEADER_BYTES) {
+			if (available < INFO_HEADER_BYTES + 12) {
+				return fail("Truncated bit field masks");
+			}
+			headerBytes += 12;
+		}
+		else if (infoSize < INFO_HEADER_BYTES + 12) {
+			return fail("Bad BITMAPINFOHEADER size");
+		}
+		if (readU32(masks) != 0x00ff0000 || readU32(masks + 4) != 0x0000ff00 ||
+			readU32(masks + 8) != 0x000000ff) {
+			return fail("Only 8-8-8 bit field masks are supported");
+		}
+	}
+	else if (compression != COMPRESSION_RGB) {
+		return fail("Compressed bitmaps are not supported");
+	}
+
+	// An optional palette may sit between the header and the pixels
+	if (colorsUsed > 256) {
+		return fail("Bad palette size");
+	}
+	headerBytes += (size_t)colorsUsed * 4;
+
+	width = infoWidth;
+	height = infoHeight < 0 ? -infoHeight : infoHeight;
+	topDown = infoHeight < 0;
+	bitsPerPixel = bitCount;
+	// Rows are padded to a multiple of four bytes
+	stride = (((size_t)width * bitCount + 31) / 32) * 4;
+	return true;
+
+}
+
+bool BmpView::parse(const uint8_t* data, size_t size) {
+
+	if (data == nullptr || size < FILE_HEADER_BYTES) {
+		return fail("Truncated BITMAPFILEHEADER");
+	}
+	if (data[0] != 'B' || data[1] != 'M') {
+		return fail("Not a bitmap file");
+	}
+
+	size_t headerBytes;
+	if (!parseInfo(data + FILE_HEADER_BYTES, size - FILE_HEADER_BYTES, headerBytes)) {
+		return false;
+	}
+
+	// Trust the stated pixel offset only if it clears the headers
+	size_t offset = readU32(data + 10);
+	if (offset < FILE_HEADER_BYTES + headerBytes || offset > size) {
+		return fail("Bad pixel data offset");
+	}
+	if ((size - offset) / stride < (size_t)height) {
+		return fail("Truncated pixel data");
+	}
+
+	pixels = data + offset;
+	error = nullptr;
+	return true;
+
+}
+
+bool BmpView::parseDib(const uint8_t* data, size_t size) {
+
+	if (data == nullptr) {
+		return fail("Truncated BITMAPINFOHEADER");
+	}
+
+	size_t headerBytes;
+	if (!parseInfo(data, size, headerBytes)) {
+		return false;
+	}
+
+	// Pixels follow the header, any bit field masks and the palette
+	if (headerBytes > size || (size - headerBytes) / stride < (size_t)height) {
+		return fail("Truncated pixel data");
+	}
+
+	pixels = data + headerBytes;
+	error = nullptr;
+	return true;
+
+}
+
+void BmpView::toPixelImage(PixelImage& image) const {
+
+	image.resize(width, height);
+	for (int y = 0; y < height; y++) {
+		const uint8_t* src = row(y);
+		uint32_t* dst = &image.pixels[(size_t)y * width];
+		if (bitsPerPixel == 32) {
+			for (int x = 0; x < width; x++) {
+				dst[x] = readU32(src + x * 4) & 0x00ffffff;
+			}
+		}
+		else {
+			for (int x = 0; x < width; x++) {
+				const uint8_t* bgr = src + x * 3;
+				dst[x] = ((uint32_t)bgr[2] << 16) | ((uint32_t)bgr[1] << 8) | bgr[0];
+			}
+		}
+	}
+
+}
+
+bool SaveBmp(const string& fileName, const PixelImage& image) {
+
+	if (image.width <= 0 || image.height <= 0 || image.width > MAX_DIMENSION ||
+		image.height > MAX_DIMENSION || image.pixels.size() != (size_t)image.width * image.height) {
+		return false;
+	}
+
+	// The largest images allowed have more bytes than the 32-bit size fields hold
+	uint8_t header[FILE_HEADER_BYTES + INFO_HEADER_BYTES] = {};
+	size_t pixelBytes = (size_t)image.width * image.height * 4;
+	if (pixelBytes > UINT32_MAX - sizeof(header)) {
+		return false;
+	}
+	header[0] = 'B';
+	header[1] = 'M';
+	writeU32(header + 2, (uint32_t)(sizeof(header) + pixelBytes));
+	writeU32(header + 10, (uint32_t)sizeof(header));
+	uint8_t* info = header + FILE_HEADER_BYTES;
+	writeU32(info, INFO_HEADER_BYTES);
+	writeU32(info + 4, (uint32_t)image.width);
+	writeU32(info + 8, (uint32_t)-image.height);
+	writeU16(info + 12, 1);
+	writeU16(info + 14, 32);
+	writeU32(info + 16, COMPRESSION_RGB);
+	writeU32(info + 20, (uint32_t)pixelBytes);
+
+	// 32-bit rows need no padding, each pixel is stored as B, G, R, 0
+	vector<uint8_t> data(header, header + sizeof(header));
+	data.resize(sizeof(header) + pixelBytes);
+	for (size_t i = 0; i < image.pixels.size(); i++) {
+		writeU32(&data[sizeof(header) + i * 4], image.pixels[i] & 0x00ffffff);
+	}
+
+	ofstream file(fileName.c_str(), ios::binary | ios::trunc);
+	file.write((const char*)data.data(), data.size());
+	return (bool)file;
+
+}
+
+BmpFile::BmpFile() {
+
+	error = nullptr;
+
+}
+
+bool BmpFile::open(const string& fileName) {
+
+	error = nullptr;
+	if (!file.open(fileName)) {
+		view = BmpView();
+		error = "Could not open file";
+		return false;
+	}
+	return view.parse(file.data(), file.size());
+
+}
+
+#ifdef _WIN32
+
+bool BmpFile::open(const wstring& fileName) {
+
+	error = nullptr;
+	if (!file.open(fileName)) {
+		view = BmpView();
+		error = "Could not open file";
+		return false;
+	}
+	return view.parse(file.data(), file.size());
+
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef BMP_IMAGE_H
+#define BMP_IMAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Framebuffer.h"
+#include "MappedFile.h"
+
+// Validated view of uncompressed 24 or 32-bit BMP data, bottom-up or
+// top-down. Nothing is copied: rows point straight into the bytes given
+// to parse(), so they must outlive the view. Every header field is
+// checked against the size of the data before it is trusted, including
+// the pixel offset and the row stride, and biSizeImage is ignored.
+class BmpView {
+protected:
+	const uint8_t* pixels;
+	int width;
+	int height;
+	int bitsPerPixel;
+	bool topDown;
+	size_t stride;
+	const char* error;
+
+	bool parseInfo(const uint8_t* info, size_t available, size_t& headerBytes);
+	bool fail(const char* message);
+
+public:
+	BmpView();
+
+	// A whole .bmp file, BITMAPFILEHEADER first
+	bool parse(const uint8_t* data, size_t size);
+	// A packed DIB as stored in RT_BITMAP resources, BITMAPINFOHEADER first
+	bool parseDib(const uint8_t* data, size_t size);
+
+	// Row y counted from the top of the image, whatever the storage order
+	const uint8_t* row(int y) const {
+		return pixels + (size_t)(topDown ? y : height - 1 - y) * stride;
+	};
+	// The rows in storage order, getStride() bytes apart
+	const uint8_t* getPixels() const { return pixels; };
+	int getWidth() const { return width; };
+	int getHeight() const { return height; };
+	int getBitsPerPixel() const { return bitsPerPixel; };
+	bool isTopDown() const { return topDown; };
+	size_t getStride() const { return stride; };
+	size_t getPixelBytes() const { return stride * height; };
+	const char* getError() const { return error; };
+
+	// Convert to 0x00RRGGBB pixels for the software renderer
+	void toPixelImage(PixelImage& image) const;
+
+};
+
+// Write 0x00RRGGBB pixels as a 32-bit top-down BMP
+bool SaveBmp(const std::string& fileName, const PixelImage& image);
+
+// A memory-mapped .bmp file and its view
+class BmpFile {
+protected:
+	MappedFile file;
+	BmpView view;
+	const char* error;
+
+public:
+	BmpFile();
+
+	bool open(const std::string& fileName);
+#ifdef _WIN32
+	bool open(const std::wstring& fileName);
+#endif
+
+	const BmpView& getView() const { return view; };
+	const char* getError() const { return error != nullptr ? error : view.getError(); };
+
+};
+
+#endif
@@ -0,0 +1,66 @@
+#include "Camera.h"
+
+using namespace std;
+
+static int clampTo(int value, int low, int high) {
+
+	return value < low ? low : (value > high ? high : value);
+
+}
+
+Camera::Camera(int width, int height) {
+
+	x = 0;
+	y = 0;
+	this->width = width;
+	this->height = height;
+	arenaWidth = width;
+	arenaHeight = height;
+
+}
+
+void Camera::setView(int width, int height) {
+
+	this->width = width;
+	this->height = height;
+	follow(x + width / 2, y + height / 2);
+
+}
+
+void Camera::setArena(int width, int height) {
+
+	arenaWidth = width;
+	arenaHeight = height;
+	follow(x + this->width / 2, y + this->height / 2);
+
+}
+
+void Camera::follow(int x, int y) {
+
+	// An arena smaller than the view stays at its top-left corner
+	this->x = clampTo(x - width / 2, 0, arenaWidth > width ? arenaWidth - width : 0);
+	this->y = clampTo(y - height / 2, 0, arenaHeight > height ? arenaHeight - height : 0);
+
+}
+
+bool Camera::clip(TrailSegment& segment) const {
+
+	int left = segment.x1 < segment.x2 ? segment.x1 : segment.x2;
+	int right = segment.x1 < segment.x2 ? segment.x2 : segment.x1;
+	int top = segment.y1 < segment.y2 ? segment.y1 : segment.y2;
+	int bottom = segment.y1 < segment.y2 ? segment.y2 : segment.y1;
+	if (!sees(left, top, right, bottom)) {
+		return false;
+	}
+
+	if (segment.y1 == segment.y2) {
+		segment.x1 = clampTo(segment.x1, x, x + width - 1);
+		segment.x2 = clampTo(segment.x2, x, x + width - 1);
+	}
+	else if (segment.x1 == segment.x2) {
+		segment.y1 = clampTo(segment.y1, y, y + height - 1);
+		segment.y2 = clampTo(segment.y2, y, y + height - 1);
+	}
+	return true;
+
+}
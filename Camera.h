@@ -0,0 +1,43 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include "Trail.h"
+
+// The part of the arena on screen, for arenas far bigger than the window.
+// It follows a point, normally a cycle's head, and stops at the arena
+// edges. Renderers draw only what it sees, at arena position minus
+// getX(), getY(), so the cost of a frame depends on the window and not on
+// the arena.
+class Camera {
+protected:
+	int x, y;					// Top-left of the view in arena pixels
+	int width, height;			// Size of the view
+	int arenaWidth, arenaHeight;
+
+public:
+	Camera(int width = 0, int height = 0);
+
+	void setView(int width, int height);
+	void setArena(int width, int height);
+	// Centre the view on x, y as far as the arena edges allow
+	void follow(int x, int y);
+
+	// Whether the whole arena is in view without moving, in which case it
+	// can be drawn as it always was
+	bool showsWholeArena() const { return arenaWidth <= width && arenaHeight <= height; };
+	// Whether any of a rectangle, both corners included, is in view
+	bool sees(int left, int top, int right, int bottom) const {
+		return right >= x && left < x + width && bottom >= y && top < y + height;
+	};
+	// Cut a segment down to the part in view, false if there is none.
+	// Trails run along the axes; any other segment is only culled.
+	bool clip(TrailSegment& segment) const;
+
+	int getX() const { return x; };
+	int getY() const { return y; };
+	int getWidth() const { return width; };
+	int getHeight() const { return height; };
+
+};
+
+#endif
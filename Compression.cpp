@@ -0,0 +1,181 @@
+#include "Compression.h"
+#include <cstring>
+
+using namespace std;
+
+static const size_t MIN_MATCH = 4;
+static const size_t MAX_OFFSET = 65535;
+// The format ends every block with literals: no match may start in the
+// last 12 bytes or run into the last 5
+static const size_t LAST_LITERALS = 5;
+static const size_t MATCH_LIMIT = 12;
+static const int HASH_BITS = 14;
+
+static uint32_t read32(const uint8_t* p) {
+	uint32_t value;
+	memcpy(&value, p, 4);
+	return value;
+}
+
+static uint32_t hash4(uint32_t value) {
+	return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static void writeLength(vector<uint8_t>& out, size_t length) {
+	while (length >= 255) {
+		out.push_back(255);
+		length -= 255;
+	}
+	out.push_back((uint8_t)length);
+}
+
+static void writeSequence(vector<uint8_t>& out, const uint8_t* literals, size_t literalLength,
+	size_t offset, size_t matchLength) {
+
+	size_t extraMatch = matchLength >= MIN_MATCH ? matchLength - MIN_MATCH : 0;
+	uint8_t token = (uint8_t)((literalLength < 15 ? literalLength : 15) << 4);
+	if (matchLength >= MIN_MATCH) {
+		token |= (uint8_t)(extraMatch < 15 ? extraMatch : 15);
+	}
+	out.push_back(token);
+	if (literalLength >= 15) {
+		writeLength(out, literalLength - 15);
+	}
+	out.insert(out.end(), literals, literals + literalLength);
+
+	if (matchLength >= MIN_MATCH) {
+		out.push_back((uint8_t)offset);
+		out.push_back((uint8_t)(offset >> 8));
+		if (extraMatch >= 15) {
+			writeLength(out, extraMatch - 15);
+		}
+	}
+
+}
+
+void LzCompress(const uint8_t* src, size_t size, vector<uint8_t>& out) {
+
+	out.clear();
+	out.reserve(size / 2 + 16);
+
+	size_t anchor = 0;
+	if (size > MATCH_LIMIT) {
+		vector<uint32_t> table((size_t)1 << HASH_BITS, 0xffffffffu);
+		size_t limit = size - MATCH_LIMIT;
+		size_t matchEnd = size - LAST_LITERALS;
+		size_t pos = 0;
+
+		while (pos < limit) {
+			uint32_t sequence = read32(src + pos);
+			uint32_t& slot = table[hash4(sequence)];
+			size_t candidate = slot;
+			slot = (uint32_t)pos;
+
+			if (candidate == 0xffffffffu || pos - candidate > MAX_OFFSET ||
+				read32(src + candidate) != sequence) {
+				pos++;
+				continue;
+			}
+
+			size_t length = MIN_MATCH;
+			while (pos + length < matchEnd && src[candidate + length] == src[pos + length]) {
+				length++;
+			}
+
+			writeSequence(out, src + anchor, pos - anchor, pos - candidate, length);
+			pos += length;
+			anchor = pos;
+		}
+	}
+
+	writeSequence(out, src + anchor, size - anchor, 0, 0);
+
+}
+
+bool LzDecompress(const uint8_t* src, size_t size, uint8_t* dst, size_t dstSize) {
+
+	size_t in = 0, out = 0;
+
+	while (in < size) {
+		uint8_t token = src[in++];
+
+		size_t literalLength = token >> 4;
+		if (literalLength == 15) {
+			uint8_t more;
+			do {
+				if (in >= size) {
+					return false;
+				}
+				more = src[in++];
+				literalLength += more;
+			} while (more == 255);
+		}
+		if (literalLength > size - in || literalLength > dstSize - out) {
+			return false;
+		}
+		// Short runs copy a fixed 16 bytes when there is room, which compiles
+		// to two moves instead of a call
+		if (literalLength <= 16 && size - in >= 16 && dstSize - out >= 16) {
+			memcpy(dst + out, src + in, 16);
+		}
+		else {
+			memcpy(dst + out, src + in, literalLength);
+		}
+		in += literalLength;
+		out += literalLength;
+
+		// The last sequence has literals only
+		if (in == size) {
+			break;
+		}
+
+		if (size - in < 2) {
+			return false;
+		}
+		size_t offset = src[in] | (src[in + 1] << 8);
+		in += 2;
+		if (offset == 0 || offset > out) {
+			return false;
+		}
+
+		size_t matchLength = token & 15;
+		if (matchLength == 15) {
+			uint8_t more;
+			do {
+				if (in >= size) {
+					return false;
+				}
+				more = src[in++];
+				matchLength += more;
+			} while (more == 255);
+		}
+		matchLength += MIN_MATCH;
+		if (matchLength > dstSize - out) {
+			return false;
+		}
+
+		// A match shorter than its offset is one plain copy. A longer one repeats
+		// the last offset bytes, so copy one period and then keep doubling it.
+		const uint8_t* from = dst + out - offset;
+		uint8_t* to = dst + out;
+		if (offset >= 16 && matchLength <= 16 && dstSize - out >= 16) {
+			memcpy(to, from, 16);
+		}
+		else if (offset >= matchLength) {
+			memcpy(to, from, matchLength);
+		}
+		else {
+			memcpy(to, from, offset);
+			size_t copied = offset;
+			while (copied < matchLength) {
+				size_t chunk = copied < matchLength - copied ? copied : matchLength - copied;
+				memcpy(to + copied, to, chunk);
+				copied += chunk;
+			}
+		}
+		out += matchLength;
+	}
+
+	return out == dstSize;
+
+}
@@ -0,0 +1,24 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Byte-level LZ77 in the LZ4 block layout: a token with literal and match
+// length nibbles, the literals, a 16-bit back offset, longer lengths in
+// extra 255-steps. Greedy single-probe matching keeps the compressor
+// simple; decoding is a tight copy loop that runs at memory speed, which
+// is what matters for assets compressed once and loaded every start.
+void LzCompress(const uint8_t* src, size_t size, std::vector<uint8_t>& out);
+
+// Decode exactly dstSize bytes. Returns false on any malformed input
+// instead of reading or writing out of bounds.
+bool LzDecompress(const uint8_t* src, size_t size, uint8_t* dst, size_t dstSize);
+
+// No input decodes to more than this many bytes per byte: a match grows
+// by at most 255 for each extra length byte, and everything else costs at
+// least a byte for every few it produces
+const size_t LZ_MAX_EXPANSION = 255;
+
+#endif
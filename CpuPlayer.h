@@ -0,0 +1,16 @@
+#ifndef CPU_PLAYER_H
+#define CPU_PLAYER_H
+
+#include "Simulation.h"
+
+// Anything that can drive a cycle in place of the keyboard
+class CpuPlayer {
+public:
+	virtual ~CpuPlayer() {};
+
+	// Input for this tick
+	virtual PLAYERINPUT chooseInput(const GameState& state) = 0;
+
+};
+
+#endif
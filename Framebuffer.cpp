@@ -0,0 +1,292 @@
+#include "Framebuffer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define FRAMEBUFFER_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit SSE2/AVX2 instructions in functions marked for them
+#if defined(FRAMEBUFFER_X86) && defined(__GNUC__)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+using namespace std;
+
+typedef void (*KeyedRow)(uint32_t* dst, const uint32_t* src, int count, uint32_t key);
+
+static void keyedRowScalar(uint32_t* dst, const uint32_t* src, int count, uint32_t key) {
+
+	for (int i = 0; i < count; i++) {
+		if ((src[i] & 0x00ffffff) != key) {
+			dst[i] = src[i];
+		}
+	}
+
+}
+
+#ifdef FRAMEBUFFER_X86
+
+TARGET_SSE2 static void keyedRowSse2(uint32_t* dst, const uint32_t* src, int count, uint32_t key) {
+
+	const __m128i rgb = _mm_set1_epi32(0x00ffffff);
+	const __m128i keys = _mm_set1_epi32((int)key);
+	int i = 0;
+
+	// Keep dst where the source matches the key, take the source elsewhere
+	for (; i + 4 <= count; i += 4) {
+		__m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+		__m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+		__m128i keep = _mm_cmpeq_epi32(_mm_and_si128(s, rgb), keys);
+		_mm_storeu_si128((__m128i*)(dst + i),
+			_mm_or_si128(_mm_and_si128(keep, d), _mm_andnot_si128(keep, s)));
+	}
+	keyedRowScalar(dst + i, src + i, count - i, key);
+
+}
+
+TARGET_AVX2 static void keyedRowAvx2(uint32_t* dst, const uint32_t* src, int count, uint32_t key) {
+
+	const __m256i rgb = _mm256_set1_epi32(0x00ffffff);
+	const __m256i keys = _mm256_set1_epi32((int)key);
+	int i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+		__m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+		__m256i keep = _mm256_cmpeq_epi32(_mm256_and_si256(s, rgb), keys);
+		_mm256_storeu_si256((__m256i*)(dst + i), _mm256_blendv_epi8(s, d, keep));
+	}
+
+	// Masked tail rather than the SSE2 loop, mixing in legacy SSE code stalls on the AVX state
+	if (i < count) {
+		__m256i lanes = _mm256_cmpgt_epi32(_mm256_set1_epi32(count - i),
+			_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+		__m256i s = _mm256_maskload_epi32((const int*)(src + i), lanes);
+		__m256i keep = _mm256_cmpeq_epi32(_mm256_and_si256(s, rgb), keys);
+		_mm256_maskstore_epi32((int*)(dst + i), _mm256_andnot_si256(keep, lanes), s);
+	}
+
+}
+
+static bool cpuHasAvx2() {
+
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
+	}
+	// AVX2 needs the OS to save the YMM registers as well
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	if (!osxsave || (_xgetbv(0) & 6) != 6) {
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	// Runs from a static initializer, possibly before libgcc has probed the CPU
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+
+}
+
+static bool cpuHasSse2() {
+
+#if defined(_M_X64) || defined(__x86_64__)
+	return true;
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[3] & (1 << 26)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse2") != 0;
+#endif
+
+}
+
+#endif
+
+// The fastest path the CPU has, or no faster than forced
+static KeyedRow pickKeyedRow(const char* forced, const char** name) {
+
+#ifdef FRAMEBUFFER_X86
+	if (forced != nullptr && *forced == 0) {
+		forced = nullptr;
+	}
+	bool allowAvx2 = forced == nullptr || strcmp(forced, "avx2") == 0;
+	bool allowSse2 = forced == nullptr || strcmp(forced, "scalar") != 0;
+	if (allowAvx2 && cpuHasAvx2()) {
+		*name = "avx2";
+		return keyedRowAvx2;
+	}
+	if (allowSse2 && cpuHasSse2()) {
+		*name = "sse2";
+		return keyedRowSse2;
+	}
+#endif
+	*name = "scalar";
+	return keyedRowScalar;
+
+}
+
+// Set LIGHTCYCLES_BLIT to sse2 or scalar to compare the paths
+static const char* keyedRowName = "scalar";
+static KeyedRow keyedRow = pickKeyedRow(getenv("LIGHTCYCLES_BLIT"), &keyedRowName);
+
+Framebuffer::Framebuffer(int width, int height) {
+
+	this->width = 0;
+	this->height = 0;
+	pixelsWritten = 0;
+	resize(width, height);
+
+}
+
+void Framebuffer::resize(int w, int h) {
+
+	width = w > 0 ? w : 0;
+	height = h > 0 ? h : 0;
+	pixels.assign((size_t)width * height, 0);
+
+}
+
+void Framebuffer::fill(uint32_t color) {
+
+	std::fill(pixels.begin(), pixels.end(), color);
+	pixelsWritten += pixels.size();
+
+}
+
+void Framebuffer::fillRect(int x, int y, int w, int h, uint32_t color) {
+
+	int srcX = 0, srcY = 0;
+	if (!clip(x, y, srcX, srcY, w, h)) {
+		return;
+	}
+	for (int row = 0; row < h; row++) {
+		uint32_t* dst = &pixels[(size_t)(y + row) * width + x];
+		std::fill(dst, dst + w, color);
+	}
+	pixelsWritten += (unsigned long long)w * h;
+
+}
+
+void Framebuffer::copyFrom(const Framebuffer& other) {
+
+	if (width != other.width || height != other.height) {
+		resize(other.width, other.height);
+	}
+	if (!pixels.empty()) {
+		memcpy(pixels.data(), other.pixels.data(), pixels.size() * sizeof(uint32_t));
+	}
+	pixelsWritten += pixels.size();
+
+}
+
+bool Framebuffer::clip(int& x, int& y, int& srcX, int& srcY, int& w, int& h) {
+
+	if (x < 0) {
+		srcX -= x;
+		w += x;
+		x = 0;
+	}
+	if (y < 0) {
+		srcY -= y;
+		h += y;
+		y = 0;
+	}
+	if (x + w > width) {
+		w = width - x;
+	}
+	if (y + h > height) {
+		h = height - y;
+	}
+	return w > 0 && h > 0;
+
+}
+
+void Framebuffer::blit(const uint32_t* src, int w, int h, int srcPitch, int x, int y) {
+
+	int srcX = 0, srcY = 0;
+	if (src == nullptr || !clip(x, y, srcX, srcY, w, h)) {
+		return;
+	}
+	for (int row = 0; row < h; row++) {
+		memcpy(&pixels[(size_t)(y + row) * width + x], src + (size_t)(srcY + row) * srcPitch + srcX,
+			w * sizeof(uint32_t));
+	}
+	pixelsWritten += (unsigned long long)w * h;
+
+}
+
+void Framebuffer::blitKeyed(const uint32_t* src, int w, int h, int srcPitch, int x, int y, uint32_t key) {
+
+	int srcX = 0, srcY = 0;
+	if (src == nullptr || !clip(x, y, srcX, srcY, w, h)) {
+		return;
+	}
+	key &= 0x00ffffff;
+	for (int row = 0; row < h; row++) {
+		keyedRow(&pixels[(size_t)(y + row) * width + x], src + (size_t)(srcY + row) * srcPitch + srcX,
+			w, key);
+	}
+	pixelsWritten += (unsigned long long)w * h;
+
+}
+
+void Framebuffer::drawLine(int x0, int y0, int x1, int y1, uint32_t color) {
+
+	// Bresenham, both end points included
+	int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+	int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+	int err = dx + dy;
+
+	while (true) {
+		setPixel(x0, y0, color);
+		if (x0 == x1 && y0 == y1) {
+			break;
+		}
+		int e2 = 2 * err;
+		if (e2 >= dy) {
+			err += dy;
+			x0 += sx;
+		}
+		if (e2 <= dx) {
+			err += dx;
+			y0 += sy;
+		}
+	}
+
+}
+
+const char* Framebuffer::GetBlitPath() {
+
+	return keyedRowName;
+
+}
+
+bool Framebuffer::SetBlitPath(const char* path) {
+
+	const char* name = "scalar";
+	KeyedRow row = pickKeyedRow(path, &name);
+	if (path == nullptr || strcmp(name, path) != 0) {
+		return false;
+	}
+	keyedRow = row;
+	keyedRowName = name;
+	return true;
+
+}
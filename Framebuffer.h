@@ -0,0 +1,83 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Pixels are 32-bit 0x00RRGGBB, top row first, which is the memory layout
+// of a 32bpp top-down DIB. Note COLORREF is 0x00BBGGRR.
+inline uint32_t PixelColor(int r, int g, int b) {
+	return ((uint32_t)(r & 0xff) << 16) | ((uint32_t)(g & 0xff) << 8) | (uint32_t)(b & 0xff);
+}
+
+const uint32_t PIXEL_MAGENTA = 0x00ff00ff;
+
+struct PixelImage {
+	int width;
+	int height;
+	std::vector<uint32_t> pixels;
+
+	PixelImage() : width(0), height(0) {};
+	void resize(int w, int h) { width = w; height = h; pixels.assign((size_t)w * h, 0); };
+};
+
+// Software render target with no GDI or GPU behind it. Blits clip against
+// the frame and color-keyed blits compare whole rows with SSE2 or AVX2,
+// picked at run time from what the CPU supports.
+class Framebuffer {
+protected:
+	int width;
+	int height;
+	std::vector<uint32_t> pixels;
+	unsigned long long pixelsWritten;
+
+	bool clip(int& x, int& y, int& srcX, int& srcY, int& w, int& h);
+
+public:
+	Framebuffer(int width = 0, int height = 0);
+
+	void resize(int w, int h);
+	void fill(uint32_t color);
+	void fillRect(int x, int y, int w, int h, uint32_t color);
+	void copyFrom(const Framebuffer& other);
+
+	// Opaque copy of a w x h block, srcPitch is in pixels
+	void blit(const uint32_t* src, int w, int h, int srcPitch, int x, int y);
+	// Copy skipping every source pixel equal to key (the top byte is ignored)
+	void blitKeyed(const uint32_t* src, int w, int h, int srcPitch, int x, int y, uint32_t key);
+	void blit(const PixelImage& image, int x, int y) {
+		blit(image.pixels.data(), image.width, image.height, image.width, x, y);
+	};
+	void blitKeyed(const PixelImage& image, int x, int y, uint32_t key = PIXEL_MAGENTA) {
+		blitKeyed(image.pixels.data(), image.width, image.height, image.width, x, y, key);
+	};
+
+	void setPixel(int x, int y, uint32_t color) {
+		if ((unsigned int)x < (unsigned int)width && (unsigned int)y < (unsigned int)height) {
+			pixels[(size_t)y * width + x] = color;
+			pixelsWritten++;
+		}
+	};
+	// One pixel wide line including both end points
+	void drawLine(int x0, int y0, int x1, int y1, uint32_t color);
+
+	// The raw frame, getPitch() pixels per row
+	uint32_t* getPixels() { return pixels.data(); };
+	const uint32_t* getPixels() const { return pixels.data(); };
+	int getWidth() const { return width; };
+	int getHeight() const { return height; };
+	int getPitch() const { return width; };
+
+	unsigned long long getPixelsWritten() { return pixelsWritten; };
+	void resetPixelsWritten() { pixelsWritten = 0; };
+
+	// "avx2", "sse2" or "scalar"
+	static const char* GetBlitPath();
+	// Switch every Framebuffer to one of those, false if the CPU lacks it.
+	// For benchmarks; not safe while another thread is blitting.
+	static bool SetBlitPath(const char* path);
+
+};
+
+#endif
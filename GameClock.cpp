@@ -0,0 +1,55 @@
+#include "GameClock.h"
+
+using namespace std;
+
+GameClock::GameClock(int tickRate, int maxCatchUp) {
+
+	this->maxCatchUp = maxCatchUp > 0 ? maxCatchUp : 1;
+	ticks = 0;
+	missedTicks = 0;
+
+	setTickRate(tickRate);
+	reset();
+
+}
+
+void GameClock::setTickRate(int tickRate) {
+
+	if (tickRate <= 0) {
+		tickRate = 1;
+	}
+
+	tickDuration = chrono::duration_cast<Clock::duration>(
+		chrono::nanoseconds(1000000000LL / tickRate));
+
+}
+
+void GameClock::reset() {
+
+	nextTick = Clock::now();
+
+}
+
+int GameClock::ticksDue() {
+
+	Clock::time_point now = Clock::now();
+
+	if (now < nextTick) {
+
+		return 0;
+
+	}
+
+	long long due = (now - nextTick) / tickDuration + 1;
+	nextTick += tickDuration * due;
+
+	if (due > maxCatchUp) {
+		missedTicks += due - maxCatchUp;
+		due = maxCatchUp;
+	}
+
+	ticks += due;
+
+	return (int)due;
+
+}
@@ -0,0 +1,35 @@
+#ifndef GAME_CLOCK_H
+#define GAME_CLOCK_H
+
+#include <chrono>
+
+// Fixed-timestep scheduler on the monotonic high resolution clock. Each
+// call to ticksDue() says how many whole ticks have come due since the
+// last call; anything beyond maxCatchUp is dropped and counted as missed
+// so a stall never turns into a burst of simulation.
+class GameClock {
+public:
+	typedef std::chrono::steady_clock Clock;
+
+protected:
+	Clock::duration tickDuration;
+	Clock::time_point nextTick;
+	int maxCatchUp;
+	unsigned long long ticks;
+	unsigned long long missedTicks;
+
+public:
+	GameClock(int tickRate = 60, int maxCatchUp = 5);
+
+	void setTickRate(int tickRate);
+	void reset();
+	int ticksDue();
+
+	Clock::time_point getNextTick() { return nextTick; };
+	Clock::duration getTickDuration() { return tickDuration; };
+	unsigned long long getTicks() { return ticks; };
+	unsigned long long getMissedTicks() { return missedTicks; };
+
+};
+
+#endif
@@ -1,22 +1,70 @@
 #include "GameEngine.h"
+#include "GameClock.h"
+
+#pragma comment(lib, "winmm.lib")
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
 
 GameEngine* GameEngine::gameEngine = NULL;
 
+// Create a waitable timer for sleeping until the next tick or frame,
+// preferring the high resolution kind over raising the system timer rate
+static HANDLE CreateTickTimer(bool& raisedTimerResolution) {
+	raisedTimerResolution = false;
+	HANDLE timer = CreateWaitableTimerEx(NULL, NULL,
+		CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	if (timer == NULL) {
+		timeBeginPeriod(1);
+		raisedTimerResolution = true;
+		timer = CreateWaitableTimer(NULL, FALSE, NULL);
+	}
+	return timer;
+}
+
+// Sleep until the given time, waking early if a window message arrives
+static void WaitUntil(HANDLE timer, GameClock::Clock::time_point wake) {
+	GameClock::Clock::duration wait = wake - GameClock::Clock::now();
+	if (wait <= GameClock::Clock::duration::zero()) {
+		return;
+	}
+	LARGE_INTEGER due;
+	due.QuadPart = -(LONGLONG)(std::chrono::duration_cast<std::chrono::nanoseconds>(wait).count() / 100);
+	if (timer != NULL && SetWaitableTimer(timer, &due, 0, NULL, NULL, FALSE)) {
+		MsgWaitForMultipleObjects(1, &timer, FALSE, INFINITE, QS_ALLINPUT);
+	}
+	else {
+		DWORD ms = (DWORD)std::chrono::duration_cast<std::chrono::milliseconds>(wait).count();
+		MsgWaitForMultipleObjects(0, NULL, FALSE, ms, QS_ALLINPUT);
+	}
+}
+
 int WINAPI WinMain(HINSTANCE currInstance, HINSTANCE prevInstance,
 	PSTR szCmdLine, int showCmd) {
 	MSG msg;
-	static long ticTrigger = 0;
-	long ticCounter;
+	msg.wParam = 0;
 
 	if (GameInitialize(currInstance)) {
 		if (!GameEngine::GetEngine()->initialize(showCmd))
 			return FALSE;
-		while (true) {
+
+		// Simulation ticks and rendered frames run on separate clocks, frames
+		// are never caught up so only ticks can be missed
+		GameClock tickClock(GameEngine::GetEngine()->getTickRate());
+		GameClock frameClock(GameEngine::GetEngine()->getFrameRate(), 1);
+		bool raisedTimerResolution;
+		HANDLE timer = CreateTickTimer(raisedTimerResolution);
+		bool wasAsleep = true;
+		bool quit = false;
+
+		while (!quit) {
 			
-			if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
+			while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
 				
 				if (msg.message == WM_QUIT) {
 
+					quit = true;
 					break;
 
 				}
@@ -25,24 +73,64 @@ int WINAPI WinMain(HINSTANCE currInstance, HINSTANCE prevInstance,
 				DispatchMessage(&msg);
 
 			}
-			else {
 
-				if (!GameEngine::GetEngine()->getSleep()) {
+			if (quit) {
 
-					ticCounter = GetTickCount();
+				break;
 
-					if (ticCounter > ticTrigger) {
+			}
 
-						ticTrigger = ticCounter + GameEngine::GetEngine()->getFrameDelay();
-						HandleKeys();
-						GameLoop();
+			if (GameEngine::GetEngine()->getSleep() && !GameEngine::GetEngine()->getRunInBackground()) {
 
-					}
+				// Nothing to do until the window gets focus back
+				wasAsleep = true;
+				WaitMessage();
+				continue;
 
-				}
+			}
+
+			if (wasAsleep) {
+
+				// Don't try to catch up on the time spent asleep
+				tickClock.reset();
+				frameClock.reset();
+				wasAsleep = false;
 
 			}
 
+			unsigned long long missed = tickClock.getMissedTicks();
+			for (int ticks = tickClock.ticksDue(); ticks > 0; ticks--) {
+
+				GameTick();
+
+			}
+
+			if (tickClock.getMissedTicks() != missed) {
+
+				GameEngine::GetEngine()->setMissedTicks(tickClock.getMissedTicks());
+				OutputDebugString(L"LightCycles: simulation fell behind, ticks dropped\n");
+
+			}
+
+			if (frameClock.ticksDue() > 0) {
+
+				GameLoop();
+
+			}
+
+			GameClock::Clock::time_point wake = tickClock.getNextTick();
+			if (frameClock.getNextTick() < wake) {
+				wake = frameClock.getNextTick();
+			}
+			WaitUntil(timer, wake);
+
+		}
+
+		if (timer != NULL) {
+			CloseHandle(timer);
+		}
+		if (raisedTimerResolution) {
+			timeEndPeriod(1);
 		}
 
 		return msg.wParam;
@@ -134,12 +222,19 @@ GameEngine::GameEngine(HINSTANCE instance, std::wstring wndClass,
 	this->smIcon = smIcon;
 	this->width = width;
 	this->height = height;
+	SetRect(&clientRect, 0, 0, width, height);
 	frameDelay = 50;
+	frameRate = 20;
+	tickRate = 20;
+	missedTicks = 0;
 	sleep = TRUE;
+	runInBackground = FALSE;
 }
 
 GameEngine::~GameEngine() {
 
+	cleanupSprites();
+
 }
 
 LRESULT GameEngine::HandleEvent(HWND hwnd, UINT msg, WPARAM wparam,
@@ -168,6 +263,15 @@ LRESULT GameEngine::HandleEvent(HWND hwnd, UINT msg, WPARAM wparam,
 		GameEnd();
 		PostQuitMessage(0);
 		return 0;
+	case WM_KEYDOWN:
+		// Auto-repeat adds nothing to a key that is already down
+		if ((lparam & 0x40000000) == 0) {
+			KeyDown(wparam);
+		}
+		return 0;
+	case WM_KEYUP:
+		KeyUp(wparam);
+		return 0;
 	case WM_MOUSEMOVE:
 		MouseMove(LOWORD(lparam), HIWORD(lparam));
 		return 0;
@@ -205,38 +309,104 @@ void GameEngine::addSprite(Sprite* s) {
 }
 
 void GameEngine::drawSprites(HDC hdc) {
+	for (int i = 0; i < spriteStore.getCount(); i++) {
+		uint32_t image = spriteStore.getImage(i);
+		if (!spriteStore.isHidden(i) && image < spriteImages.size() && spriteImages[image] != nullptr) {
+			spriteImages[image]->draw(hdc, spriteStore.getX(i), spriteStore.getY(i), true);
+		}
+	}
 	for (auto vecIter = sprites.begin(); vecIter != sprites.end(); vecIter++) {
 		(*vecIter)->Draw(hdc);
 	}
 }
 
 void GameEngine::updateSprites() {
-	if (sprites.size() >= sprites.capacity() / 2) {
-		sprites.reserve(sprites.capacity() * 2);
-	}
-	RECT oldSpritePos;
-	SPRITEACTION sa;
-	for (auto vecIter = sprites.begin(); vecIter != sprites.end(); vecIter++) {
-		oldSpritePos = (*vecIter)->getPosition();
-		sa = (*vecIter)->Update();
-		if (sa & SA_KILL) {
-			delete (*vecIter);
-			sprites.erase(vecIter);
-			vecIter--;
+	spriteStore.update();
+
+	// Move every sprite first, dropping the ones that die
+	oldPositions.clear();
+	size_t kept = 0;
+	for (size_t i = 0; i < sprites.size(); i++) {
+		RECT oldSpritePos = sprites[i]->getPosition();
+		if (sprites[i]->Update() & SA_KILL) {
+			freeSprite(sprites[i]);
 			continue;
 		}
-		if (checkSpriteCollision(*vecIter) || checkWindowCollision(*vecIter)) {
-			(*vecIter)->setPosition(oldSpritePos);
+		sprites[kept++] = sprites[i];
+		oldPositions.push_back(oldSpritePos);
+	}
+	sprites.resize(kept);
+
+	// Then put back each sprite that hit another or the window edge. A
+	// sprite is reported against the first sprite it overlaps, in z-order.
+	GetClientRect(hwnd, &clientRect);
+	findSpriteCollisions();
+	for (size_t i = 0; i < sprites.size(); i++) {
+		bool hit = firstHits[i] >= 0 && SpriteCollision(sprites[i], sprites[firstHits[i]]);
+		if (hit || checkWindowCollision(sprites[i])) {
+			sprites[i]->setPosition(oldPositions[i]);
+		}
+	}
+}
+
+// Run the broad phase over the collision rects and note, for each sprite,
+// the lowest-indexed sprite it overlaps or -1
+void GameEngine::findSpriteCollisions() {
+	size_t count = sprites.size();
+	collisionLefts.resize(count);
+	collisionTops.resize(count);
+	collisionRights.resize(count);
+	collisionBottoms.resize(count);
+	for (size_t i = 0; i < count; i++) {
+		RECT& collision = sprites[i]->getCollision();
+		collisionLefts[i] = collision.left;
+		collisionTops[i] = collision.top;
+		collisionRights[i] = collision.right;
+		collisionBottoms[i] = collision.bottom;
+	}
+
+	const std::vector<CollisionPair>& pairs = broadPhase.findPairs(collisionLefts.data(),
+		collisionTops.data(), collisionRights.data(), collisionBottoms.data(), (int)count);
+
+	firstHits.assign(count, -1);
+	for (size_t p = 0; p < pairs.size(); p++) {
+		const CollisionPair& pair = pairs[p];
+		if (firstHits[pair.first] < 0 || pair.second < firstHits[pair.first]) {
+			firstHits[pair.first] = pair.second;
+		}
+		if (firstHits[pair.second] < 0 || pair.first < firstHits[pair.second]) {
+			firstHits[pair.second] = pair.first;
 		}
 	}
 }
 
 void GameEngine::cleanupSprites(){
-	for (auto vecIter = sprites.begin(); vecIter != sprites.end(); 
-		vecIter = sprites.begin()) {
-		delete (*vecIter);
-		sprites.erase(vecIter);
+	spriteStore.clear();
+	spriteImages.clear();
+	for (size_t i = 0; i < sprites.size(); i++) {
+		freeSprite(sprites[i]);
+	}
+	sprites.clear();
+}
+
+// Sprites from a pool are destroyed in place and their slot handed back
+void GameEngine::freeSprite(Sprite* sprite) {
+	PoolBase* pool = sprite->getPool();
+	if (pool == NULL) {
+		delete sprite;
+		return;
+	}
+	void* slot = dynamic_cast<void*>(sprite);
+	sprite->~Sprite();
+	pool->release(slot);
+}
+
+void GameEngine::resetRound() {
+	cleanupSprites();
+	for (auto entry = spritePools.begin(); entry != spritePools.end(); entry++) {
+		entry->second->reset();
 	}
+	roundArena.reset();
 }
 
 Sprite* GameEngine::isPointInSprite(int x, int y){
@@ -249,22 +419,8 @@ Sprite* GameEngine::isPointInSprite(int x, int y){
 	return NULL;
 }
 
-bool GameEngine::checkSpriteCollision(Sprite* testSprite){
-	for (auto vecIter = sprites.begin(); vecIter != sprites.end();
-		vecIter++) {
-		if ((*vecIter) == testSprite) {
-			continue;
-		}
-		if (testSprite->testCollision(*vecIter)) {
-			return SpriteCollision(testSprite, (*vecIter));
-		}
-	}
-	return false;
-}
-
 bool GameEngine::checkWindowCollision(Sprite* sprite) {
-	RECT windowRect;
-	GetClientRect(hwnd, &windowRect);
+	const RECT& windowRect = clientRect;
 
 	RECT spriteRect = sprite->getPosition();
 
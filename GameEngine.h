@@ -4,6 +4,13 @@
 #include "Windows.h"
 #include <string>
 #include "Sprite.h"
+#include "AssetCache.h"
+#include "SpatialHash.h"
+#include "Arena.h"
+#include <map>
+#include <memory>
+#include <typeindex>
+#include <typeinfo>
 #include <vector>
 
 int WINAPI WinMain(HINSTANCE currInstance, HINSTANCE prevInstance,
@@ -12,6 +19,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wparam,
 	LPARAM lparam);
 
 BOOL GameInitialize(HINSTANCE currInstance);
+void GameTick();
 void GameLoop();
 void GameEnd();
 void GameStart(HWND hwnd);
@@ -20,6 +28,8 @@ void GameDeactivate(HWND hwnd);
 void GamePaint(HDC hdc);
 
 void HandleKeys();
+void KeyDown(WPARAM key);
+void KeyUp(WPARAM key);
 void MouseButtonDown(int x, int y, bool left);
 void MouseButtonUp(int x, int y, bool left);
 void MouseMove(int x, int y);
@@ -40,9 +50,27 @@ protected:
 	int width;
 	int height;
 	int frameDelay;
+	int frameRate;
+	int tickRate;
+	unsigned long long missedTicks;
 	BOOL sleep;
-	std::vector<Sprite*> sprites;
-	bool checkSpriteCollision(Sprite* testSprite);
+	BOOL runInBackground;	// Keep ticking without focus, for games others are waiting on
+	std::vector<Sprite*> sprites;	// Virtual sprites, the slow path
+	SpriteStore spriteStore;		// Plain moving sprites, updated in one batch
+	std::vector<std::shared_ptr<BitMap>> spriteImages;
+	AssetCache assets;
+	// Everything made for one round, emptied by resetRound()
+	Arena roundArena;
+	std::map<std::type_index, std::unique_ptr<PoolBase>> spritePools;
+	// Broad phase for the virtual sprites, with its inputs kept between
+	// frames so they are not reallocated
+	SpatialHash broadPhase;
+	std::vector<int32_t> collisionLefts, collisionTops, collisionRights, collisionBottoms;
+	std::vector<RECT> oldPositions;
+	std::vector<int> firstHits;
+	RECT clientRect;	// Read once per updateSprites()
+	void findSpriteCollisions();
+	void freeSprite(Sprite* sprite);
 	bool checkWindowCollision(Sprite* sprite);
 
 public:
@@ -65,9 +93,21 @@ public:
 	int getWidth() { return width; };
 	int getHeight() { return height; };
 	int getFrameDelay() { return frameDelay; };
-	void setFrameRate(int frameRate) { frameDelay = 1000 / frameRate; };
+	void setFrameRate(int frameRate) {
+		this->frameRate = frameRate;
+		frameDelay = 1000 / frameRate;
+	};
+	int getFrameRate() { return frameRate; };
+	int getTickRate() { return tickRate; };
+	void setTickRate(int rate) { tickRate = rate; };
+	unsigned long long getMissedTicks() { return missedTicks; };
+	void setMissedTicks(unsigned long long missed) { missedTicks = missed; };
+	AssetCache& getAssets() { return assets; };
+	const std::vector<CollisionPair>& getSpritePairs() { return broadPhase.getPairs(); };
 	BOOL getSleep() { return sleep; };
 	void setSleep(BOOL s) { sleep = s; };
+	BOOL getRunInBackground() { return runInBackground; };
+	void setRunInBackground(BOOL run) { runInBackground = run; };
 	LPPOINT drawLine(HDC hdc, int startx, int starty, int endx, int endy) {
 
 		LPPOINT point = NULL;
@@ -81,25 +121,44 @@ public:
 	};
 	void drawBitMap(std::wstring filename, int x, int y) {
 
-		HBITMAP image = (HBITMAP)LoadImage(0, filename.c_str(), IMAGE_BITMAP,
-			0, 0, LR_LOADFROMFILE);
-
-		BITMAP bm; 
-
-		GetObject(image, sizeof(BITMAP), &bm);
+		HDC hdc = GetDC(hwnd);
 
-		HDC hdc = CreateCompatibleDC(GetDC(hwnd));
+		// Loaded from disk the first time only
+		std::shared_ptr<BitMap> image = assets.loadBitMap(hdc, filename);
 
-		SelectObject(hdc, image);
+		if (image != nullptr) {
 
-		BitBlt(GetDC(hwnd), x, y, bm.bmWidth, bm.bmHeight, hdc, 0, 0, SRCCOPY);
+			image->draw(hdc, x, y);
 
-		DeleteDC(hdc);
+		}
 
-		DeleteObject((HBITMAP)image);
+		ReleaseDC(hwnd, hdc);
 	}
 
 	void addSprite(Sprite*);
+	// Make a sprite of any Sprite type in a per-round pool and add it. The
+	// engine frees it when it dies or on cleanupSprites().
+	template <class T, class... Args>
+	T* createSprite(Args&&... args) {
+		std::unique_ptr<PoolBase>& pool = spritePools[std::type_index(typeid(T))];
+		if (pool == nullptr) {
+			pool.reset(new Pool<T>(&roundArena));
+		}
+		T* sprite = ((Pool<T>*)pool.get())->create(std::forward<Args>(args)...);
+		sprite->setPool(pool.get());
+		addSprite(sprite);
+		return sprite;
+	};
+	// Free every sprite and everything else made for the round, call when a
+	// round starts. The memory is kept for the next one.
+	void resetRound();
+	Arena& getRoundArena() { return roundArena; };
+	SpriteStore& getSpriteStore() { return spriteStore; };
+	// Image index for SpriteStore::add()
+	uint32_t addSpriteImage(std::shared_ptr<BitMap> image) {
+		spriteImages.push_back(image);
+		return (uint32_t)spriteImages.size() - 1;
+	};
 	void drawSprites(HDC);
 	void updateSprites();
 	void cleanupSprites();
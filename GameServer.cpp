@@ -0,0 +1,658 @@
+#include "GameServer.h"
+#include "BatchRunner.h"
+#include "Transport.h"
+#include <cstring>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const uint16_t INPUT_ARRIVED = 0x100;	// Seat::input bit for "the client sent something"
+static const int SOCKET_BUFFER = 4 * 1024 * 1024;
+static const long long SWEEP_INTERVAL = 1000000;
+
+static void writeU32(uint8_t* out, uint32_t value) {
+
+	out[0] = (uint8_t)value;
+	out[1] = (uint8_t)(value >> 8);
+	out[2] = (uint8_t)(value >> 16);
+	out[3] = (uint8_t)(value >> 24);
+
+}
+
+static uint32_t readU32(const uint8_t* in) {
+
+	return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+
+}
+
+static void writeHeader(uint8_t* out, uint8_t type, uint32_t token) {
+
+	out[0] = ROOM_MAGIC[0];
+	out[1] = ROOM_MAGIC[1];
+	out[2] = ROOM_VERSION;
+	out[3] = type;
+	writeU32(out + 4, token);
+
+}
+
+// CPU time of the calling thread
+static long long ThreadMicros() {
+
+	timespec now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return (long long)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+
+}
+
+ServerConfig DefaultServerConfig(int rooms, int playersPerRoom) {
+
+	ServerConfig config;
+	config.port = 47100;
+	config.rooms = rooms;
+	config.playersPerRoom = playersPerRoom;
+	config.tickRate = 60;
+	config.updateRate = 30;
+	config.workers = 0;
+	config.roomsPerTask = 8;
+	config.width = 500;
+	config.height = 400;
+	config.seed = 1;
+	config.clientTimeout = 10;
+	return config;
+
+}
+
+LatencyHistogram::LatencyHistogram() {
+
+	reset();
+
+}
+
+void LatencyHistogram::reset() {
+
+	for (int i = 0; i <= BUCKETS; i++) {
+		counts[i] = 0;
+	}
+	total = 0;
+	longest = 0;
+
+}
+
+void LatencyHistogram::record(long long micros) {
+
+	if (micros < 0) {
+		micros = 0;
+	}
+	long long bucket = micros / BUCKET_WIDTH;
+	counts[bucket < BUCKETS ? bucket : BUCKETS]++;
+	total++;
+	long long most = longest;
+	while (micros > most && !longest.compare_exchange_weak(most, micros)) {
+	}
+
+}
+
+long long LatencyHistogram::percentile(double fraction) const {
+
+	unsigned long long count = total;
+	if (count == 0) {
+		return 0;
+	}
+	unsigned long long wanted = (unsigned long long)(fraction * count + 0.5);
+	if (wanted < 1) {
+		wanted = 1;
+	}
+	unsigned long long seen = 0;
+	for (int i = 0; i < BUCKETS; i++) {
+		seen += counts[i];
+		if (seen >= wanted) {
+			return (i + 1) * BUCKET_WIDTH;
+		}
+	}
+	return longest;
+
+}
+
+GameServer::GameServer() {
+
+	memset(&config, 0, sizeof(config));
+	socketHandle = -1;
+	epollHandle = -1;
+	timerHandle = -1;
+	startTime = 0;
+	timerTicks = 0;
+	activeRooms = 0;
+	clients = 0;
+	loopMicros = 0;
+	resetStats();
+
+}
+
+GameServer::~GameServer() {
+
+	close();
+
+}
+
+bool GameServer::fail(const char* what) {
+
+	error = what;
+	close();
+	return false;
+
+}
+
+bool GameServer::start(const ServerConfig& config) {
+
+	close();
+	error.clear();
+	if (config.rooms < 1 || config.playersPerRoom < 2 || config.playersPerRoom > MAX_PLAYERS ||
+		config.tickRate < 1 || config.tickRate > 1000 || config.updateRate < 1 ||
+		config.updateRate > config.tickRate || config.roomsPerTask < 1 || config.clientTimeout < 1) {
+		error = "bad server config";
+		return false;
+	}
+	this->config = config;
+
+	socketHandle = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, IPPROTO_UDP);
+	if (socketHandle < 0) {
+		return fail("socket failed");
+	}
+	// Every room's updates go out of this one socket, so give bursts some room
+	int bufferSize = SOCKET_BUFFER;
+	setsockopt(socketHandle, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+	setsockopt(socketHandle, SOL_SOCKET, SO_SNDBUF, &bufferSize, sizeof(bufferSize));
+	sockaddr_in local;
+	memset(&local, 0, sizeof(local));
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(INADDR_ANY);
+	local.sin_port = htons(config.port);
+	if (::bind(socketHandle, (const sockaddr*)&local, sizeof(local)) != 0) {
+		return fail("bind failed, is the port in use?");
+	}
+
+	timerHandle = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+	epollHandle = epoll_create1(0);
+	if (timerHandle < 0 || epollHandle < 0) {
+		return fail("timerfd or epoll failed");
+	}
+	epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = socketHandle;
+	if (epoll_ctl(epollHandle, EPOLL_CTL_ADD, socketHandle, &event) != 0) {
+		return fail("epoll_ctl failed");
+	}
+	event.data.fd = timerHandle;
+	if (epoll_ctl(epollHandle, EPOLL_CTL_ADD, timerHandle, &event) != 0) {
+		return fail("epoll_ctl failed");
+	}
+
+	// Rooms sit idle until someone joins
+	rooms.clear();
+	for (int r = 0; r < config.rooms; r++) {
+		rooms.push_back(unique_ptr<Room>(new Room()));
+		Room& room = *rooms.back();
+		room.busy = false;
+		room.index = r;
+		room.clients = 0;
+		room.round = 0;
+		room.tick = 0;
+		room.rng.seed(config.seed + r);
+		for (int s = 0; s < MAX_PLAYERS; s++) {
+			Seat& seat = room.seats[s];
+			seat.taken = false;
+			seat.token = 0;
+			seat.address = 0;
+			seat.port = 0;
+			seat.lastHeard = 0;
+			seat.input = 0;
+			seat.ack = NO_VIEW;
+			seat.held = PI_NONE;
+		}
+	}
+	tokens.clear();
+	activeRooms = 0;
+	clients = 0;
+
+	pool.reset(new ThreadPool(config.workers));
+	resetStats();
+	return true;
+
+}
+
+void GameServer::close() {
+
+	// Ticks still queued use the socket and the rooms
+	if (pool != nullptr) {
+		pool->wait();
+		pool.reset();
+	}
+	if (epollHandle >= 0) {
+		::close(epollHandle);
+		epollHandle = -1;
+	}
+	if (timerHandle >= 0) {
+		::close(timerHandle);
+		timerHandle = -1;
+	}
+	if (socketHandle >= 0) {
+		::close(socketHandle);
+		socketHandle = -1;
+	}
+	tokens.clear();
+
+}
+
+uint16_t GameServer::getPort() const {
+
+	if (socketHandle < 0) {
+		return 0;
+	}
+	sockaddr_in local;
+	socklen_t length = sizeof(local);
+	if (getsockname(socketHandle, (sockaddr*)&local, &length) != 0) {
+		return 0;
+	}
+	return ntohs(local.sin_port);
+
+}
+
+void GameServer::run(const atomic<bool>& stop) {
+
+	if (epollHandle < 0) {
+		return;
+	}
+
+	// Ticks are due on a fixed schedule from here, however late the loop wakes
+	itimerspec period;
+	period.it_interval.tv_sec = 0;
+	period.it_interval.tv_nsec = (long)(1000000000LL / config.tickRate);
+	period.it_value = period.it_interval;
+	startTime = NetNow();
+	timerTicks = 0;
+	timerfd_settime(timerHandle, 0, &period, nullptr);
+
+	long long lastSweep = startTime;
+	uint8_t packet[Transport::MAX_DATAGRAM + 1];
+	epoll_event events[4];
+	while (!stop) {
+		int ready = epoll_wait(epollHandle, events, 4, 100);
+		for (int e = 0; e < ready; e++) {
+			if (events[e].data.fd == timerHandle) {
+				uint64_t expired = 0;
+				if (read(timerHandle, &expired, sizeof(expired)) == sizeof(expired) && expired > 0) {
+					timerTicks += expired;
+					lateTimers += expired - 1;
+					tickRooms(startTime + (long long)(timerTicks * 1000000 / config.tickRate));
+				}
+				continue;
+			}
+
+			// Everything waiting, one datagram at a time
+			while (true) {
+				sockaddr_in from;
+				socklen_t fromLength = sizeof(from);
+				ssize_t got = recvfrom(socketHandle, packet, sizeof(packet), 0, (sockaddr*)&from, &fromLength);
+				if (got < 0) {
+					if (errno == EINTR || errno == ECONNREFUSED) {
+						continue;
+					}
+					break;
+				}
+				if (got == 0 || (size_t)got > Transport::MAX_DATAGRAM) {
+					packetsIgnored++;
+					continue;
+				}
+				handlePacket(packet, (size_t)got, from.sin_addr.s_addr, from.sin_port);
+			}
+		}
+
+		long long now = NetNow();
+		if (now - lastSweep >= SWEEP_INTERVAL) {
+			dropIdleClients(now);
+			lastSweep = now;
+		}
+		loopMicros = ThreadMicros();
+	}
+
+	itimerspec off;
+	memset(&off, 0, sizeof(off));
+	timerfd_settime(timerHandle, 0, &off, nullptr);
+
+}
+
+void GameServer::handlePacket(const uint8_t* data, size_t size, uint32_t address, uint16_t port) {
+
+	uint32_t token = size >= ROOM_HEADER ? readU32(data + 4) : 0;
+	if (size < ROOM_HEADER || data[0] != ROOM_MAGIC[0] || data[1] != ROOM_MAGIC[1] ||
+		data[2] != ROOM_VERSION || token == 0) {
+		packetsIgnored++;
+		return;
+	}
+	packetsReceived++;
+
+	if (data[3] == ROOM_JOIN && size >= ROOM_HEADER + 4) {
+		join(token, readU32(data + ROOM_HEADER), address, port);
+		return;
+	}
+
+	auto found = tokens.find(token);
+	if (found == tokens.end()) {
+		packetsIgnored++;
+		return;
+	}
+	Room& room = *rooms[found->second.room];
+	int s = found->second.seat;
+	Seat& seat = room.seats[s];
+	seat.lastHeard = NetNow();
+	if (seat.address != address || seat.port != port) {
+		lock_guard<mutex> guard(room.lock);
+		seat.address = address;
+		seat.port = port;
+	}
+
+	if (data[3] == ROOM_INPUT && size >= ROOM_HEADER + 5) {
+		// Packets can be reordered, which only means a longer update against an older view
+		seat.ack = readU32(data + ROOM_HEADER);
+		seat.input |= (uint16_t)(INPUT_ARRIVED | (data[ROOM_HEADER + 4] & 0x0f));
+	}
+	else if (data[3] == ROOM_LEAVE) {
+		lock_guard<mutex> guard(room.lock);
+		freeSeat(room, s);
+		tokens.erase(found);
+	}
+	else {
+		packetsIgnored++;
+	}
+
+}
+
+void GameServer::join(uint32_t token, uint32_t wanted, uint32_t address, uint16_t port) {
+
+	// A repeated join only means the welcome was lost
+	auto found = tokens.find(token);
+	int r = -1;
+	int s = -1;
+	if (found != tokens.end()) {
+		r = found->second.room;
+		s = found->second.seat;
+	}
+	else {
+		// The room asked for, or the first with a free seat so rooms fill up one by one
+		for (int i = 0; i < (int)rooms.size() && r < 0; i++) {
+			if ((wanted == ROOM_ANY || wanted == (uint32_t)i) && rooms[i]->clients < config.playersPerRoom) {
+				r = i;
+			}
+		}
+		if (r < 0) {
+			sendHeader(ROOM_FULL, token, address, port);
+			return;
+		}
+
+		Room& room = *rooms[r];
+		lock_guard<mutex> guard(room.lock);
+		for (s = 0; room.seats[s].taken; s++) {
+		}
+		Seat& seat = room.seats[s];
+		seat.taken = true;
+		seat.token = token;
+		seat.input = 0;
+		seat.ack = NO_VIEW;
+		seat.held = PI_NONE;
+		for (int v = 0; v < VIEW_HISTORY; v++) {
+			ClearView(seat.sent[v]);
+		}
+		// The cycle carries on from wherever the computer had got it to
+		if (room.clients++ == 0) {
+			startRound(room);
+			activeRooms++;
+		}
+		tokens[token] = { r, s };
+		clients++;
+	}
+
+	Room& room = *rooms[r];
+	Seat& seat = room.seats[s];
+	{
+		lock_guard<mutex> guard(room.lock);
+		seat.address = address;
+		seat.port = port;
+	}
+	seat.lastHeard = NetNow();
+
+	uint8_t packet[ROOM_HEADER + 8];
+	writeHeader(packet, ROOM_WELCOME, token);
+	writeU32(packet + ROOM_HEADER, (uint32_t)r);
+	packet[ROOM_HEADER + 4] = (uint8_t)s;
+	packet[ROOM_HEADER + 5] = (uint8_t)config.playersPerRoom;
+	packet[ROOM_HEADER + 6] = (uint8_t)(config.tickRate > 255 ? 255 : config.tickRate);
+	packet[ROOM_HEADER + 7] = (uint8_t)(config.updateRate > 255 ? 255 : config.updateRate);
+	sendTo(address, port, packet, sizeof(packet));
+
+}
+
+void GameServer::freeSeat(Room& room, int seat) {
+
+	if (!room.seats[seat].taken) {
+		return;
+	}
+	room.seats[seat].taken = false;
+	clients--;
+	if (--room.clients == 0) {
+		activeRooms--;
+	}
+
+}
+
+void GameServer::dropIdleClients(long long now) {
+
+	long long timeout = (long long)config.clientTimeout * 1000000;
+	for (auto it = tokens.begin(); it != tokens.end();) {
+		Room& room = *rooms[it->second.room];
+		if (now - room.seats[it->second.seat].lastHeard > timeout) {
+			lock_guard<mutex> guard(room.lock);
+			freeSeat(room, it->second.seat);
+			it = tokens.erase(it);
+		}
+		else {
+			it++;
+		}
+	}
+
+}
+
+void GameServer::sendTo(uint32_t address, uint16_t port, const uint8_t* data, size_t size) {
+
+	sockaddr_in to;
+	memset(&to, 0, sizeof(to));
+	to.sin_family = AF_INET;
+	to.sin_addr.s_addr = address;
+	to.sin_port = port;
+	if (sendto(socketHandle, data, size, MSG_DONTWAIT, (const sockaddr*)&to, sizeof(to)) == (ssize_t)size) {
+		packetsSent++;
+		bytesSent += size;
+	}
+	else {
+		sendFailures++;
+	}
+
+}
+
+void GameServer::sendHeader(uint8_t type, uint32_t token, uint32_t address, uint16_t port) {
+
+	uint8_t packet[ROOM_HEADER];
+	writeHeader(packet, type, token);
+	sendTo(address, port, packet, sizeof(packet));
+
+}
+
+void GameServer::startRound(Room& room) {
+
+	// The last round's trails go with the arena
+	room.round++;
+	room.arena.reset();
+	SimConfig sim = DefaultSimConfig(config.width, config.height, config.playersPerRoom);
+	sim.seed = config.seed * 2654435761u + (uint32_t)room.index * 40503u + room.round;
+	SimStart(room.state, sim, &room.arena);
+
+}
+
+void GameServer::tickRooms(long long due) {
+
+	// A room still busy with the last tick skips this one rather than queueing behind itself
+	vector<Room*> batch;
+	for (size_t r = 0; r < rooms.size(); r++) {
+		Room& room = *rooms[r];
+		if (room.clients == 0) {
+			continue;
+		}
+		if (room.busy.exchange(true)) {
+			overruns++;
+			continue;
+		}
+		batch.push_back(&room);
+		if ((int)batch.size() == config.roomsPerTask) {
+			submitTicks(batch, due);
+			batch.clear();
+		}
+	}
+	if (!batch.empty()) {
+		submitTicks(batch, due);
+	}
+
+}
+
+void GameServer::submitTicks(const vector<Room*>& batch, long long due) {
+
+	pool->submit([this, batch, due]() {
+		// CPU time like the event loop's, so the two add up to cores used
+		long long start = ThreadMicros();
+		for (Room* room : batch) {
+			{
+				lock_guard<mutex> guard(room->lock);
+				tickRoom(*room);
+			}
+			room->busy = false;
+			latency.record(NetNow() - due);
+		}
+		tickMicros += ThreadMicros() - start;
+	});
+
+}
+
+void GameServer::tickRoom(Room& room) {
+
+	if (room.clients == 0) {
+		return;
+	}
+	// The round's last update went out with the tick that ended it
+	if (room.state.over) {
+		startRound(room);
+	}
+
+	PLAYERINPUT inputs[MAX_PLAYERS];
+	for (int i = 0; i < room.state.config.players; i++) {
+		Seat& seat = room.seats[i];
+		if (!seat.taken) {
+			inputs[i] = RandomPolicy(room.state, i, room.rng);
+			continue;
+		}
+		// Keys are held until the client's next input says otherwise
+		uint16_t input = seat.input.exchange(0);
+		if (input & INPUT_ARRIVED) {
+			seat.held = (PLAYERINPUT)(input & 0xff);
+		}
+		inputs[i] = seat.held;
+	}
+	SimStep(room.state, inputs);
+	room.tick++;
+	ticks++;
+
+	if (room.tick % (uint32_t)(config.tickRate / config.updateRate) == 0 || room.state.over) {
+		sendUpdates(room);
+	}
+
+}
+
+void GameServer::sendUpdates(Room& room) {
+
+	uint8_t packet[Transport::MAX_DATAGRAM];
+	for (int i = 0; i < config.playersPerRoom; i++) {
+		Seat& seat = room.seats[i];
+		if (!seat.taken) {
+			continue;
+		}
+
+		// Against the newest view the client has, if we still have it and it is of this round
+		uint32_t ack = seat.ack;
+		const ClientView* baseline = nullptr;
+		if (ack != NO_VIEW && seat.sent[ack % VIEW_HISTORY].tick == ack && seat.sent[ack % VIEW_HISTORY].round == room.round) {
+			baseline = &seat.sent[ack % VIEW_HISTORY];
+		}
+		ClientView view;
+		writeHeader(packet, ROOM_STATE, seat.token);
+		size_t size = EncodeDelta(room.state, room.round, room.tick, baseline, packet + ROOM_HEADER,
+			sizeof(packet) - ROOM_HEADER, view);
+		if (size == 0) {
+			continue;
+		}
+		seat.sent[room.tick % VIEW_HISTORY] = view;
+		if (baseline != nullptr) {
+			deltaUpdates++;
+		}
+		else {
+			fullUpdates++;
+		}
+		sendTo(seat.address, seat.port, packet, ROOM_HEADER + size);
+	}
+
+}
+
+ServerStats GameServer::getStats() const {
+
+	ServerStats stats;
+	stats.activeRooms = activeRooms;
+	stats.clients = clients;
+	stats.ticks = ticks;
+	stats.overruns = overruns;
+	stats.lateTimers = lateTimers;
+	stats.packetsReceived = packetsReceived;
+	stats.packetsIgnored = packetsIgnored;
+	stats.packetsSent = packetsSent;
+	stats.sendFailures = sendFailures;
+	stats.bytesSent = bytesSent;
+	stats.fullUpdates = fullUpdates;
+	stats.deltaUpdates = deltaUpdates;
+	stats.tickSeconds = tickMicros / 1e6;
+	stats.loopSeconds = (loopMicros - loopMicrosBase) / 1e6;
+	stats.wallSeconds = (NetNow() - statsStart) / 1e6;
+	return stats;
+
+}
+
+void GameServer::resetStats() {
+
+	ticks = 0;
+	overruns = 0;
+	lateTimers = 0;
+	packetsReceived = 0;
+	packetsIgnored = 0;
+	packetsSent = 0;
+	sendFailures = 0;
+	bytesSent = 0;
+	fullUpdates = 0;
+	deltaUpdates = 0;
+	tickMicros = 0;
+	loopMicrosBase = (long long)loopMicros;
+	statsStart = NetNow();
+	latency.reset();
+
+}
@@ -0,0 +1,180 @@
+#ifndef GAME_SERVER_H
+#define GAME_SERVER_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Arena.h"
+#include "RoomProtocol.h"
+#include "Simulation.h"
+#include "StateDelta.h"
+#include "ThreadPool.h"
+
+// Headless authoritative server for many independent rooms, Linux only:
+// the event loop is epoll over one UDP socket and a timerfd. Every timer
+// tick each room with a client in it is handed to a fixed ThreadPool to be
+// stepped, a few rooms to a task, while the loop goes back to reading
+// inputs. Clients only send keys; the server runs the rules and sends each
+// client updates delta-compressed against the last one it acknowledged.
+// Seats with no client are driven by RandomPolicy, and a room starts a new
+// round as soon as one ends.
+
+struct ServerConfig {
+	uint16_t port;				// 0 for any free port
+	int rooms;
+	int playersPerRoom;
+	int tickRate;				// Rule steps a second, as the front end's setTickRate()
+	int updateRate;				// Updates a second to each client, as the front end's setFrameRate()
+	int workers;				// Threads stepping rooms, 0 for one per core
+	int roomsPerTask;
+	int width;					// Arena size
+	int height;
+	unsigned int seed;			// Room r's round n is seeded from seed, r and n
+	int clientTimeout;			// Seconds without a datagram before a client's seat is freed
+};
+
+ServerConfig DefaultServerConfig(int rooms = 100, int playersPerRoom = 4);
+
+// Microsecond latencies counted into 10 us buckets up to 100 ms, from any
+// thread without locking
+class LatencyHistogram {
+public:
+	static const int BUCKETS = 10000;
+	static const long long BUCKET_WIDTH = 10;
+
+protected:
+	std::atomic<unsigned long long> counts[BUCKETS + 1];	// The last counts everything longer
+	std::atomic<unsigned long long> total;
+	std::atomic<long long> longest;
+
+public:
+	LatencyHistogram();
+
+	void reset();
+	void record(long long micros);
+	// Upper edge of the bucket holding that fraction of the samples, 0 for none
+	long long percentile(double fraction) const;
+	unsigned long long getCount() const { return total; };
+	long long getMax() const { return longest; };
+
+};
+
+struct ServerStats {
+	int activeRooms;					// Rooms with a client in them
+	int clients;
+	unsigned long long ticks;			// Room ticks stepped
+	unsigned long long overruns;		// Room ticks skipped because the last one was still running
+	unsigned long long lateTimers;		// Timer ticks the event loop woke too late for
+	unsigned long long packetsReceived;
+	unsigned long long packetsIgnored;
+	unsigned long long packetsSent;
+	unsigned long long sendFailures;	// Socket buffer full, the datagram went nowhere
+	unsigned long long bytesSent;
+	unsigned long long fullUpdates;
+	unsigned long long deltaUpdates;
+	double tickSeconds;					// Worker CPU time spent stepping rooms and sending updates
+	double loopSeconds;					// CPU time of the event loop
+	double wallSeconds;					// Since start or the last resetStats()
+
+	double coresUsed() const { return wallSeconds > 0 ? (tickSeconds + loopSeconds) / wallSeconds : 0.0; };
+	double roomsPerCore() const { return coresUsed() > 0 ? activeRooms / coresUsed() : 0.0; };
+};
+
+class GameServer {
+protected:
+	// One seat of a room. The event loop fills it in under the room's lock;
+	// input and ack are left by the loop for the room's next tick without it.
+	struct Seat {
+		bool taken;
+		uint32_t token;
+		uint32_t address;				// Network byte order, updated from the latest datagram
+		uint16_t port;
+		long long lastHeard;
+		std::atomic<uint16_t> input;	// Keys seen since the last tick, bit 8 set if any input arrived
+		std::atomic<uint32_t> ack;		// Newest update the client has applied, NO_VIEW for none
+		PLAYERINPUT held;				// Keys the cycle steps with until the client says otherwise
+		ClientView sent[VIEW_HISTORY];	// What each recent update left the client with
+	};
+
+	struct Room {
+		std::mutex lock;				// Held by a tick, and by the loop to change seats
+		std::atomic<bool> busy;			// A tick is queued or running
+		int index;
+		int clients;
+		uint32_t round;
+		uint32_t tick;					// Counts on across rounds, updates are named by it
+		GameState state;
+		Arena arena;					// Trails of the current round
+		std::mt19937 rng;				// For the seats without a client
+		Seat seats[MAX_PLAYERS];
+	};
+
+	struct SeatRef {
+		int room;
+		int seat;
+	};
+
+	ServerConfig config;
+	int socketHandle;
+	int epollHandle;
+	int timerHandle;
+	std::string error;
+	std::vector<std::unique_ptr<Room>> rooms;
+	std::unordered_map<uint32_t, SeatRef> tokens;	// Every seated client, event loop only
+	std::unique_ptr<ThreadPool> pool;
+	long long startTime;
+	unsigned long long timerTicks;
+	std::atomic<int> activeRooms;
+	std::atomic<int> clients;
+
+	std::atomic<unsigned long long> ticks, overruns, lateTimers;
+	std::atomic<unsigned long long> packetsReceived, packetsIgnored, packetsSent, sendFailures, bytesSent;
+	std::atomic<unsigned long long> fullUpdates, deltaUpdates;
+	std::atomic<long long> tickMicros, loopMicros, loopMicrosBase, statsStart;
+	LatencyHistogram latency;
+
+	bool fail(const char* what);
+	void startRound(Room& room);
+	void handlePacket(const uint8_t* data, size_t size, uint32_t address, uint16_t port);
+	void join(uint32_t token, uint32_t wanted, uint32_t address, uint16_t port);
+	void freeSeat(Room& room, int seat);
+	void dropIdleClients(long long now);
+	void sendTo(uint32_t address, uint16_t port, const uint8_t* data, size_t size);
+	void sendHeader(uint8_t type, uint32_t token, uint32_t address, uint16_t port);
+	// Queue a tick of every room with a client in it, due at the given time
+	void tickRooms(long long due);
+	void submitTicks(const std::vector<Room*>& batch, long long due);
+	void tickRoom(Room& room);
+	void sendUpdates(Room& room);
+
+public:
+	GameServer();
+	virtual ~GameServer();
+	GameServer(const GameServer&) = delete;
+	GameServer& operator=(const GameServer&) = delete;
+
+	// Bind the socket and set up the rooms and workers. Nothing ticks until run().
+	bool start(const ServerConfig& config);
+	// The event loop, on the calling thread until stop turns true. Checked at
+	// least every tick.
+	void run(const std::atomic<bool>& stop);
+	// Wait out the ticks in flight and close everything. Call once run() returned.
+	void close();
+
+	ServerStats getStats() const;
+	// Start the counters, timings and latencies over, as after a warm-up
+	void resetStats();
+	const LatencyHistogram& getLatency() const { return latency; };
+
+	const ServerConfig& getConfig() const { return config; };
+	// The bound port, the one picked when config.port was 0
+	uint16_t getPort() const;
+	const std::string& getError() const { return error; };
+
+};
+
+#endif
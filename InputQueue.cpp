@@ -0,0 +1,99 @@
+#include "InputQueue.h"
+
+using namespace std;
+
+InputQueue::InputQueue() {
+
+	for (int i = 0; i < MAX_PLAYERS; i++) {
+		held[i] = PI_NONE;
+	}
+	lastLatency = 0;
+	events = 0;
+
+}
+
+long long InputQueue::Now() {
+
+	return chrono::duration_cast<chrono::microseconds>(
+		chrono::steady_clock::now().time_since_epoch()).count();
+
+}
+
+void InputQueue::push(const InputEvent& event) {
+
+	if (event.player < 0 || event.player >= MAX_PLAYERS || event.input == PI_NONE) {
+		return;
+	}
+	lock_guard<mutex> guard(lock);
+	pending.push_back(event);
+
+}
+
+void InputQueue::press(int player, PLAYERINPUT input) {
+
+	InputEvent event = { Now(), player, input, true };
+	push(event);
+
+}
+
+void InputQueue::release(int player, PLAYERINPUT input) {
+
+	InputEvent event = { Now(), player, input, false };
+	push(event);
+
+}
+
+void InputQueue::releaseAll() {
+
+	long long now = Now();
+	lock_guard<mutex> guard(lock);
+	for (int i = 0; i < MAX_PLAYERS; i++) {
+		InputEvent event = { now, i, PI_UP | PI_DOWN | PI_LEFT | PI_RIGHT, false };
+		pending.push_back(event);
+	}
+
+}
+
+void InputQueue::drain(PLAYERINPUT inputs[MAX_PLAYERS]) {
+
+	// Swap the queue out so pushes only wait for the swap
+	draining.clear();
+	{
+		lock_guard<mutex> guard(lock);
+		pending.swap(draining);
+	}
+
+	PLAYERINPUT tapped[MAX_PLAYERS];
+	for (int i = 0; i < MAX_PLAYERS; i++) {
+		tapped[i] = PI_NONE;
+	}
+
+	for (size_t i = 0; i < draining.size(); i++) {
+		const InputEvent& event = draining[i];
+		if (event.pressed) {
+			held[event.player] |= event.input;
+			tapped[event.player] |= event.input;
+		}
+		else {
+			held[event.player] &= ~event.input;
+		}
+	}
+
+	for (int i = 0; i < MAX_PLAYERS; i++) {
+		inputs[i] = held[i] | tapped[i];
+	}
+
+	lastLatency = draining.empty() ? 0 : Now() - draining[0].time;
+	events += draining.size();
+
+}
+
+void InputQueue::clear() {
+
+	lock_guard<mutex> guard(lock);
+	pending.clear();
+	for (int i = 0; i < MAX_PLAYERS; i++) {
+		held[i] = PI_NONE;
+	}
+
+}
@@ -0,0 +1,52 @@
+#ifndef INPUT_QUEUE_H
+#define INPUT_QUEUE_H
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include "Simulation.h"
+
+// Timestamped press and release events, fed from window messages or any
+// other source (bots, replays, a headless driver) and drained once per
+// simulation tick. A key tapped and released between two ticks still
+// counts for the next tick, so short presses are never lost.
+struct InputEvent {
+	long long time;			// Microseconds on InputQueue::Now()
+	int player;
+	PLAYERINPUT input;
+	bool pressed;
+};
+
+class InputQueue {
+protected:
+	std::mutex lock;
+	std::vector<InputEvent> pending;
+	std::vector<InputEvent> draining;
+	PLAYERINPUT held[MAX_PLAYERS];
+	long long lastLatency;
+	unsigned long long events;
+
+public:
+	InputQueue();
+
+	static long long Now();
+
+	// Safe to call from any thread
+	void push(const InputEvent& event);
+	void press(int player, PLAYERINPUT input);
+	void release(int player, PLAYERINPUT input);
+	// Let go of every held key, e.g. when the window loses focus
+	void releaseAll();
+
+	// Fold the queued events into this tick's inputs: whatever is held
+	// plus anything pressed since the last drain
+	void drain(PLAYERINPUT inputs[MAX_PLAYERS]);
+	void clear();
+
+	// Age in microseconds of the oldest event taken by the last drain
+	long long getLastLatency() { return lastLatency; };
+	unsigned long long getEvents() { return events; };
+
+};
+
+#endif
@@ -2,32 +2,112 @@
 #include "Windows.h"
 #include "Resource.h"
 #include "BitMap.h"
+#include "Simulation.h"
+#include "SearchAI.h"
+#include "MctsAI.h"
+#include "Replay.h"
+#include "InputQueue.h"
+#include "SoftwareRenderer.h"
+#include "SpriteAtlas.h"
+#include "AssetArchive.h"
+#include "BatchRunner.h"
+#include "Camera.h"
+#include "Lockstep.h"
+#include "Rollback.h"
+#include "UdpTransport.h"
+#include "shellapi.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#pragma comment(lib, "shell32.lib")
 
 // Global variables
 GameEngine* game;
-BitMap* bck, * blue0, * blue90, * blue180, * blue270; // Blue different directions
-BitMap* orange0, * orange90, * orange180, * orange270; // Orange different directions
-BitMap* blueCurrentBitmap, * orangeCurrentBitmap; // Current bitmaps to be drawn for blue and orange players
+std::shared_ptr<BitMap> bck; // Background, shared through the engine's asset cache
+std::shared_ptr<BitMap> cycleSheet; // Every cycle frame of every player in one bitmap
+SpriteAtlas cycleAtlas; // Where each frame sits in cycleSheet
+const int cycleBitmapSets = 2; // Players with bitmaps of their own, the others get blue's tinted in their color
+const char* const cycleFrameNames[cycleBitmapSets][4] = {
+    { "CycleBlue_0", "CycleBlue_90", "CycleBlue_180", "CycleBlue_270" },
+    { "CycleOrange_0", "CycleOrange_90", "CycleOrange_180", "CycleOrange_270" }
+};
+const UINT cycleFrameIds[cycleBitmapSets][4] = {
+    { IDB_CycleBlue_0, IDB_CycleBlue_90, IDB_CycleBlue_180, IDB_CycleBlue_270 },
+    { IDB_CycleOrange_0, IDB_CycleOrange_90, IDB_CycleOrange_180, IDB_CycleOrange_270 }
+};
+AssetArchive assetArchive; // Res/Assets.lcpk from Tools/PackAssets, mapped once if it exists
+bool assetArchiveTried = false;
 
 HDC offScreen = nullptr;
 HBITMAP offScreenBitMap = nullptr;
 
-const int MAX_SPEED = 4; // Define maximum speed for movement
-
-int blueSpeedx = 0, orangeSpeedx = 0; // Speed in the x-direction for blue and orange players
-int blueSpeedy = 0, orangeSpeedy = 0; // Speed in the y-direction for blue and orange players
-int blueXPos = 0, orangeXPos = 0;       // Current x-positions for blue and orange players
-int blueYPos = 0, orangeYPos = 0;       // Current y-positions for blue and orange players
-
-std::vector<std::pair<int, int>> blueTrailPoints, orangeTrailPoints; // Trail points history
-
-bool blueChangingDirection = false, orangeChangingDirection = false; // Flags to indicate if direction is currently changing
-
-const int directionChangeDelay = 10; // Define the delay in frames
-int blueDirectionChangeCounter = 0, orangeDirectionChangeCounter = 0; // Counters to track direction change delay 
+HDC trailLayer = nullptr;              // Background plus every trail segment drawn so far
+HBITMAP trailLayerBitMap = nullptr;
+bool trailLayerStale = true;           // Set when the background has to be redrawn into the trail layer
+
+// Key bindings, arrow keys for the blue player and WASD for the orange player
+struct KeyBinding {
+    WPARAM key;
+    PLAYERINPUT input;
+};
+const KeyBinding arrowKeys[4] = {
+    { VK_UP, PI_UP },
+    { VK_DOWN, PI_DOWN },
+    { VK_LEFT, PI_LEFT },
+    { VK_RIGHT, PI_RIGHT }
+};
+const KeyBinding wasdKeys[4] = {
+    { 0x57, PI_UP },    // W key
+    { 0x53, PI_DOWN },  // S key
+    { 0x41, PI_LEFT },  // A key
+    { 0x44, PI_RIGHT }  // D key
+};
+
+// Everything the front end keeps for one player, the rules keep its cycle and trail in gameState
+struct Player {
+    const wchar_t* name;        // Announced when the player wins
+    const KeyBinding* keys;     // Four bindings, null for a cycle the computer or another peer drives
+    CpuPlayer* cpu;             // Replaces the keyboard when set
+    bool remote;                // Driven by another peer in a lockstep game
+    int cpuKind;                // 0 keyboard, 1 alpha-beta search, 2 Monte Carlo tree search, 3 random policy
+    int frames[4];              // Atlas frame of the cycle facing each direction, -1 if missing
+    HPEN trailPen;              // Created once with the trail layer
+    TrailMark paintedTrail;     // How far the trail had got when last drawn into the trail layer
+};
+const wchar_t* const playerNames[MAX_PLAYERS] = {
+    L"Blue", L"Orange", L"Green", L"Red", L"Yellow", L"Cyan", L"Pink", L"Purple",
+    L"White", L"Lime", L"Teal", L"Brown", L"Sky", L"Violet", L"Grey", L"Olive"
+};
+Player players[MAX_PLAYERS]; // Indexed like gameState.cycles, set up in GameInitialize()
+int playerCount = 2; // Cycles per round, F4 steps through 2, 4, 8 and 16
+
+GameState gameState; // Positions, speeds, trails and result of the current round
+int arenaSize = 0; // Width and height of the arena, 0 for the window's size, F5 switches to 20,000 x 20,000
+Camera camera; // Part of the arena in the window when it doesn't all fit, follows localPlayer
+ReplayRecorder recorder; // Inputs of the current round, saved to LastRound.lcr when it ends
+int localPlayer = PLAYER_BLUE; // The cycle the camera follows, the one this window plays in a lockstep game
+bool lockstepMode = false; // Set by -lockstep on the command line, see StartLockstep()
+UdpTransport lockstepSocket; // Inputs to and from the other peers
+LockstepSession lockstep; // Steps gameState once every peer's input for the tick is in
+bool rollbackMode = false; // Set by -rollback, the lockstep game guesses remote input instead of waiting for it
+RollbackSession rollback; // Steps gameState on guessed input and corrects it when the real input arrives
+NetSession* lockstepSession = &lockstep; // Whichever of the two is playing, for the seed and the report
+PLAYERINPUT lockstepInput = PI_NONE; // Local keys seen while stalled, go out with the next tick
+unsigned int lockstepRound = 0; // Rounds played, every peer seeds the next round from it
+InputQueue inputQueue; // Key presses and releases since the last tick
+unsigned long long tickHeapAllocations = 0; // operator new calls made inside GameTick() this round
+
+bool softwareRendering = false; // F3 switches between GDI and the software renderer
+SoftwareRenderer softwareRenderer; // Framebuffer renderer, no GDI until the frame is presented
+RenderImages renderImages; // Pixels of the bitmaps below for the software renderer
+PixelImage bckPixels;
 
 // Function prototypes
 BOOL GameInitialize(HINSTANCE currInstance);
+void GameTick();
 void GameLoop();
 void GameEnd();
 void GameStart(HWND hwnd);
@@ -35,11 +115,28 @@ void GameActivate(HWND hwnd);
 void GameDeactivate(HWND hwnd);
 void GamePaint(HDC hdc);
 void HandleKeys();
+void KeyDown(WPARAM key);
+void KeyUp(WPARAM key);
 void MouseButtonDown(int x, int y, bool left);
 void MouseButtonUp(int x, int y, bool left);
 void MouseMove(int x, int y);
 bool SpriteCollision(Sprite* hitter, Sprite* hittee);
 void HandleCollision();
+void ReportRoundAllocations();
+void EndRound(LPCWSTR message);
+RECT CycleFrame(int player);
+bool LoadCycleAtlas(HDC hdc);
+void ReportAssets(long long microseconds);
+void LoadRenderImages(HDC hdc);
+void ToggleCpuPlayer(int player);
+void FillCpuPlayers();
+void TintCycleFrames();
+COLORREF PlayerColorRef(int player);
+void DrawNewSegments(HDC hdc, int player);
+void FollowCycle();
+void PaintView(HDC hdc);
+bool StartLockstep();
+void ReportLockstep();
 
 // Game initialization
 BOOL GameInitialize(HINSTANCE currInstance) {
@@ -48,20 +145,45 @@ BOOL GameInitialize(HINSTANCE currInstance) {
     if (game == NULL) {
         return FALSE;
     }
-    // Set the frame rate
+    // Blue and orange have the keyboard, every other cycle is driven by the computer
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        Player& player = players[i];
+        player.name = playerNames[i];
+        player.keys = i == PLAYER_BLUE ? arrowKeys : (i == PLAYER_ORANGE ? wasdKeys : nullptr);
+        player.cpu = nullptr;
+        player.remote = false;
+        player.cpuKind = 0;
+        for (int d = 0; d < 4; d++) {
+            player.frames[d] = -1;
+        }
+        player.trailPen = nullptr;
+        player.paintedTrail = Trail().mark();
+    }
+    // Join a lockstep game if the command line asks for one
+    if (!StartLockstep()) {
+        return FALSE;
+    }
+    // Set the frame rate, and run the simulation at twice that
     game->setFrameRate(30);
+    game->setTickRate(60);
     return TRUE;
 }
 
-// Main game loop
-void GameLoop() {
+// Advance the game by one simulation tick
+void GameTick() {
+    // Count heap allocations, a tick should make none once the round is under way
+    unsigned long long heapBefore = HeapAllocationCount();
     // Update sprite positions
     game->updateSprites();
-    // Handle user input
+    // Handle user input and advance the simulation
     HandleKeys();
-    // Check for collision with window edges
+    tickHeapAllocations += HeapAllocationCount() - heapBefore;
+    // React to the round ending
     HandleCollision();
+}
 
+// Render one frame
+void GameLoop() {
     // Get window handle and device context
     HWND hwnd = game->getWnd();
     HDC hdc = GetDC(hwnd);
@@ -73,30 +195,33 @@ void GameLoop() {
         SelectObject(offScreen, offScreenBitMap);
     }
 
-    // Paint the game
-    GamePaint(offScreen);
+    // Keep the followed cycle in view
+    FollowCycle();
+
+    if (softwareRendering) {
+        // Render into the framebuffer and hand it to the window in one call
+        softwareRenderer.render(gameState, renderImages, camera);
+        Framebuffer& frame = softwareRenderer.getFrame();
+        BITMAPINFO info = {};
+        info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+        info.bmiHeader.biWidth = frame.getPitch();
+        info.bmiHeader.biHeight = -frame.getHeight();
+        info.bmiHeader.biPlanes = 1;
+        info.bmiHeader.biBitCount = 32;
+        info.bmiHeader.biCompression = BI_RGB;
+        SetDIBitsToDevice(hdc, 0, 0, frame.getWidth(), frame.getHeight(), 0, 0, 0, frame.getHeight(),
+            frame.getPixels(), &info, DIB_RGB_COLORS);
+    }
+    else {
+        // Paint the game
+        GamePaint(offScreen);
 
-    // Copy the off-screen buffer to the window
-    BitBlt(hdc, 0, 0, game->getWidth(), game->getHeight(), offScreen, 0, 0, SRCCOPY);
+        // Copy the off-screen buffer to the window
+        BitBlt(hdc, 0, 0, game->getWidth(), game->getHeight(), offScreen, 0, 0, SRCCOPY);
+    }
 
     // Release device context
     ReleaseDC(hwnd, hdc);
-
-    // Increment direction change counters
-    if (blueChangingDirection) {
-        blueDirectionChangeCounter++;
-        if (blueDirectionChangeCounter >= directionChangeDelay) {
-            blueDirectionChangeCounter = 0;
-            blueChangingDirection = false; // Reset blueChangingDirection flag after delay
-        }
-    }
-    if (orangeChangingDirection) {
-        orangeDirectionChangeCounter++;
-        if (orangeDirectionChangeCounter >= directionChangeDelay) {
-            orangeDirectionChangeCounter = 0;
-            orangeChangingDirection = false; // Reset orangeChangingDirection flag after delay
-        }
-    }
 }
 
 // Game cleanup
@@ -108,16 +233,31 @@ void GameEnd() {
     if (offScreen != nullptr) {
         DeleteDC(offScreen);
     }
+    // Delete the trail layer and its pens
+    if (trailLayerBitMap != nullptr) {
+        DeleteObject(trailLayerBitMap);
+    }
+    if (trailLayer != nullptr) {
+        DeleteDC(trailLayer);
+    }
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        if (players[i].trailPen != nullptr) {
+            DeleteObject(players[i].trailPen);
+            players[i].trailPen = nullptr;
+        }
+    }
     // Delete background and bitmap objects
-    delete bck;
-    delete blue0;
-    delete blue90;
-    delete blue180;
-    delete blue270;
-    delete orange0;
-    delete orange90;
-    delete orange180;
-    delete orange270;
+    bck.reset();
+    cycleSheet.reset();
+    cycleAtlas.clear();
+    // Delete computer players
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        delete players[i].cpu;
+        players[i].cpu = nullptr;
+        players[i].cpuKind = 0;
+    }
+    // Leave the lockstep game, the other peers stall from here on
+    lockstepSocket.close();
     // Delete game engine
     delete game;
 
@@ -126,41 +266,62 @@ void GameEnd() {
 
 // Start/restart the game
 void GameStart(HWND hwnd) {
-    // Initialize random number generator
-    srand(GetTickCount());
+    // Initialize random number generator, the seed is kept with the round so it can be reproduced.
+    // Lockstep peers have to agree on it without asking each other.
+    unsigned int seed = lockstepMode ? lockstepSession->getConfig().session + lockstepRound : GetTickCount();
+    srand(seed);
     // Get window device context
     HDC hdc = GetDC(hwnd);
-    // Load background and bitmap images
-    bck = new BitMap(hdc, L"Res/Background.bmp");
-    blue0 = new BitMap(hdc, L"Res/CycleBlue_0.bmp");
-    blue90 = new BitMap(hdc, L"Res/CycleBlue_90.bmp");
-    blue180 = new BitMap(hdc, L"Res/CycleBlue_180.bmp");
-    blue270 = new BitMap(hdc, L"Res/CycleBlue_270.bmp");
-    orange0 = new BitMap(hdc, L"Res/CycleOrange_0.bmp");
-    orange90 = new BitMap(hdc, L"Res/CycleOrange_90.bmp");
-    orange180 = new BitMap(hdc, L"Res/CycleOrange_180.bmp");
-    orange270 = new BitMap(hdc, L"Res/CycleOrange_270.bmp");
-    // Set the initial bitmaps to blue0 and orange0
-    blueCurrentBitmap = blue0;
-    orangeCurrentBitmap = orange180;
+    std::chrono::steady_clock::time_point loadStart = std::chrono::steady_clock::now();
+    // One packed archive replaces the separate bitmap files when it is there
+    if (!assetArchiveTried) {
+        assetArchive.open(L"Res/Assets.lcpk");
+        assetArchiveTried = true;
+    }
+    // Bitmaps come from the asset cache, so a restart finds them already loaded
+    if (assetArchive.find((uint32_t)IDB_Background) >= 0) {
+        bck = game->getAssets().loadBitMap(hdc, assetArchive, IDB_Background);
+    }
+    else {
+        bck = game->getAssets().loadBitMap(hdc, L"Res/Background.bmp");
+    }
+    cycleSheet = game->getAssets().find(L"Cycles");
+    if (cycleSheet == nullptr) {
+        LoadCycleAtlas(hdc);
+        // Give the software renderer its own copy of the pixels
+        LoadRenderImages(hdc);
+    }
+    ReportAssets(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - loadStart).count());
     // Release device context
     ReleaseDC(hwnd, hdc);
 
-    // Set initial positions of the bitmaps to custom positions
-    blueXPos = 250;    // Blue starting x-position
-    blueYPos = 350;    // Blue starting y-position
-    orangeXPos = 250;  // Orange starting x-position
-    orangeYPos = 25;  // Orange starting y-position
-
-    // Reset speeds to zero
-    blueSpeedx = 0;
-    orangeSpeedx = 0;
-    blueSpeedy = 0;
-    orangeSpeedy = 0;
-
-    // Clear trailPoints vectors
-    blueTrailPoints.clear();
-    orangeTrailPoints.clear();
+    // Reset positions, speeds and trails, the trail leaves from the centre of the cycle bitmap
+    int width = arenaSize > 0 ? arenaSize : game->getWidth();
+    int height = arenaSize > 0 ? arenaSize : game->getHeight();
+    SimConfig config = DefaultSimConfig(width, height, playerCount);
+    config.seed = seed;
+    if (players[PLAYER_BLUE].frames[DIR_UP] >= 0) {
+        const SpriteRect& frame = cycleAtlas.getFrame(players[PLAYER_BLUE].frames[DIR_UP]);
+        config.cycleWidth = frame.width;
+        config.cycleHeight = frame.height;
+    }
+    // Everything from the last round goes at once, trails are kept in the round arena
+    game->resetRound();
+    SimStart(gameState, config, &game->getRoundArena());
+    if (rollbackMode) {
+        rollback.startRound(gameState);
+    }
+    FillCpuPlayers();
+    camera.setView(game->getWidth(), game->getHeight());
+    camera.setArena(width, height);
+    FollowCycle();
+    tickHeapAllocations = 0;
+    recorder.start(config, game->getTickRate());
+
+    // Wipe the trails from the trail layer on the next paint
+    trailLayerStale = true;
+    softwareRenderer.reset();
 }
 
 // Game activation handler
@@ -170,139 +331,149 @@ void GameActivate(HWND hwnd) {
 
 // Game deactivation handler
 void GameDeactivate(HWND hwnd) {
-    // Blank
+    // Key releases go to the newly focused window, so don't leave keys stuck down
+    inputQueue.releaseAll();
 }
 
 // Game painting function
 void GamePaint(HDC hdc) {
-    if (bck != nullptr) {
-        // Draw the background
-        bck->draw(hdc, 0, 0);
+    // Create the trail layer and trail pens the first time we paint
+    if (trailLayer == nullptr) {
+        trailLayer = CreateCompatibleDC(hdc);
+        trailLayerBitMap = CreateCompatibleBitmap(hdc, game->getWidth(), game->getHeight());
+        SelectObject(trailLayer, trailLayerBitMap);
+        for (int i = 0; i < MAX_PLAYERS; i++) {
+            players[i].trailPen = CreatePen(PS_SOLID, 1, PlayerColorRef(i)); // Same colors as the software renderer
+        }
     }
 
-    if (blueCurrentBitmap != nullptr) {
-        // Draw the current blue bitmap at its current position
-        blueCurrentBitmap->draw(hdc, blueXPos, blueYPos);
+    // A large arena is drawn through the camera, without the trail layer
+    if (!camera.showsWholeArena()) {
+        PaintView(hdc);
+        return;
+    }
 
-        // Draw blue trail
-        HPEN bluePen = CreatePen(PS_SOLID, 0.5, RGB(0, 0, 255)); // Blue color
-        HPEN hOldPen = (HPEN)SelectObject(hdc, bluePen);
-        for (size_t i = 1; i < blueTrailPoints.size(); ++i) {
-            MoveToEx(hdc, blueTrailPoints[i - 1].first, blueTrailPoints[i - 1].second, nullptr);
-            LineTo(hdc, blueTrailPoints[i].first, blueTrailPoints[i].second);
+    if (trailLayerStale && bck != nullptr) {
+        // Draw the background into the trail layer, trails are added on top as they grow
+        bck->draw(trailLayer, 0, 0);
+        for (int i = 0; i < MAX_PLAYERS; i++) {
+            players[i].paintedTrail = Trail().mark();
         }
-        SelectObject(hdc, hOldPen);
-        DeleteObject(bluePen);
+        trailLayerStale = false;
+    }
 
-        // Add current position to blueTrailPoints
-        blueTrailPoints.push_back(std::make_pair(blueXPos + blueCurrentBitmap->getWidth() / 2, blueYPos + blueCurrentBitmap->getHeight() / 2));
+    // Draw only the segments added since the last paint
+    for (int i = 0; i < gameState.config.players; i++) {
+        DrawNewSegments(trailLayer, i);
     }
 
-    if (orangeCurrentBitmap != nullptr) {
-        // Draw the current orange bitmap at its current position
-        orangeCurrentBitmap->draw(hdc, orangeXPos, orangeYPos);
+    // Copy the background and trails in one blit, whatever the trail length
+    BitBlt(hdc, 0, 0, game->getWidth(), game->getHeight(), trailLayer, 0, 0, SRCCOPY);
 
-        // Draw orange trail
-        HPEN orangePen = CreatePen(PS_SOLID, 0.5, RGB(255, 165, 0)); // Orange color
-        HPEN hOldPen = (HPEN)SelectObject(hdc, orangePen);
-        for (size_t i = 1; i < orangeTrailPoints.size(); ++i) {
-            MoveToEx(hdc, orangeTrailPoints[i - 1].first, orangeTrailPoints[i - 1].second, nullptr);
-            LineTo(hdc, orangeTrailPoints[i].first, orangeTrailPoints[i].second);
+    // Draw each cycle at its current position, every frame comes from the one sheet
+    for (int i = 0; i < gameState.config.players; i++) {
+        if (cycleSheet != nullptr) {
+            cycleSheet->draw(hdc, gameState.cycles[i].xPos, gameState.cycles[i].yPos, CycleFrame(i));
         }
-        SelectObject(hdc, hOldPen);
-        DeleteObject(orangePen);
+    }
+}
 
-        // Add current position to orangeTrailPoints
-        orangeTrailPoints.push_back(std::make_pair(orangeXPos + orangeCurrentBitmap->getWidth() / 2, orangeYPos + orangeCurrentBitmap->getHeight() / 2));
+// Queue a key press for the next tick
+void KeyDown(WPARAM key) {
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        for (int k = 0; players[i].keys != nullptr && k < 4; k++) {
+            if (players[i].keys[k].key == key) {
+                inputQueue.press(i, players[i].keys[k].input);
+            }
+        }
+    }
+
+    // Cycle a player through keyboard, search and Monte Carlo control
+    if (key == VK_F1) {
+        ToggleCpuPlayer(localPlayer);
+    }
+    // Anything else that changes the round would desync a lockstep game
+    else if (lockstepMode) {
+        return;
+    }
+    else if (key == VK_F2) {
+        ToggleCpuPlayer(PLAYER_ORANGE);
+    }
+    // Compare the software renderer against GDI
+    else if (key == VK_F3) {
+        softwareRendering = !softwareRendering;
+    }
+    // Restart with twice as many cycles, back to two after sixteen
+    else if (key == VK_F4) {
+        playerCount = playerCount * 2 > MAX_PLAYERS ? 2 : playerCount * 2;
+        GameStart(game->getWnd());
+    }
+    // Restart in the large arena, or back in one the size of the window
+    else if (key == VK_F5) {
+        arenaSize = arenaSize > 0 ? 0 : 20000;
+        GameStart(game->getWnd());
+    }
+}
+
+// Queue a key release for the next tick
+void KeyUp(WPARAM key) {
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        for (int k = 0; players[i].keys != nullptr && k < 4; k++) {
+            if (players[i].keys[k].key == key) {
+                inputQueue.release(i, players[i].keys[k].input);
+            }
+        }
     }
 }
 
 // Handle keyboard input
 void HandleKeys() {
-    // Reset speed in one direction when the corresponding arrow key is pressed
-    if (!blueChangingDirection) {
-        if (GetAsyncKeyState(VK_UP) < 0 && blueSpeedy >= 0) {
-            // Move up for blue player
-            blueSpeedy = max(-MAX_SPEED, --blueSpeedy);
-            // Reset horizontal speed
-            blueSpeedx = 0;
-            // Set the current bitmap to blue0
-            blueCurrentBitmap = blue0;
-            blueChangingDirection = true;
+    PLAYERINPUT inputs[MAX_PLAYERS];
+
+    // Everything pressed since the last tick, even if it has been let go already
+    inputQueue.drain(inputs);
+
+    // Only our own cycle's input goes out, the session steps once every peer's is in
+    if (lockstepMode) {
+        if (players[localPlayer].cpu != nullptr) {
+            lockstepInput = players[localPlayer].cpu->chooseInput(gameState);
         }
-        else if (GetAsyncKeyState(VK_DOWN) < 0 && blueSpeedy <= 0) {
-            // Move down for blue player
-            blueSpeedy = min(MAX_SPEED, ++blueSpeedy);
-            // Reset horizontal speed
-            blueSpeedx = 0;
-            // Set the current bitmap to blue180
-            blueCurrentBitmap = blue180;
-            blueChangingDirection = true;
+        else {
+            lockstepInput |= inputs[localPlayer];
         }
-        else if (GetAsyncKeyState(VK_LEFT) < 0 && blueSpeedx >= 0) {
-            // Move left for blue player
-            blueSpeedx = max(-MAX_SPEED, --blueSpeedx);
-            // Reset vertical speed
-            blueSpeedy = 0;
-            // Set the current bitmap to blue270
-            blueCurrentBitmap = blue270;
-            blueChangingDirection = true;
+        if (!rollbackMode) {
+            if (lockstep.advance(gameState, lockstepInput, inputs)) {
+                lockstepInput = PI_NONE;
+                recorder.record(inputs, gameState);
+            }
+            return;
         }
-        else if (GetAsyncKeyState(VK_RIGHT) < 0 && blueSpeedx <= 0) {
-            // Move right for blue player
-            blueSpeedx = min(MAX_SPEED, ++blueSpeedx);
-            // Reset vertical speed
-            blueSpeedy = 0;
-            // Set the current bitmap to blue90
-            blueCurrentBitmap = blue90;
-            blueChangingDirection = true;
+        if (rollback.advance(gameState, lockstepInput) == ROLLBACK_STEPPED) {
+            lockstepInput = PI_NONE;
         }
-    }
-
-    if (!orangeChangingDirection) {
-        if ((GetAsyncKeyState(0x57) < 0 || GetAsyncKeyState(0x57) == -32767) && orangeSpeedy >= 0) { // W key
-            // Move up for orange player
-            orangeSpeedy = max(-MAX_SPEED, --orangeSpeedy);
-            // Reset horizontal speed
-            orangeSpeedx = 0;
-            // Set the current bitmap to orange0
-            orangeCurrentBitmap = orange0;
-            orangeChangingDirection = true;
-        }
-        else if ((GetAsyncKeyState(0x53) < 0 || GetAsyncKeyState(0x53) == -32767) && orangeSpeedy <= 0) { // S key
-            // Move down for orange player
-            orangeSpeedy = min(MAX_SPEED, ++orangeSpeedy);
-            // Reset horizontal speed
-            orangeSpeedx = 0;
-            // Set the current bitmap to orange180
-            orangeCurrentBitmap = orange180;
-            orangeChangingDirection = true;
+        // A rollback can take back trail that has been drawn, so everything is drawn again
+        if (rollback.takeCorrected()) {
+            trailLayerStale = true;
+            softwareRenderer.reset();
         }
-        else if ((GetAsyncKeyState(0x41) < 0 || GetAsyncKeyState(0x41) == -32767) && orangeSpeedx >= 0) { // A key
-            // Move left for orange player
-            orangeSpeedx = max(-MAX_SPEED, --orangeSpeedx);
-            // Reset vertical speed
-            orangeSpeedy = 0;
-            // Set the current bitmap to orange270
-            orangeCurrentBitmap = orange270;
-            orangeChangingDirection = true;
+        // Only ticks no later input can change go in the replay
+        SettledTick settledTick;
+        while (rollback.nextSettled(settledTick)) {
+            recorder.record(settledTick.inputs, settledTick.roundTick, settledTick.over, settledTick.hash);
         }
-        else if ((GetAsyncKeyState(0x44) < 0 || GetAsyncKeyState(0x44) == -32767) && orangeSpeedx <= 0) { // D key
-            // Move right for orange player
-            orangeSpeedx = min(MAX_SPEED, ++orangeSpeedx);
-            // Reset vertical speed
-            orangeSpeedy = 0;
-            // Set the current bitmap to orange90
-            orangeCurrentBitmap = orange90;
-            orangeChangingDirection = true;
+        return;
+    }
+
+    // Computer players replace the keyboard for their cycle
+    for (int i = 0; i < gameState.config.players; i++) {
+        if (players[i].cpu != nullptr) {
+            inputs[i] = players[i].cpu->chooseInput(gameState);
         }
     }
 
-    // Update the positions based on current speeds
-    blueXPos = min(game->getWidth() - blueCurrentBitmap->getWidth(), max(0, blueXPos + blueSpeedx));
-    blueYPos = min(game->getHeight() - blueCurrentBitmap->getHeight(), max(0, blueYPos + blueSpeedy));
-    orangeXPos = min(game->getWidth() - orangeCurrentBitmap->getWidth(), max(0, orangeXPos + orangeSpeedx));
-    orangeYPos = min(game->getHeight() - orangeCurrentBitmap->getHeight(), max(0, orangeYPos + orangeSpeedy));
+    // Turn, move, collide and extend the trails
+    SimStep(gameState, inputs);
+    recorder.record(inputs, gameState);
 }
 
 // Handle mouse button down event
@@ -322,63 +493,394 @@ bool SpriteCollision(Sprite* hitter, Sprite* hittee) {
     return false;
 }
 
-// Handle collision with window edges and trails
-// Handle collision with window edges and trails
-void HandleCollision() {
-    // Check if the bitmaps touch the edges of the window
-    if (blueXPos <= 0 || blueXPos >= game->getWidth() - blueCurrentBitmap->getWidth() ||
-        blueYPos <= 0 || blueYPos >= game->getHeight() - blueCurrentBitmap->getHeight()) {
-        int result = MessageBox(game->getWnd(), L"Orange player Wins!\nDo you want to restart the game?", L"Game Over", MB_YESNO | MB_ICONQUESTION);
-        if (result == IDYES) {
-            GameStart(game->getWnd());
+// Pick the atlas frame matching a player's direction, empty if it is missing
+RECT CycleFrame(int player) {
+    RECT rect = { 0, 0, 0, 0 };
+    int frame = players[player].frames[gameState.cycles[player].direction];
+    if (frame >= 0) {
+        const SpriteRect& source = cycleAtlas.getFrame(frame);
+        SetRect(&rect, source.x, source.y, source.x + source.width, source.y + source.height);
+    }
+    return rect;
+}
+
+// Pack the cycle frames from the asset archive, else load a saved atlas, else pack the separate bitmaps
+bool LoadCycleAtlas(HDC hdc) {
+    if (assetArchive.find((uint32_t)cycleFrameIds[0][0]) >= 0) {
+        cycleAtlas.clear();
+        for (int i = 0; i < cycleBitmapSets; i++) {
+            for (int d = 0; d < 4; d++) {
+                PixelImage frame;
+                if (assetArchive.readImage(assetArchive.find((uint32_t)cycleFrameIds[i][d]), frame)) {
+                    cycleAtlas.add(cycleFrameNames[i][d], frame);
+                }
+            }
         }
-        else {
-            GameEnd();
+        cycleAtlas.pack();
+    }
+    else if (!cycleAtlas.load("Res/Cycles.bmp", "Res/Cycles.atlas")) {
+        cycleAtlas.clear();
+        for (int i = 0; i < cycleBitmapSets; i++) {
+            for (int d = 0; d < 4; d++) {
+                BmpFile file;
+                PixelImage frame;
+                if (file.open("Res/" + std::string(cycleFrameNames[i][d]) + ".bmp")) {
+                    file.getView().toPixelImage(frame);
+                    cycleAtlas.add(cycleFrameNames[i][d], frame);
+                }
+            }
         }
+        cycleAtlas.pack();
     }
 
-    if (orangeXPos <= 0 || orangeXPos >= game->getWidth() - orangeCurrentBitmap->getWidth() ||
-        orangeYPos <= 0 || orangeYPos >= game->getHeight() - orangeCurrentBitmap->getHeight()) {
-        int result = MessageBox(game->getWnd(), L"Blue player Wins!\nDo you want to restart the game?", L"Game Over", MB_YESNO | MB_ICONQUESTION);
-        if (result == IDYES) {
-            GameStart(game->getWnd());
+    for (int i = 0; i < cycleBitmapSets; i++) {
+        for (int d = 0; d < 4; d++) {
+            players[i].frames[d] = cycleAtlas.find(cycleFrameNames[i][d]);
         }
-        else {
-            GameEnd();
+    }
+    TintCycleFrames();
+
+    BitMap* sheet = new BitMap();
+    sheet->create(hdc, cycleAtlas.getSheet());
+    cycleSheet = game->getAssets().insert(L"Cycles", sheet);
+    return cycleSheet != nullptr;
+}
+
+// Write the asset load time and cache counters to the debugger output
+void ReportAssets(long long microseconds) {
+    AssetCache& assets = game->getAssets();
+    wchar_t report[200];
+    swprintf_s(report, L"LightCycles: assets from %s in %lld us, %zu assets, %zu KB resident, %llu hits, %llu misses\n",
+        assetArchive.isOpen() ? L"Res/Assets.lcpk" : L"Res/*.bmp", microseconds,
+        assets.getCount(), assets.getResidentBytes() / 1024, assets.getHits(), assets.getMisses());
+    OutputDebugString(report);
+}
+
+// Copy the background out of its bitmap and point at the cycle atlas for the software renderer
+void LoadRenderImages(HDC hdc) {
+    renderImages = RenderImages();
+    if (bck != nullptr && bck->getPixels(hdc, bckPixels)) {
+        renderImages.background = &bckPixels;
+    }
+    renderImages.sprites = &cycleAtlas.getSheet();
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        for (int d = 0; d < 4; d++) {
+            if (players[i].frames[d] >= 0) {
+                renderImages.cycles[i][d] = cycleAtlas.getFrame(players[i].frames[d]);
+            }
         }
     }
+    softwareRenderer.resize(game->getWidth(), game->getHeight());
+}
+
+// Switch a player from keyboard to search, then Monte Carlo, then back to keyboard
+void ToggleCpuPlayer(int player) {
+    // Both searches only know two cycles, so the others stay on the keyboard
+    if (player < 0 || player >= BOARD_PLAYERS) {
+        return;
+    }
+
+    // Leave time in the tick for the other player and the frame
+    long long budget = 1000000 / game->getTickRate() / 3;
+
+    Player& toggled = players[player];
+    delete toggled.cpu;
+    toggled.cpu = nullptr;
+    toggled.cpuKind = (toggled.cpuKind + 1) % 3;
 
-    // Check if the blue player collides with the orange trail or its own trail
-    for (size_t i = 1; i < orangeTrailPoints.size(); ++i) {
-        int x1 = orangeTrailPoints[i - 1].first, y1 = orangeTrailPoints[i - 1].second;
-        int x2 = orangeTrailPoints[i].first, y2 = orangeTrailPoints[i].second;
-        if ((blueXPos + blueCurrentBitmap->getWidth() / 2 >= min(x1, x2) && blueXPos + blueCurrentBitmap->getWidth() / 2 <= max(x1, x2)) &&
-            (blueYPos + blueCurrentBitmap->getHeight() / 2 >= min(y1, y2) && blueYPos + blueCurrentBitmap->getHeight() / 2 <= max(y1, y2))) {
-            int result = MessageBox(game->getWnd(), L"Orange player Wins!\nDo you want to restart the game?", L"Game Over", MB_YESNO | MB_ICONQUESTION);
-            if (result == IDYES) {
-                GameStart(game->getWnd());
+    if (toggled.cpuKind == 1) {
+        toggled.cpu = new SearchAI(player, budget);
+    }
+    else if (toggled.cpuKind == 2) {
+        MctsAI* mcts = new MctsAI(player, 1000000);
+        mcts->setTimeBudget(budget);
+        toggled.cpu = mcts;
+    }
+}
+
+// Give every cycle in the round without keys a computer driver, and drop the drivers of cycles left out
+void FillCpuPlayers() {
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        Player& player = players[i];
+        if (player.remote) {
+            continue;
+        }
+        if (i >= gameState.config.players && player.keys == nullptr) {
+            delete player.cpu;
+            player.cpu = nullptr;
+            player.cpuKind = 0;
+        }
+        else if (player.keys == nullptr && player.cpu == nullptr) {
+            player.cpu = new PolicyPlayer(i, RandomPolicy, gameState.config.seed + i);
+            player.cpuKind = 3;
+        }
+    }
+}
+
+// Add frames for the players without bitmaps: blue's cycle with its blue swapped for their color
+void TintCycleFrames() {
+    bool added = false;
+    for (int i = cycleBitmapSets; i < MAX_PLAYERS; i++) {
+        uint32_t color = PlayerColor(i);
+        for (int d = 0; d < 4; d++) {
+            char name[32];
+            sprintf_s(name, "Cycle%d_%d", i, d * 90);
+            int source = players[PLAYER_BLUE].frames[d];
+            if (cycleAtlas.find(name) >= 0 || source < 0) {
+                continue;
             }
-            else {
-                GameEnd();
+            const SpriteRect& rect = cycleAtlas.getFrame(source);
+            PixelImage frame;
+            frame.resize(rect.width, rect.height);
+            for (int y = 0; y < rect.height; y++) {
+                const uint32_t* row = cycleAtlas.getPixels(source) + (size_t)y * cycleAtlas.getSheet().width;
+                for (int x = 0; x < rect.width; x++) {
+                    uint32_t pixel = row[x];
+                    if (pixel != PIXEL_MAGENTA) {
+                        // The lowest channel is how much white is mixed in, the highest how bright it is
+                        int r = (pixel >> 16) & 0xff, g = (pixel >> 8) & 0xff, b = pixel & 0xff;
+                        int white = r < g ? (r < b ? r : b) : (g < b ? g : b);
+                        int bright = r > g ? (r > b ? r : b) : (g > b ? g : b);
+                        int tint[3] = { (int)(color >> 16) & 0xff, (int)(color >> 8) & 0xff, (int)color & 0xff };
+                        for (int c = 0; c < 3; c++) {
+                            tint[c] = (tint[c] * (bright - white) + 255 * white) / 255;
+                        }
+                        pixel = PixelColor(tint[0], tint[1], tint[2]);
+                        if (pixel == PIXEL_MAGENTA) {
+                            pixel ^= 1; // Never turn opaque into the color key
+                        }
+                    }
+                    frame.pixels[(size_t)y * rect.width + x] = pixel;
+                }
             }
-            return;
+            cycleAtlas.add(name, frame);
+            added = true;
         }
     }
+    if (added) {
+        cycleAtlas.pack();
+    }
+    for (int i = cycleBitmapSets; i < MAX_PLAYERS; i++) {
+        for (int d = 0; d < 4; d++) {
+            char name[32];
+            sprintf_s(name, "Cycle%d_%d", i, d * 90);
+            players[i].frames[d] = cycleAtlas.find(name);
+        }
+    }
+}
+
+// A player's trail color for GDI
+COLORREF PlayerColorRef(int player) {
+    uint32_t color = PlayerColor(player);
+    return RGB((color >> 16) & 0xff, (color >> 8) & 0xff, color & 0xff);
+}
+
+// Draw the trail segments added since the last paint into the trail layer
+void DrawNewSegments(HDC hdc, int player) {
+    const Trail& trail = gameState.cycles[player].trail;
+    Trail::SegmentRange added = trail.segmentsSince(players[player].paintedTrail);
+    if (added.begin() == added.end()) {
+        return;
+    }
+    HPEN hOldPen = (HPEN)SelectObject(hdc, players[player].trailPen);
+    MoveToEx(hdc, (*added.begin()).x1, (*added.begin()).y1, nullptr);
+    for (TrailSegment segment : added) {
+        LineTo(hdc, segment.x2, segment.y2); // Each segment starts where the last one ended
+    }
+    SelectObject(hdc, hOldPen);
+    players[player].paintedTrail = trail.mark();
+}
 
-    // Check if the orange player collides with the blue trail or its own trail
-    for (size_t i = 1; i < blueTrailPoints.size(); ++i) {
-        int x1 = blueTrailPoints[i - 1].first, y1 = blueTrailPoints[i - 1].second;
-        int x2 = blueTrailPoints[i].first, y2 = blueTrailPoints[i].second;
-        if ((orangeXPos + orangeCurrentBitmap->getWidth() / 2 >= min(x1, x2) && orangeXPos + orangeCurrentBitmap->getWidth() / 2 <= max(x1, x2)) &&
-            (orangeYPos + orangeCurrentBitmap->getHeight() / 2 >= min(y1, y2) && orangeYPos + orangeCurrentBitmap->getHeight() / 2 <= max(y1, y2))) {
-            int result = MessageBox(game->getWnd(), L"Blue player Wins!\nDo you want to restart the game?", L"Game Over", MB_YESNO | MB_ICONQUESTION);
-            if (result == IDYES) {
-                GameStart(game->getWnd());
+// Point the camera at our cycle, or at the first one still going once ours has crashed
+void FollowCycle() {
+    int followed = localPlayer;
+    for (int i = 0; i < gameState.config.players && !gameState.cycles[followed].alive; i++) {
+        if (gameState.cycles[i].alive) {
+            followed = i;
+        }
+    }
+    const CycleState& cycle = gameState.cycles[followed];
+    camera.follow(cycle.headX(gameState.config), cycle.headY(gameState.config));
+}
+
+// Paint the part of a large arena the camera sees: background tiles, trail segments in view, cycles in view
+void PaintView(HDC hdc) {
+    int left = camera.getX();
+    int top = camera.getY();
+
+    // The background repeats across the arena
+    if (bck != nullptr && bck->getWidth() > 0 && bck->getHeight() > 0) {
+        for (int y = top - top % bck->getHeight(); y < top + camera.getHeight(); y += bck->getHeight()) {
+            for (int x = left - left % bck->getWidth(); x < left + camera.getWidth(); x += bck->getWidth()) {
+                bck->draw(hdc, x - left, y - top);
             }
-            else {
-                GameEnd();
+        }
+    }
+
+    // Every frame draws the visible trail from scratch, it is only a few hundred pixels of lines
+    for (int i = 0; i < gameState.config.players; i++) {
+        HPEN hOldPen = (HPEN)SelectObject(hdc, players[i].trailPen);
+        for (TrailSegment segment : gameState.cycles[i].trail.segments()) {
+            if (camera.clip(segment)) {
+                MoveToEx(hdc, segment.x1 - left, segment.y1 - top, nullptr);
+                LineTo(hdc, segment.x2 - left, segment.y2 - top);
             }
-            return;
         }
+        SelectObject(hdc, hOldPen);
+    }
+
+    for (int i = 0; i < gameState.config.players; i++) {
+        const CycleState& cycle = gameState.cycles[i];
+        RECT frame = CycleFrame(i);
+        if (cycleSheet != nullptr && camera.sees(cycle.xPos, cycle.yPos,
+            cycle.xPos + frame.right - frame.left - 1, cycle.yPos + frame.bottom - frame.top - 1)) {
+            cycleSheet->draw(hdc, cycle.xPos - left, cycle.yPos - top, frame);
+        }
+    }
+
+    // Back in an arena the size of the window, the trail layer starts over
+    trailLayerStale = true;
+}
+
+// Announce the winner and ask whether to play again
+void EndRound(LPCWSTR message) {
+    int result = MessageBox(game->getWnd(), message, L"Game Over", MB_YESNO | MB_ICONQUESTION);
+    if (result == IDYES) {
+        GameStart(game->getWnd());
+    }
+    else {
+        GameEnd();
+    }
+}
+
+// Handle the end of a round once a cycle has hit an edge or a trail
+void HandleCollision() {
+    if (!gameState.over) {
+        return;
+    }
+    // An end reached on guessed input may yet be rolled back
+    if (rollbackMode && rollback.getPrediction() > 0) {
+        return;
+    }
+
+    // Keep the round for playback before the next one starts
+    recorder.save("LastRound.lcr");
+    ReportRoundAllocations();
+
+    // Every peer ends the round on the same tick, so they all start the next one without asking
+    if (lockstepMode) {
+        ReportLockstep();
+        lockstepRound++;
+        GameStart(game->getWnd());
+        return;
+    }
+
+    if (gameState.winner >= 0) {
+        wchar_t message[100];
+        swprintf_s(message, L"%s player Wins!\nDo you want to restart the game?", players[gameState.winner].name);
+        EndRound(message);
     }
+    else {
+        EndRound(L"It's a draw!\nDo you want to restart the game?");
+    }
+}
+
+// Write the round's heap and arena allocation counts to the debugger output
+void ReportRoundAllocations() {
+    const Arena& arena = game->getRoundArena();
+    wchar_t report[200];
+    swprintf_s(report, L"LightCycles: %u ticks, %llu heap allocations in ticks, %llu arena allocations, %zu KB arena used, %llu arena chunks\n",
+        gameState.tick, tickHeapAllocations, arena.getAllocations(), arena.getBytesUsed() / 1024, arena.getHeapAllocations());
+    OutputDebugString(report);
+}
+
+// Join a lockstep game when started as
+//   LightCycles -lockstep <player> <host:port of player 0> <host:port of player 1> ... [-delay <ticks>]
+// Every peer lists the same addresses in the same order and only the player number differs.
+// -rollback in place of -lockstep plays on guessed input instead of waiting, every peer has to use the same.
+// False if the command line asks for a game that can't be set up.
+bool StartLockstep() {
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (argv == nullptr || argc < 2 || (wcscmp(argv[1], L"-lockstep") != 0 && wcscmp(argv[1], L"-rollback") != 0)) {
+        LocalFree(argv);
+        return true;
+    }
+    rollbackMode = wcscmp(argv[1], L"-rollback") == 0;
+
+    // The address list names the session, so a peer started for another game is ignored.
+    // Rollback hides the trip with guesses and needs only a tick of delay to smooth out jitter.
+    SessionConfig config = { 0, argc > 2 ? _wtoi(argv[2]) : -1, rollbackMode ? 1 : 6, 2166136261u };
+    std::vector<std::string> hosts;
+    std::vector<uint16_t> ports;
+    bool parsed = true;
+    for (int i = 3; i < argc; i++) {
+        if (wcscmp(argv[i], L"-delay") == 0 && i + 1 < argc) {
+            config.inputDelay = _wtoi(argv[++i]);
+            continue;
+        }
+        char address[256];
+        const char* colon = nullptr;
+        if (WideCharToMultiByte(CP_UTF8, 0, argv[i], -1, address, sizeof(address), NULL, NULL) > 0) {
+            colon = strrchr(address, ':');
+        }
+        if (colon == nullptr) {
+            parsed = false;
+            break;
+        }
+        hosts.push_back(std::string(address, colon - address));
+        ports.push_back((uint16_t)atoi(colon + 1));
+        for (const char* c = address; *c != 0; c++) {
+            config.session = (config.session ^ (uint8_t)*c) * 16777619u;
+        }
+    }
+    LocalFree(argv);
+
+    config.players = (int)hosts.size();
+    bool started = parsed && config.players >= 2 && config.players <= MAX_PLAYERS &&
+        config.localPlayer >= 0 && config.localPlayer < config.players &&
+        lockstepSocket.open(ports[config.localPlayer]);
+    for (int i = 0; started && i < config.players; i++) {
+        started = i == config.localPlayer || lockstepSocket.setPeer(i, hosts[i], ports[i]);
+    }
+    if (rollbackMode) {
+        lockstepSession = &rollback;
+    }
+    started = started && (rollbackMode ? rollback.start(config, &lockstepSocket) : lockstep.start(config, &lockstepSocket));
+    if (!started) {
+        wchar_t message[300];
+        swprintf_s(message, L"Can't start the lockstep game. %S\n\nUsage: LightCycles -lockstep|-rollback <player> "
+            L"<host:port> <host:port> ... [-delay <ticks>]", lockstepSocket.getError().c_str());
+        MessageBox(nullptr, message, L"LightCycles", MB_OK | MB_ICONERROR);
+        return false;
+    }
+
+    // Our cycle takes the arrow keys, the others move as their peers say
+    lockstepMode = true;
+    // The peers stall without our input, so keep ticking when another window has focus
+    game->setRunInBackground(TRUE);
+    localPlayer = config.localPlayer;
+    playerCount = config.players;
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        players[i].keys = i == localPlayer ? arrowKeys : nullptr;
+        players[i].remote = i != localPlayer && i < config.players;
+    }
+    return true;
+}
+
+// Write the lockstep round trip, stalls, rollbacks and traffic to the debugger output, and the round trip to the title bar
+void ReportLockstep() {
+    const SessionStats& stats = lockstepSession->getStats();
+    wchar_t report[400];
+    swprintf_s(report, L"LightCycles: %s tick %u, round trip %lld ms, %llu stalls, %llu rollbacks (%llu ticks stepped again, %u deepest), "
+        L"%llu packets sent, %llu received, %llu ignored%s\n", rollbackMode ? L"rollback" : L"lockstep",
+        lockstepSession->getTick(), lockstepSession->getMaxRoundTrip() / 1000, stats.stalls, stats.rollbacks, stats.resimulated,
+        stats.deepestRollback, stats.packetsSent, stats.packetsReceived, stats.packetsIgnored,
+        lockstepSession->isDesynced() ? L", DESYNCED" : L"");
+    OutputDebugString(report);
+
+    wchar_t title[100];
+    swprintf_s(title, L"LightCycles - %s - %lld ms, %llu stalls, %llu rollbacks", players[localPlayer].name,
+        lockstepSession->getMaxRoundTrip() / 1000, stats.stalls, stats.rollbacks);
+    SetWindowText(game->getWnd(), title);
 }
@@ -0,0 +1,41 @@
+#include "Lockstep.h"
+#include <cstring>
+
+using namespace std;
+
+bool LockstepSession::advance(GameState& state, PLAYERINPUT localInput, PLAYERINPUT stepped[]) {
+
+	if (transport == nullptr) {
+		return false;
+	}
+
+	receivePackets();
+
+	// With no delay the tick needs this input, so it goes in before the check
+	scheduleLocalInput(localInput);
+
+	bool ready = hasAllInputs(tick);
+	if (ready) {
+		PLAYERINPUT now[MAX_PLAYERS];
+		for (int i = 0; i < MAX_PLAYERS; i++) {
+			now[i] = i < config.players ? inputs[tick % WINDOW][i] : PI_NONE;
+		}
+		SimStep(state, now);
+		if (stepped != nullptr) {
+			memcpy(stepped, now, sizeof(now));
+		}
+
+		// Every tick stepped here is final
+		setHash(tick, StateHash(state));
+		tick++;
+		stats.ticks++;
+		settle(tick);
+	}
+	else {
+		stats.stalls++;
+	}
+
+	sendPackets();
+	return ready;
+
+}
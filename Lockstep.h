@@ -0,0 +1,24 @@
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include "NetSession.h"
+
+// Peer-to-peer lockstep. A tick is stepped once every player's input for
+// it is in, so all peers feed SimStep() the same inputs and stay identical
+// without ever sending state or guessing. When the input delay covers the
+// one-way trip nobody waits; a tick still missing an input stalls, and
+// the game holds still until it turns up.
+class LockstepSession : public NetSession {
+public:
+	// One call per game tick. Reads what has arrived and schedules
+	// localInput inputDelay ticks ahead, unless a stall left the last one
+	// unused. If every input for the next tick is in, steps state with
+	// them, copies them to stepped if given (for a recorder) and returns
+	// true; otherwise counts a stall and leaves state alone. Sends to the
+	// peers either way, so stalled peers keep hearing. After the step that
+	// ends a round every peer does its SimStart() before the next call.
+	bool advance(GameState& state, PLAYERINPUT localInput, PLAYERINPUT stepped[] = nullptr);
+
+};
+
+#endif
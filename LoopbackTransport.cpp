@@ -0,0 +1,133 @@
+#include "LoopbackTransport.h"
+#include <cstring>
+
+using namespace std;
+
+LoopbackTransport::LoopbackTransport() {
+
+	network = nullptr;
+	player = -1;
+
+}
+
+void LoopbackTransport::attach(LoopbackNetwork* network, int player) {
+
+	this->network = network;
+	this->player = player;
+
+}
+
+bool LoopbackTransport::send(int peer, const uint8_t* data, size_t size) {
+
+	return network != nullptr && network->deliver(peer, data, size);
+
+}
+
+size_t LoopbackTransport::receive(uint8_t* buffer, size_t capacity) {
+
+	return network != nullptr ? network->collect(player, buffer, capacity) : 0;
+
+}
+
+LoopbackNetwork::LoopbackNetwork(int peers) : inboxes(peers > 0 ? peers : 0), ends(peers > 0 ? peers : 0) {
+
+	for (size_t i = 0; i < ends.size(); i++) {
+		ends[i].attach(this, (int)i);
+	}
+
+}
+
+bool LoopbackNetwork::deliver(int peer, const uint8_t* data, size_t size) {
+
+	if (peer < 0 || peer >= (int)inboxes.size() || size > Transport::MAX_DATAGRAM) {
+		return false;
+	}
+	lock_guard<mutex> guard(lock);
+	inboxes[peer].push_back(vector<uint8_t>(data, data + size));
+	return true;
+
+}
+
+size_t LoopbackNetwork::collect(int player, uint8_t* buffer, size_t capacity) {
+
+	lock_guard<mutex> guard(lock);
+	deque<vector<uint8_t>>& inbox = inboxes[player];
+	while (!inbox.empty()) {
+		vector<uint8_t> bytes = move(inbox.front());
+		inbox.pop_front();
+		if (!bytes.empty() && bytes.size() <= capacity) {
+			memcpy(buffer, bytes.data(), bytes.size());
+			return bytes.size();
+		}
+	}
+	return 0;
+
+}
+
+LossyTransport::LossyTransport(Transport* inner, const LinkConditions& conditions, unsigned int seed,
+	NetClock clock) : rng(seed) {
+
+	this->inner = inner;
+	this->conditions = conditions;
+	this->clock = clock;
+	arrived = 0;
+	dropped = 0;
+
+}
+
+void LossyTransport::hold(long long now, const uint8_t* data, size_t size) {
+
+	long long delay = conditions.latency;
+	if (conditions.jitter > 0) {
+		delay += (long long)(rng() % (unsigned long long)(conditions.jitter + 1));
+	}
+	Held datagram;
+	datagram.due = now + delay;
+	datagram.bytes.assign(data, data + size);
+	held.push_back(move(datagram));
+
+}
+
+bool LossyTransport::send(int peer, const uint8_t* data, size_t size) {
+
+	return inner->send(peer, data, size);
+
+}
+
+size_t LossyTransport::receive(uint8_t* buffer, size_t capacity) {
+
+	// Take in everything that has reached the far end of the link
+	long long now = clock();
+	uint8_t incoming[MAX_DATAGRAM];
+	size_t size;
+	while ((size = inner->receive(incoming, sizeof(incoming))) > 0) {
+		arrived++;
+		if ((int)(rng() % 100) < conditions.lossPercent) {
+			dropped++;
+			continue;
+		}
+		hold(now, incoming, size);
+		if ((int)(rng() % 100) < conditions.duplicatePercent) {
+			hold(now, incoming, size);
+		}
+	}
+
+	// Hand over the datagram that came due first, jitter lets it overtake
+	size_t first = held.size();
+	for (size_t i = 0; i < held.size(); i++) {
+		if (held[i].due <= now && (first == held.size() || held[i].due < held[first].due)) {
+			first = i;
+		}
+	}
+	if (first == held.size()) {
+		return 0;
+	}
+	size = held[first].bytes.size() <= capacity ? held[first].bytes.size() : 0;
+	if (size > 0) {
+		memcpy(buffer, held[first].bytes.data(), size);
+	}
+	held[first] = move(held.back());
+	held.pop_back();
+	return size > 0 ? size : receive(buffer, capacity);
+
+}
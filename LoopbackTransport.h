@@ -0,0 +1,94 @@
+#ifndef LOOPBACK_TRANSPORT_H
+#define LOOPBACK_TRANSPORT_H
+
+#include <deque>
+#include <mutex>
+#include <random>
+#include <vector>
+#include "Transport.h"
+
+class LoopbackNetwork;
+
+// One peer's end of a LoopbackNetwork
+class LoopbackTransport : public Transport {
+protected:
+	LoopbackNetwork* network;
+	int player;
+
+public:
+	LoopbackTransport();
+
+	void attach(LoopbackNetwork* network, int player);
+
+	virtual bool send(int peer, const uint8_t* data, size_t size);
+	virtual size_t receive(uint8_t* buffer, size_t capacity);
+
+};
+
+// Peers in one process, each datagram copied straight into the inbox of
+// the peer it is for. Nothing is lost or reordered; wrap the ends in a
+// LossyTransport for that. Safe to use from one thread per peer.
+class LoopbackNetwork {
+protected:
+	std::mutex lock;
+	std::vector<std::deque<std::vector<uint8_t>>> inboxes;
+	std::vector<LoopbackTransport> ends;
+
+public:
+	LoopbackNetwork(int peers);
+	LoopbackNetwork(const LoopbackNetwork&) = delete;
+	LoopbackNetwork& operator=(const LoopbackNetwork&) = delete;
+
+	Transport& getEnd(int player) { return ends[player]; };
+	int getPeers() const { return (int)ends.size(); };
+
+	bool deliver(int peer, const uint8_t* data, size_t size);
+	size_t collect(int player, uint8_t* buffer, size_t capacity);
+
+};
+
+// How a simulated link treats the datagrams sent over it
+struct LinkConditions {
+	int lossPercent;			// Chance of a datagram being dropped
+	int duplicatePercent;		// Chance of it arriving twice
+	long long latency;			// One-way delay in microseconds
+	long long jitter;			// Up to this much more, so later datagrams can overtake
+};
+
+// Another transport seen through a bad link: arriving datagrams are
+// dropped, doubled and held back as the conditions say, on the given
+// clock so a test can fast-forward. Wrap every peer's end and each way of
+// each link gets the conditions. Sends go straight through.
+class LossyTransport : public Transport {
+protected:
+	struct Held {
+		long long due;
+		std::vector<uint8_t> bytes;
+	};
+
+	Transport* inner;
+	LinkConditions conditions;
+	NetClock clock;
+	std::mt19937 rng;
+	std::vector<Held> held;
+	unsigned long long arrived;
+	unsigned long long dropped;
+
+	void hold(long long now, const uint8_t* data, size_t size);
+
+public:
+	LossyTransport(Transport* inner, const LinkConditions& conditions, unsigned int seed = 1,
+		NetClock clock = NetNow);
+
+	void setConditions(const LinkConditions& conditions) { this->conditions = conditions; };
+
+	virtual bool send(int peer, const uint8_t* data, size_t size);
+	virtual size_t receive(uint8_t* buffer, size_t capacity);
+
+	unsigned long long getArrived() const { return arrived; };
+	unsigned long long getDropped() const { return dropped; };
+	size_t getInFlight() const { return held.size(); };
+
+};
+
+#endif
@@ -0,0 +1,134 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include "Windows.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+MappedFile::MappedFile() {
+
+	bytes = nullptr;
+	length = 0;
+#ifdef _WIN32
+	mapping = NULL;
+#endif
+
+}
+
+MappedFile::~MappedFile() {
+
+	close();
+
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const wstring& fileName) {
+
+	close();
+
+	HANDLE file = CreateFileW(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0 ||
+		(unsigned long long)fileSize.QuadPart > (size_t)-1) {
+		CloseHandle(file);
+		return false;
+	}
+
+	// The mapping keeps the file open, the handle isn't needed past this
+	mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (mapping == NULL) {
+		return false;
+	}
+
+	bytes = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (bytes == nullptr) {
+		CloseHandle(mapping);
+		mapping = NULL;
+		return false;
+	}
+	length = (size_t)fileSize.QuadPart;
+	return true;
+
+}
+
+bool MappedFile::open(const string& fileName) {
+
+	int count = MultiByteToWideChar(CP_UTF8, 0, fileName.c_str(), -1, NULL, 0);
+	if (count <= 0) {
+		return false;
+	}
+	wstring wide(count, L'\0');
+	MultiByteToWideChar(CP_UTF8, 0, fileName.c_str(), -1, &wide[0], count);
+	wide.resize(count - 1);
+	return open(wide);
+
+}
+
+void MappedFile::close() {
+
+	if (bytes != nullptr) {
+		UnmapViewOfFile(bytes);
+		bytes = nullptr;
+	}
+	if (mapping != NULL) {
+		CloseHandle(mapping);
+		mapping = NULL;
+	}
+	length = 0;
+
+}
+
+#else
+
+bool MappedFile::open(const string& fileName) {
+
+	close();
+
+	int file = ::open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+	if (file < 0) {
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0) {
+		::close(file);
+		return false;
+	}
+
+	// The mapping keeps the file open, the descriptor isn't needed past this
+	void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	::close(file);
+	if (view == MAP_FAILED) {
+		return false;
+	}
+
+	bytes = (const uint8_t*)view;
+	length = (size_t)info.st_size;
+	return true;
+
+}
+
+void MappedFile::close() {
+
+	if (bytes != nullptr) {
+		munmap((void*)bytes, length);
+		bytes = nullptr;
+	}
+	length = 0;
+
+}
+
+#endif
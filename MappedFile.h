@@ -0,0 +1,37 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only memory map of a whole file, Win32 or POSIX underneath. The
+// bytes stay valid until close() or the destructor. Empty files fail to
+// open since there is nothing to map.
+class MappedFile {
+protected:
+	const uint8_t* bytes;
+	size_t length;
+#ifdef _WIN32
+	void* mapping;
+#endif
+
+public:
+	MappedFile();
+	virtual ~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& fileName);
+#ifdef _WIN32
+	bool open(const std::wstring& fileName);
+#endif
+	void close();
+
+	bool isOpen() const { return bytes != nullptr; };
+	const uint8_t* data() const { return bytes; };
+	size_t size() const { return length; };
+
+};
+
+#endif
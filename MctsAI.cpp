@@ -0,0 +1,331 @@
+#include "MctsAI.h"
+#include "BatchRunner.h"
+#include <cmath>
+
+using namespace std;
+
+static const int NODE_LEAF = 0,
+				 NODE_EXPANDING = 1,
+				 NODE_EXPANDED = 2;
+
+MctsAI::NodePool::NodePool(size_t capacity) {
+
+	this->capacity = capacity;
+	nodes.reset(new Node[capacity]);
+	used = 0;
+
+}
+
+MctsAI::Node* MctsAI::NodePool::allocate(int count) {
+
+	size_t first = used.fetch_add(count);
+	if (first + count > capacity) {
+		return nullptr;
+	}
+	return &nodes[first];
+
+}
+
+MctsAI::MctsAI(int player, int playouts, int threads, int trees, size_t poolNodes)
+	: pool(threads) {
+
+	this->player = player;
+	playoutBudget = playouts;
+	timeBudget = 0;
+	treeCount = trees > 0 ? trees : 1;
+	if (treeCount > pool.getThreadCount()) {
+		treeCount = pool.getThreadCount();
+	}
+	maxPlayoutTicks = 2000;
+	exploration = 0.7;
+	rootState = nullptr;
+	remaining = 0;
+	stats = MctsStats();
+
+	// Every tree needs at least its root
+	size_t treeNodes = poolNodes / treeCount > 0 ? poolNodes / treeCount : 1;
+	for (int i = 0; i < treeCount; i++) {
+		pools.push_back(unique_ptr<NodePool>(new NodePool(treeNodes)));
+		roots.push_back(nullptr);
+	}
+	for (int i = 0; i < pool.getThreadCount(); i++) {
+		workers.push_back(unique_ptr<Worker>(new Worker));
+	}
+
+}
+
+MctsAI::~MctsAI() {
+
+}
+
+void MctsAI::initNode(Node* node, DIRECTION move) {
+
+	node->visits.store(0, memory_order_relaxed);
+	node->virtualLoss.store(0, memory_order_relaxed);
+	node->score.store(0, memory_order_relaxed);
+	node->state.store(NODE_LEAF, memory_order_relaxed);
+	node->children = nullptr;
+	node->childCount = 0;
+	node->move = move;
+
+}
+
+PLAYERINPUT MctsAI::inputFor(const CycleState& cycle, DIRECTION direction) {
+
+	// A cycle that hasn't started needs its key pressed to go anywhere
+	if (cycle.speedx == 0 && cycle.speedy == 0) {
+		return DirectionInput(direction);
+	}
+	return direction != cycle.direction ? DirectionInput(direction) : PI_NONE;
+
+}
+
+int MctsAI::generateMoves(const GameState& state, int who, DIRECTION moves[3]) {
+
+	const CycleState& cycle = state.cycles[who];
+	moves[0] = cycle.direction;
+
+	if (!cycle.alive || cycle.changingDirection || (cycle.speedx == 0 && cycle.speedy == 0)) {
+		return 1;
+	}
+
+	int x = cycle.headX(state.config);
+	int y = cycle.headY(state.config);
+	DIRECTION candidates[3] = { cycle.direction, (DIRECTION)((cycle.direction + 1) & 3),
+		(DIRECTION)((cycle.direction + 3) & 3) };
+	int count = 0;
+	for (int i = 0; i < 3; i++) {
+		int dx, dy;
+		DirectionDelta(candidates[i], dx, dy);
+		if (!IsDeadly(state, x + dx, y + dy)) {
+			moves[count++] = candidates[i];
+		}
+	}
+
+	// Boxed in, any move loses
+	return count > 0 ? count : 1;
+
+}
+
+void MctsAI::applyMoves(GameState& state, const DIRECTION moves[MAX_PLAYERS]) {
+
+	PLAYERINPUT inputs[MAX_PLAYERS];
+	for (int i = 0; i < state.config.players; i++) {
+		inputs[i] = inputFor(state.cycles[i], moves[i]);
+	}
+
+	int ticks = state.config.directionChangeDelay > 0 ? state.config.directionChangeDelay : 1;
+	for (int tick = 0; tick < ticks && !state.over; tick++) {
+		SimStep(state, inputs);
+		for (int i = 0; i < state.config.players; i++) {
+			inputs[i] = PI_NONE;
+		}
+	}
+
+}
+
+MctsAI::Node* MctsAI::select(Node* node) {
+
+	int parentVisits = node->visits.load(memory_order_relaxed) + 1;
+	double logParent = log((double)parentVisits);
+	Node* best = &node->children[0];
+	double bestValue = -1.0;
+
+	for (int i = 0; i < node->childCount; i++) {
+		Node* child = &node->children[i];
+		int visits = child->visits.load(memory_order_relaxed) +
+			child->virtualLoss.load(memory_order_relaxed);
+		if (visits == 0) {
+			return child;
+		}
+		// Virtual losses count as visits that scored nothing
+		double mean = child->score.load(memory_order_relaxed) / (2.0 * visits);
+		double value = mean + exploration * sqrt(logParent / visits);
+		if (value > bestValue) {
+			bestValue = value;
+			best = child;
+		}
+	}
+
+	return best;
+
+}
+
+bool MctsAI::expand(Node* node, NodePool& nodes, const GameState& state, int who) {
+
+	int expected = NODE_LEAF;
+	if (!node->state.compare_exchange_strong(expected, NODE_EXPANDING, memory_order_acq_rel)) {
+		return expected == NODE_EXPANDED;
+	}
+
+	DIRECTION moves[3];
+	int count = generateMoves(state, who, moves);
+	Node* children = nodes.allocate(count);
+	if (children == nullptr) {
+		// Pool exhausted, this node stays a leaf for the rest of the search
+		return false;
+	}
+
+	for (int i = 0; i < count; i++) {
+		initNode(&children[i], moves[i]);
+	}
+	node->children = children;
+	node->childCount = count;
+	node->state.store(NODE_EXPANDED, memory_order_release);
+	return true;
+
+}
+
+int MctsAI::playout(GameState& state, mt19937& rng) {
+
+	unsigned int lastTick = state.tick + maxPlayoutTicks;
+	PLAYERINPUT inputs[MAX_PLAYERS];
+
+	while (!state.over && state.tick < lastTick) {
+		for (int i = 0; i < state.config.players; i++) {
+			inputs[i] = RandomPolicy(state, i, rng);
+		}
+		SimStep(state, inputs);
+	}
+
+	// Twice the result for this player, an unfinished playout is a draw
+	if (!state.over || state.winner < 0) {
+		return 1;
+	}
+	return state.winner == player ? 2 : 0;
+
+}
+
+void MctsAI::runWorker(int index) {
+
+	Worker& worker = *workers[index];
+	int tree = index % treeCount;
+	NodePool& nodes = *pools[tree];
+	Node* root = roots[tree];
+
+	// The only copy of the root this search, playouts are wound back to it
+	GameState& state = worker.state;
+	state = *rootState;
+	state.arena.setJournaling(true);
+	state.arena.forget(state.arena.getJournalPosition());
+	SimSave(state, worker.start);
+
+	while (remaining.fetch_sub(1) > 0) {
+		if (timeBudget > 0 && chrono::steady_clock::now() >= deadline) {
+			break;
+		}
+
+		SimRestore(state, worker.start);
+		DIRECTION moves[MAX_PLAYERS];
+		for (int i = 0; i < state.config.players; i++) {
+			moves[i] = state.cycles[i].direction;
+		}
+
+		// Selection and expansion
+		Node* node = root;
+		int length = 0;
+		worker.path[length++] = root;
+		while (!state.over && length < MAX_PATH) {
+			int depth = length - 1;
+			int who = moverAt(depth);
+			if (node->state.load(memory_order_acquire) != NODE_EXPANDED &&
+				!expand(node, nodes, state, who)) {
+				break;
+			}
+			Node* child = select(node);
+			child->virtualLoss.fetch_add(1, memory_order_relaxed);
+			worker.path[length++] = child;
+			moves[who] = child->move;
+			if (depth % 2 == 1) {
+				applyMoves(state, moves);
+			}
+			node = child;
+			if (child->visits.load(memory_order_relaxed) == 0) {
+				break;
+			}
+		}
+
+		// Our heading was picked without a reply, let the opponent answer at random
+		if ((length - 1) % 2 == 1 && !state.over) {
+			DIRECTION replies[3];
+			int count = generateMoves(state, 1 - player, replies);
+			moves[1 - player] = replies[worker.rng() % count];
+			applyMoves(state, moves);
+		}
+
+		int result = playout(state, worker.rng);
+
+		// Backpropagation, each node scored for whoever moved into it
+		root->visits.fetch_add(1, memory_order_relaxed);
+		for (int i = 1; i < length; i++) {
+			Node* visited = worker.path[i];
+			visited->visits.fetch_add(1, memory_order_relaxed);
+			visited->virtualLoss.fetch_sub(1, memory_order_relaxed);
+			visited->score.fetch_add(moverAt(i - 1) == player ? result : 2 - result,
+				memory_order_relaxed);
+		}
+	}
+
+}
+
+PLAYERINPUT MctsAI::chooseInput(const GameState& state) {
+
+	const CycleState& me = state.cycles[player];
+
+	if (state.over || !me.alive) {
+		return PI_NONE;
+	}
+	// Cycles sit still until their first key press
+	if (me.speedx == 0 && me.speedy == 0) {
+		return DirectionInput(me.direction);
+	}
+	// Nothing to decide while the turn delay runs
+	if (me.changingDirection) {
+		return PI_NONE;
+	}
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	deadline = start + chrono::microseconds(timeBudget);
+	rootState = &state;
+	remaining = playoutBudget;
+
+	for (int i = 0; i < treeCount; i++) {
+		pools[i]->reset();
+		roots[i] = pools[i]->allocate(1);
+		initNode(roots[i], me.direction);
+	}
+	for (int i = 0; i < (int)workers.size(); i++) {
+		workers[i]->rng.seed(state.config.seed ^ (state.tick * 2654435761u) ^ (unsigned int)i);
+		pool.submit([this, i] { runWorker(i); });
+	}
+	pool.wait();
+
+	// Merge the trees by how often each heading was tried at the root
+	unsigned long long visits[4] = { 0, 0, 0, 0 };
+	stats = MctsStats();
+	for (int i = 0; i < treeCount; i++) {
+		Node* root = roots[i];
+		stats.playouts += root->visits.load();
+		stats.nodes += pools[i]->getUsed();
+		if (root->state.load() != NODE_EXPANDED) {
+			continue;
+		}
+		for (int c = 0; c < root->childCount; c++) {
+			visits[root->children[c].move & 3] += root->children[c].visits.load();
+		}
+	}
+	stats.threads = (int)workers.size();
+	stats.trees = treeCount;
+	stats.microseconds = chrono::duration_cast<chrono::microseconds>(
+		chrono::steady_clock::now() - start).count();
+
+	DIRECTION best = me.direction;
+	for (int d = 0; d < 4; d++) {
+		if (visits[d] > visits[best]) {
+			best = (DIRECTION)d;
+		}
+	}
+
+	return best != me.direction ? DirectionInput(best) : PI_NONE;
+
+}
@@ -0,0 +1,117 @@
+#ifndef MCTS_AI_H
+#define MCTS_AI_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+#include "CpuPlayer.h"
+#include "ThreadPool.h"
+
+// Computer player: Monte Carlo tree search whose playouts run the real
+// SimStep() rules. Every core descends a shared tree at once, steered
+// apart by virtual loss, and several independent trees can be grown side
+// by side (root parallelism) and merged by visit count. Nodes come from
+// preallocated pools and each worker keeps its own scratch GameState,
+// copied from the root once a search and wound back to it with
+// SimRestore() after every playout, so a playout allocates nothing once
+// the scratch trails and arena journal have grown.
+//
+// Levels alternate between this player's heading and the opponent's
+// reply; once both are chosen the pair is held for the turn delay. The
+// tree is a duel between blue and orange: any further cycles keep their
+// heading in the tree and play the random policy in playouts. The
+// opponent is always 1 - player, so player has to be blue or orange; in
+// rounds of more cycles the front end keeps the rest on the keyboard.
+
+struct MctsStats {
+	unsigned long long playouts;
+	unsigned long long nodes;
+	int threads;
+	int trees;
+	long long microseconds;
+
+	double playoutsPerSecond() const {
+		return microseconds > 0 ? playouts * 1000000.0 / microseconds : 0.0;
+	};
+};
+
+class MctsAI : public CpuPlayer {
+protected:
+	static const int MAX_PATH = 128;
+
+	struct Node {
+		std::atomic<int> visits;
+		std::atomic<int> virtualLoss;
+		std::atomic<long long> score;	// Twice the wins of whoever moved into this node
+		std::atomic<int> state;
+		Node* children;
+		int childCount;
+		DIRECTION move;
+	};
+
+	// Lock-free bump allocator, emptied before each search
+	class NodePool {
+	protected:
+		std::unique_ptr<Node[]> nodes;
+		size_t capacity;
+		std::atomic<size_t> used;
+	public:
+		NodePool(size_t capacity);
+		Node* allocate(int count);
+		void reset() { used = 0; };
+		size_t getUsed() { size_t n = used; return n < capacity ? n : capacity; };
+	};
+
+	struct Worker {
+		GameState state;
+		SimSnapshot start;				// The state at the root of the search
+		std::mt19937 rng;
+		Node* path[MAX_PATH];
+	};
+
+	int player;
+	int playoutBudget;
+	long long timeBudget;
+	int treeCount;
+	unsigned int maxPlayoutTicks;
+	double exploration;
+
+	ThreadPool pool;
+	std::vector<std::unique_ptr<NodePool>> pools;
+	std::vector<Node*> roots;
+	std::vector<std::unique_ptr<Worker>> workers;
+	const GameState* rootState;
+	std::atomic<long long> remaining;
+	std::chrono::steady_clock::time_point deadline;
+	MctsStats stats;
+
+	static void initNode(Node* node, DIRECTION move);
+	static PLAYERINPUT inputFor(const CycleState& cycle, DIRECTION direction);
+	int moverAt(int depth) { return depth % 2 == 0 ? player : 1 - player; };
+	int generateMoves(const GameState& state, int who, DIRECTION moves[3]);
+	void applyMoves(GameState& state, const DIRECTION moves[MAX_PLAYERS]);
+	Node* select(Node* node);
+	bool expand(Node* node, NodePool& nodes, const GameState& state, int who);
+	int playout(GameState& state, std::mt19937& rng);
+	void runWorker(int index);
+
+public:
+	MctsAI(int player, int playouts = 2000, int threads = 0, int trees = 1,
+		size_t poolNodes = 1 << 18);
+	virtual ~MctsAI();
+
+	// Input for this tick. Searches only when the cycle is free to turn.
+	virtual PLAYERINPUT chooseInput(const GameState& state);
+
+	int getPlayer() { return player; };
+	void setPlayoutBudget(int playouts) { playoutBudget = playouts; };
+	// Optional cap in microseconds, 0 runs the whole playout budget
+	void setTimeBudget(long long microseconds) { timeBudget = microseconds; };
+	void setMaxPlayoutTicks(unsigned int ticks) { maxPlayoutTicks = ticks; };
+	const MctsStats& getStats() { return stats; };
+
+};
+
+#endif
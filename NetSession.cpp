@@ -0,0 +1,300 @@
+#include "NetSession.h"
+#include <cstring>
+
+using namespace std;
+
+static const uint8_t PACKET_MAGIC[2] = { 'L', 'K' };
+static const uint8_t PACKET_VERSION = 1;
+static const size_t PACKET_HEADER = 37;
+static const uint32_t NO_TICK = 0xffffffffu;		// Hash tick before the first settles, echo age before the first packet
+static const long long MAX_ROUND_TRIP = 10000000;	// Samples above ten seconds are clock trouble, not the network
+
+static void writeU32(uint8_t* out, uint32_t value) {
+
+	out[0] = (uint8_t)value;
+	out[1] = (uint8_t)(value >> 8);
+	out[2] = (uint8_t)(value >> 16);
+	out[3] = (uint8_t)(value >> 24);
+
+}
+
+static uint32_t readU32(const uint8_t* in) {
+
+	return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+
+}
+
+NetSession::NetSession() {
+
+	SessionConfig none = { 0, 0, 0, 0 };
+	config = none;
+	transport = nullptr;
+	tick = 0;
+	settled = 0;
+	scheduled = 0;
+	memset(inputs, 0, sizeof(inputs));
+	memset(arrived, 0, sizeof(arrived));
+	memset(localInputs, 0, sizeof(localInputs));
+	memset(hashes, 0, sizeof(hashes));
+	memset(peers, 0, sizeof(peers));
+	desynced = false;
+	desyncTick = 0;
+	memset(&stats, 0, sizeof(stats));
+
+}
+
+bool NetSession::start(const SessionConfig& config, Transport* transport, NetClock clock) {
+
+	if (config.players < 2 || config.players > MAX_PLAYERS || config.localPlayer < 0 ||
+		config.localPlayer >= config.players || config.inputDelay < 0 ||
+		config.inputDelay > MAX_INPUT_DELAY || transport == nullptr) {
+		return false;
+	}
+
+	this->config = config;
+	this->transport = transport;
+	this->clock = clock;
+	tick = 0;
+	settled = 0;
+	memset(inputs, 0, sizeof(inputs));
+	memset(arrived, 0, sizeof(arrived));
+	memset(localInputs, 0, sizeof(localInputs));
+	memset(hashes, 0, sizeof(hashes));
+
+	// Nobody has input for the ticks before the delay runs out, so they are
+	// empty on every peer without being sent
+	for (int t = 0; t < config.inputDelay; t++) {
+		arrived[t] = everyone();
+	}
+	scheduled = config.inputDelay;
+
+	for (int i = 0; i < MAX_PLAYERS; i++) {
+		Peer& peer = peers[i];
+		peer.received = config.inputDelay;
+		peer.acked = config.inputDelay;
+		peer.lastTime = 0;
+		peer.lastArrival = 0;
+		peer.heard = false;
+		peer.roundTrip = -1;
+		peer.hashTick = 0;
+		peer.hash = 0;
+		peer.hashPending = false;
+	}
+	desynced = false;
+	desyncTick = 0;
+	memset(&stats, 0, sizeof(stats));
+	return true;
+
+}
+
+void NetSession::scheduleLocalInput(PLAYERINPUT input) {
+
+	if (scheduled <= tick + (unsigned int)config.inputDelay) {
+		localInputs[scheduled % WINDOW] = input;
+		storeInput(config.localPlayer, scheduled, input);
+		scheduled++;
+	}
+
+}
+
+void NetSession::storeInput(int player, unsigned int at, PLAYERINPUT input) {
+
+	uint32_t bit = 1u << player;
+	unsigned int slot = at % WINDOW;
+	if (arrived[slot] & bit) {
+		return;
+	}
+	inputs[slot][player] = input;
+	arrived[slot] |= bit;
+
+	// The ack only covers an unbroken run, so a gap keeps being asked for
+	Peer& peer = peers[player];
+	while (peer.received < settled + WINDOW && (arrived[peer.received % WINDOW] & bit)) {
+		peer.received++;
+	}
+
+	if (player != config.localPlayer) {
+		inputArrived(player, at, input);
+	}
+
+}
+
+void NetSession::inputArrived(int, unsigned int, PLAYERINPUT) {
+
+	// Lockstep only looks at inputs once they are all in
+
+}
+
+void NetSession::settle(unsigned int until) {
+
+	// The slots are free for the ticks WINDOW on
+	for (; settled < until; settled++) {
+		unsigned int slot = settled % WINDOW;
+		arrived[slot] = 0;
+		memset(inputs[slot], 0, sizeof(inputs[slot]));
+	}
+
+	for (int i = 0; i < config.players; i++) {
+		if (i != config.localPlayer) {
+			checkHash(i);
+		}
+	}
+
+}
+
+void NetSession::setHash(unsigned int at, uint64_t hash) {
+
+	// Packets carry 32 bits of the 64-bit state hash
+	hashes[at % WINDOW] = (uint32_t)(hash ^ (hash >> 32));
+
+}
+
+void NetSession::receivePackets() {
+
+	uint8_t packet[Transport::MAX_DATAGRAM];
+	size_t size;
+	while ((size = transport->receive(packet, sizeof(packet))) > 0) {
+		handlePacket(packet, size);
+	}
+
+}
+
+void NetSession::handlePacket(const uint8_t* data, size_t size) {
+
+	if (size < PACKET_HEADER || data[0] != PACKET_MAGIC[0] || data[1] != PACKET_MAGIC[1] ||
+		data[2] != PACKET_VERSION || data[3] >= config.players || data[3] == config.localPlayer ||
+		readU32(data + 4) != config.session) {
+		stats.packetsIgnored++;
+		return;
+	}
+	unsigned int count = data[36];
+	if (size < PACKET_HEADER + (count + 1) / 2) {
+		stats.packetsIgnored++;
+		return;
+	}
+	stats.packetsReceived++;
+
+	int sender = data[3];
+	Peer& peer = peers[sender];
+	long long now = clock();
+
+	// Packets can arrive out of order, so acks and times only move forward
+	unsigned int ack = readU32(data + 8);
+	if (ack > peer.acked && ack <= scheduled) {
+		peer.acked = ack;
+	}
+	uint32_t sentTime = readU32(data + 12);
+	if (!peer.heard || (int32_t)(sentTime - peer.lastTime) > 0) {
+		peer.lastTime = sentTime;
+		peer.lastArrival = now;
+		peer.heard = true;
+	}
+
+	// Our own send time coming back, less however long they sat on it
+	uint32_t echo = readU32(data + 16);
+	uint32_t age = readU32(data + 20);
+	if (age != NO_TICK) {
+		long long sample = (long long)(uint32_t)((uint32_t)now - echo) - (long long)age;
+		if (sample >= 0 && sample < MAX_ROUND_TRIP) {
+			peer.roundTrip = peer.roundTrip < 0 ? sample : peer.roundTrip + (sample - peer.roundTrip) / 8;
+		}
+	}
+
+	unsigned int hashTick = readU32(data + 24);
+	if (hashTick != NO_TICK && (!peer.hashPending || hashTick > peer.hashTick)) {
+		peer.hashTick = hashTick;
+		peer.hash = readU32(data + 28);
+		peer.hashPending = true;
+		checkHash(sender);
+	}
+
+	unsigned int first = readU32(data + 32);
+	const uint8_t* packed = data + PACKET_HEADER;
+	for (unsigned int i = 0; i < count; i++) {
+		unsigned int at = first + i;
+		if (at < peer.received) {
+			continue;
+		}
+		if (at >= settled + WINDOW) {
+			break;
+		}
+		storeInput(sender, at, (PLAYERINPUT)((packed[i / 2] >> ((i & 1) * 4)) & 0x0f));
+	}
+
+}
+
+void NetSession::sendPackets() {
+
+	uint8_t packet[PACKET_HEADER + MAX_REDUNDANT / 2];
+	long long now = clock();
+
+	for (int i = 0; i < config.players; i++) {
+		if (i == config.localPlayer) {
+			continue;
+		}
+		const Peer& peer = peers[i];
+
+		// Everything they haven't acknowledged, oldest first
+		unsigned int first = peer.acked;
+		if (scheduled - first > (unsigned int)MAX_REDUNDANT) {
+			first = scheduled - MAX_REDUNDANT;
+		}
+		unsigned int count = scheduled - first;
+
+		packet[0] = PACKET_MAGIC[0];
+		packet[1] = PACKET_MAGIC[1];
+		packet[2] = PACKET_VERSION;
+		packet[3] = (uint8_t)config.localPlayer;
+		writeU32(packet + 4, config.session);
+		writeU32(packet + 8, peer.received);
+		writeU32(packet + 12, (uint32_t)now);
+		writeU32(packet + 16, peer.heard ? peer.lastTime : 0);
+		writeU32(packet + 20, peer.heard ? (uint32_t)(now - peer.lastArrival) : NO_TICK);
+		writeU32(packet + 24, settled > 0 ? settled - 1 : NO_TICK);
+		writeU32(packet + 28, settled > 0 ? hashes[(settled - 1) % WINDOW] : 0);
+		writeU32(packet + 32, first);
+		packet[36] = (uint8_t)count;
+		memset(packet + PACKET_HEADER, 0, (count + 1) / 2);
+		for (unsigned int t = 0; t < count; t++) {
+			packet[PACKET_HEADER + t / 2] |= (uint8_t)((localInputs[(first + t) % WINDOW] & 0x0f) << ((t & 1) * 4));
+		}
+
+		if (transport->send(i, packet, PACKET_HEADER + (count + 1) / 2)) {
+			stats.packetsSent++;
+		}
+	}
+
+}
+
+void NetSession::checkHash(int player) {
+
+	Peer& peer = peers[player];
+	if (!peer.hashPending || peer.hashTick >= settled) {
+		return;
+	}
+	// Too old to have our own hash for any more
+	if (tick - peer.hashTick <= (unsigned int)WINDOW && hashes[peer.hashTick % WINDOW] != peer.hash && !desynced) {
+		desynced = true;
+		desyncTick = peer.hashTick;
+	}
+	peer.hashPending = false;
+
+}
+
+long long NetSession::getRoundTrip(int player) const {
+
+	return player >= 0 && player < MAX_PLAYERS && player != config.localPlayer ? peers[player].roundTrip : -1;
+
+}
+
+long long NetSession::getMaxRoundTrip() const {
+
+	long long most = -1;
+	for (int i = 0; i < config.players; i++) {
+		if (i != config.localPlayer && peers[i].roundTrip > most) {
+			most = peers[i].roundTrip;
+		}
+	}
+	return most;
+
+}
@@ -0,0 +1,121 @@
+#ifndef NET_SESSION_H
+#define NET_SESSION_H
+
+#include "Simulation.h"
+#include "Transport.h"
+
+// What peer-to-peer sessions have in common: every peer runs the whole
+// simulation and only inputs cross the network, four bits per player per
+// tick. The subclasses differ in what they do about an input that hasn't
+// arrived yet. LockstepSession waits for it, RollbackSession guesses and
+// corrects itself later.
+//
+// Local input is scheduled inputDelay ticks ahead, giving it that long to
+// reach the others before anyone needs it. Every packet repeats all the
+// local inputs the receiving peer hasn't acknowledged, so a lost packet
+// costs nothing once a later one arrives.
+//
+// Packets also carry a send time echoed back for the round trip, and the
+// low bits of StateHash() after the sender's latest settled tick so a
+// desync is caught on the tick it happens. A tick is settled once it has
+// been stepped with every player's real input; it never changes again.
+//
+// Packet: "LK", version, sender, session, ack tick, send time, echoed
+//         time, echo age, hash tick, hash, first tick, input count,
+//         inputs two to a byte, all numbers 32-bit little endian
+
+struct SessionConfig {
+	int players;				// One per peer, 2 to MAX_PLAYERS
+	int localPlayer;
+	int inputDelay;				// Ticks from reading local input to stepping it, 0 to MAX_INPUT_DELAY
+	unsigned int session;		// Shared by the peers, packets of any other session are ignored
+};
+
+struct SessionStats {
+	unsigned long long ticks;			// Ticks stepped, not counting re-simulation
+	unsigned long long stalls;			// advance() calls that had to wait for a remote input
+	unsigned long long packetsSent;
+	unsigned long long packetsReceived;
+	unsigned long long packetsIgnored;	// Malformed, from another session or from ourselves
+	unsigned long long rollbacks;		// Times a wrong guess was put right, rollback only
+	unsigned long long resimulated;		// Ticks stepped again doing so
+	unsigned int deepestRollback;		// Most ticks stepped again at once
+};
+
+class NetSession {
+public:
+	static const int WINDOW = 256;			// Ticks of input held, must exceed twice the delay plus any prediction
+	static const int MAX_INPUT_DELAY = 60;
+	static const int MAX_REDUNDANT = 240;	// Most inputs one packet repeats
+
+protected:
+	struct Peer {
+		unsigned int received;		// All their inputs below this tick are in
+		unsigned int acked;			// They have all of ours below this tick
+		uint32_t lastTime;			// Send time of their latest packet, their clock
+		long long lastArrival;		// When it arrived, our clock
+		bool heard;
+		long long roundTrip;		// Smoothed, microseconds, -1 until measured
+		unsigned int hashTick;		// Their latest state hash, waiting for ours to compare
+		uint32_t hash;
+		bool hashPending;
+	};
+
+	SessionConfig config;
+	Transport* transport;
+	NetClock clock;
+	unsigned int tick;							// Next tick to step
+	unsigned int settled;						// Ticks below this are final, their inputs dropped
+	unsigned int scheduled;						// Local input is in for every tick below this
+	PLAYERINPUT inputs[WINDOW][MAX_PLAYERS];	// Everyone's input for a tick, at tick % WINDOW
+	uint32_t arrived[WINDOW];					// Bit per player whose input for that tick is in
+	PLAYERINPUT localInputs[WINDOW];			// Ours again, kept after settling until the peers have them
+	uint32_t hashes[WINDOW];					// Ours after each tick, final once it settles
+	Peer peers[MAX_PLAYERS];
+	bool desynced;
+	unsigned int desyncTick;
+	SessionStats stats;
+
+	uint32_t everyone() const { return (uint32_t)((1ull << config.players) - 1); };
+	bool hasAllInputs(unsigned int at) const { return arrived[at % WINDOW] == everyone(); };
+	bool hasInput(int player, unsigned int at) const { return (arrived[at % WINDOW] >> player) & 1; };
+
+	// Schedule local input inputDelay ticks ahead, once per tick stepped so
+	// a stall doesn't run ahead
+	void scheduleLocalInput(PLAYERINPUT input);
+	void storeInput(int player, unsigned int at, PLAYERINPUT input);
+	// Called for each remote input as it first arrives
+	virtual void inputArrived(int player, unsigned int at, PLAYERINPUT input);
+	// Mark the ticks below until final, dropping their inputs
+	void settle(unsigned int until);
+	// Note our hash of the state a tick left
+	void setHash(unsigned int at, uint64_t hash);
+
+	void receivePackets();
+	void handlePacket(const uint8_t* data, size_t size);
+	void sendPackets();
+	void checkHash(int player);
+
+public:
+	NetSession();
+	virtual ~NetSession() {};
+
+	// Start at tick 0 with no packets exchanged. transport must outlive the
+	// session. False if the config is out of range.
+	virtual bool start(const SessionConfig& config, Transport* transport, NetClock clock = NetNow);
+
+	// Rounds follow each other in one tick stream: after the step that ends
+	// a round every peer starts the next before the following tick
+	unsigned int getTick() const { return tick; };
+	unsigned int getSettledTick() const { return settled; };
+	const SessionConfig& getConfig() const { return config; };
+	// Smoothed round trip to a peer in microseconds, -1 until measured
+	long long getRoundTrip(int player) const;
+	long long getMaxRoundTrip() const;
+	bool isDesynced() const { return desynced; };
+	unsigned int getDesyncTick() const { return desyncTick; };
+	const SessionStats& getStats() const { return stats; };
+
+};
+
+#endif
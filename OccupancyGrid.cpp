@@ -0,0 +1,183 @@
+#include "OccupancyGrid.h"
+#include <cstring>
+
+using namespace std;
+
+OccupancyGrid::OccupancyGrid() {
+
+	width = 0;
+	height = 0;
+	tilesPerRow = 0;
+	tileRows = 0;
+	journaling = false;
+	journalBase = 0;
+
+}
+
+OccupancyGrid::OccupancyGrid(int w, int h) {
+
+	width = 0;
+	height = 0;
+	tilesPerRow = 0;
+	tileRows = 0;
+	journaling = false;
+	journalBase = 0;
+
+	resize(w, h);
+
+}
+
+void OccupancyGrid::resize(int w, int h) {
+
+	width = w > 0 ? w : 0;
+	height = h > 0 ? h : 0;
+	tilesPerRow = (width + TILE_SIZE - 1) >> TILE_SHIFT;
+	tileRows = (height + TILE_SIZE - 1) >> TILE_SHIFT;
+
+	directory.assign((size_t)tilesPerRow * tileRows, 0);
+	tiles.clear();
+	tileSlots.clear();
+	journal.clear();
+	journalBase = 0;
+
+}
+
+void OccupancyGrid::clear() {
+
+	for (size_t i = 0; i < tileSlots.size(); i++) {
+		directory[tileSlots[i]] = 0;
+	}
+	tiles.clear();
+	tileSlots.clear();
+	journal.clear();
+	journalBase = 0;
+
+}
+
+void OccupancyGrid::rewind(size_t position) {
+
+	size_t keep = position > journalBase ? position - journalBase : 0;
+	while (journal.size() > keep) {
+		const JournalEntry& note = journal.back();
+		tiles[note.tile].rows[note.row] &= ~(uint64_t(1) << note.bit);
+		journal.pop_back();
+	}
+
+}
+
+void OccupancyGrid::forget(size_t position) {
+
+	if (position <= journalBase) {
+		return;
+	}
+	size_t drop = position - journalBase < journal.size() ? position - journalBase : journal.size();
+	journal.erase(journal.begin(), journal.begin() + drop);
+	journalBase += drop;
+
+}
+
+OccupancyGrid::Tile& OccupancyGrid::addTile(uint32_t& entry, size_t slot) {
+
+	tiles.push_back(Tile());
+	memset(&tiles.back(), 0, sizeof(Tile));
+	tileSlots.push_back((uint32_t)slot);
+	entry = (uint32_t)tiles.size();
+	return tiles.back();
+
+}
+
+void OccupancyGrid::stampSegment(int x1, int y1, int x2, int y2) {
+
+	// Bresenham, both end points included
+	int dx = x2 > x1 ? x2 - x1 : x1 - x2;
+	int dy = y2 > y1 ? y2 - y1 : y1 - y2;
+	int sx = x1 < x2 ? 1 : -1;
+	int sy = y1 < y2 ? 1 : -1;
+	int err = dx - dy;
+
+	while (true) {
+
+		set(x1, y1);
+
+		if (x1 == x2 && y1 == y2) {
+
+			break;
+
+		}
+
+		int e2 = err * 2;
+
+		if (e2 > -dy) {
+			err -= dy;
+			x1 += sx;
+		}
+
+		if (e2 < dx) {
+			err += dx;
+			y1 += sy;
+		}
+
+	}
+
+}
+
+void OccupancyGrid::copyTo(uint64_t* words, int wordsPerRow) const {
+
+	memset(words, 0, (size_t)wordsPerRow * height * sizeof(uint64_t));
+
+	for (size_t i = 0; i < tiles.size(); i++) {
+		int tileX = (int)(tileSlots[i] % tilesPerRow);
+		int top = (int)(tileSlots[i] / tilesPerRow) << TILE_SHIFT;
+		int rows = height - top < TILE_SIZE ? height - top : TILE_SIZE;
+		for (int row = 0; row < rows; row++) {
+			words[(size_t)(top + row) * wordsPerRow + tileX] = tiles[i].rows[row];
+		}
+	}
+
+}
+
+void OccupancyGrid::copyTo(uint64_t* words, int wordsPerRow, int left, int top, int rows) const {
+
+	memset(words, 0, (size_t)wordsPerRow * rows * sizeof(uint64_t));
+
+	int firstTileX = left >> TILE_SHIFT;
+	int lastTileX = firstTileX + wordsPerRow < tilesPerRow ? firstTileX + wordsPerRow : tilesPerRow;
+	int bottom = top + rows < height ? top + rows : height;
+	for (int y = top; y < bottom; y++) {
+		const uint32_t* entries = &directory[(size_t)(y >> TILE_SHIFT) * tilesPerRow];
+		uint64_t* row = &words[(size_t)(y - top) * wordsPerRow];
+		for (int tileX = firstTileX; tileX < lastTileX; tileX++) {
+			uint32_t entry = entries[tileX];
+			if (entry != 0) {
+				row[tileX - firstTileX] = tiles[entry - 1].rows[y & (TILE_SIZE - 1)];
+			}
+		}
+	}
+
+}
+
+void OccupancyGrid::copyFrom(const uint64_t* words, int wordsPerRow) {
+
+	clear();
+
+	for (int y = 0; y < height; y++) {
+		for (int tileX = 0; tileX < tilesPerRow; tileX++) {
+			uint64_t bits = words[(size_t)y * wordsPerRow + tileX];
+			if (bits == 0) {
+				continue;
+			}
+			size_t slot = (size_t)(y >> TILE_SHIFT) * tilesPerRow + tileX;
+			uint32_t& entry = directory[slot];
+			Tile& tile = entry != 0 ? tiles[entry - 1] : addTile(entry, slot);
+			tile.rows[y & (TILE_SIZE - 1)] = bits;
+		}
+	}
+
+}
+
+size_t OccupancyGrid::getBytesReserved() const {
+
+	return directory.capacity() * sizeof(uint32_t) + tiles.capacity() * sizeof(Tile) +
+		tileSlots.capacity() * sizeof(uint32_t);
+
+}
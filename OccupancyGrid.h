@@ -0,0 +1,121 @@
+#ifndef OCCUPANCY_GRID_H
+#define OCCUPANCY_GRID_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// One bit per arena pixel. Trails are stamped in as the cycles move so a
+// head can be tested against every trail (its own included) in O(1).
+//
+// Bits are kept in 64 x 64 pixel tiles that only exist once something has
+// been stamped into them, found through a directory with one entry per
+// tile position. A trail costs a tile per 64 pixels at worst, so memory
+// follows how far the cycles have been rather than the arena size, and a
+// 20,000 x 20,000 arena starts out at a 400 KB directory instead of 50 MB
+// of bits.
+//
+// For rollback the grid can keep a journal of every bit it sets, so it
+// can be wound back to an earlier position instead of being copied.
+class OccupancyGrid {
+public:
+	static const int TILE_SHIFT = 6;
+	static const int TILE_SIZE = 1 << TILE_SHIFT;
+
+protected:
+	// Row y of a tile is one word, bit x for pixel x
+	struct Tile {
+		uint64_t rows[TILE_SIZE];
+	};
+
+	// A bit that was clear until set() set it
+	struct JournalEntry {
+		uint32_t tile;
+		uint16_t row;
+		uint16_t bit;
+	};
+
+	int width, height;
+	int tilesPerRow, tileRows;
+	std::vector<uint32_t> directory;	// 1 + index into tiles, 0 where nothing was stamped
+	std::vector<Tile> tiles;
+	std::vector<uint32_t> tileSlots;	// Directory entry of each tile, so clear() only visits those
+	bool journaling;
+	std::vector<JournalEntry> journal;
+	size_t journalBase;				// Position of journal[0], entries before it were forgotten
+
+	Tile& addTile(uint32_t& entry, size_t slot);
+
+public:
+	OccupancyGrid();
+	OccupancyGrid(int w, int h);
+
+	void resize(int w, int h);
+	// Empty the arena, keeping the tile storage for the next round. The
+	// journal starts over too.
+	void clear();
+
+	// Cells outside the arena count as occupied
+	bool isOccupied(int x, int y) const {
+
+		if (x < 0 || y < 0 || x >= width || y >= height) {
+
+			return true;
+
+		}
+
+		uint32_t entry = directory[(size_t)(y >> TILE_SHIFT) * tilesPerRow + (x >> TILE_SHIFT)];
+		return entry != 0 && ((tiles[entry - 1].rows[y & (TILE_SIZE - 1)] >> (x & 63)) & 1);
+
+	};
+
+	void set(int x, int y) {
+
+		if (x < 0 || y < 0 || x >= width || y >= height) {
+
+			return;
+
+		}
+
+		size_t slot = (size_t)(y >> TILE_SHIFT) * tilesPerRow + (x >> TILE_SHIFT);
+		uint32_t& entry = directory[slot];
+		Tile& tile = entry != 0 ? tiles[entry - 1] : addTile(entry, slot);
+		uint64_t& row = tile.rows[y & (TILE_SIZE - 1)];
+		uint64_t bit = uint64_t(1) << (x & 63);
+		if (journaling && (row & bit) == 0) {
+			JournalEntry note = { entry - 1, (uint16_t)(y & (TILE_SIZE - 1)), (uint16_t)(x & 63) };
+			journal.push_back(note);
+		}
+		row |= bit;
+
+	};
+
+	void stampSegment(int x1, int y1, int x2, int y2);
+
+	// The arena as plain rows padded to whole 64-bit words, bit x & 63 of
+	// word x >> 6, for code that wants every bit at once
+	void copyTo(uint64_t* words, int wordsPerRow) const;
+	// The same for rows top to top + rows - 1 starting at column left, which
+	// has to be a multiple of 64. Only the tiles in the window are visited.
+	void copyTo(uint64_t* words, int wordsPerRow, int left, int top, int rows) const;
+	// Replace the contents with such rows, adding tiles only where bits are set
+	void copyFrom(const uint64_t* words, int wordsPerRow);
+
+	void setJournaling(bool journaling) { this->journaling = journaling; };
+	bool isJournaling() const { return journaling; };
+	// Bits set so far since the last clear, to rewind() to later
+	size_t getJournalPosition() const { return journalBase + journal.size(); };
+	// Clear every bit set since the position. Tiles stay, empty.
+	void rewind(size_t position);
+	// Let go of the journal before the position, nothing will rewind that far
+	void forget(size_t position);
+
+	int getWidth() const { return width; };
+	int getHeight() const { return height; };
+	size_t getTileCount() const { return tiles.size(); };
+	// Directory and tile storage, reserved capacity included
+	size_t getBytesReserved() const;
+
+};
+
+#endif
@@ -0,0 +1,406 @@
+#include "Replay.h"
+#include <fstream>
+#include <new>
+
+using namespace std;
+
+static const uint8_t REPLAY_MAGIC[4] = { 'L', 'C', 'R', 'P' };
+static const unsigned int REPLAY_VERSION = 2;
+static const unsigned int REPLAY_MAX_TICK_RATE = 1000;
+// Longer than any real match, and at most 16 players' inputs is a few hundred MB
+static const unsigned int REPLAY_MAX_SECONDS = 4 * 60 * 60;
+
+static void writeVarint(vector<uint8_t>& out, uint64_t value) {
+
+	while (value >= 0x80) {
+		out.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((uint8_t)value);
+
+}
+
+static void writeSigned(vector<uint8_t>& out, int64_t value) {
+
+	// Zigzag so small negative numbers stay short
+	writeVarint(out, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+
+}
+
+static bool readVarint(const vector<uint8_t>& in, size_t& pos, uint64_t& value) {
+
+	value = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (pos >= in.size()) {
+			return false;
+		}
+		uint8_t byte = in[pos++];
+		value |= (uint64_t)(byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0) {
+			return true;
+		}
+	}
+	return false;
+
+}
+
+static bool readSigned(const vector<uint8_t>& in, size_t& pos, int& value) {
+
+	uint64_t raw;
+	if (!readVarint(in, pos, raw)) {
+		return false;
+	}
+	value = (int)(int64_t)((raw >> 1) ^ (~(raw & 1) + 1));
+	return true;
+
+}
+
+static uint64_t chainHash(uint64_t chain, uint64_t hash) {
+
+	chain ^= hash + 0x9e3779b97f4a7c15ULL + (chain << 6) + (chain >> 2);
+	chain = (chain ^ (chain >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	return chain ^ (chain >> 31);
+
+}
+
+// Two players' inputs per byte, four bits each
+static int PackedInputBytes(int players) {
+
+	return (players + 1) / 2;
+
+}
+
+ReplayRecorder::ReplayRecorder() {
+
+	config = DefaultSimConfig();
+	tickRate = 60;
+	checkpointInterval = 600;
+	runCount = 0;
+	runLength = 0;
+	checkpointCount = 0;
+	lastCheckpoint = 0;
+	ticks = 0;
+	chain = 0;
+	for (int i = 0; i < MAX_PLAYERS; i++) {
+		runInputs[i] = PI_NONE;
+	}
+
+}
+
+void ReplayRecorder::start(const SimConfig& config, int tickRate, unsigned int checkpointInterval) {
+
+	this->config = config;
+	this->config.players = config.players < 2 ? 2 : (config.players > MAX_PLAYERS ? MAX_PLAYERS : config.players);
+	this->tickRate = tickRate;
+	this->checkpointInterval = checkpointInterval > 0 ? checkpointInterval : 1;
+	runs.clear();
+	runCount = 0;
+	runLength = 0;
+	checkpoints.clear();
+	checkpointCount = 0;
+	lastCheckpoint = 0;
+	ticks = 0;
+	chain = 0;
+
+}
+
+void ReplayRecorder::flushRun() {
+
+	if (runLength == 0) {
+		return;
+	}
+
+	writeVarint(runs, runLength);
+	for (int i = 0; i < PackedInputBytes(config.players); i++) {
+		uint8_t packed = runInputs[i * 2] & 0x0f;
+		if (i * 2 + 1 < config.players) {
+			packed |= (runInputs[i * 2 + 1] & 0x0f) << 4;
+		}
+		runs.push_back(packed);
+	}
+	runCount++;
+	runLength = 0;
+
+}
+
+void ReplayRecorder::record(const PLAYERINPUT inputs[], const GameState& after) {
+
+	record(inputs, after.tick, after.over, StateHash(after));
+
+}
+
+void ReplayRecorder::record(const PLAYERINPUT inputs[], unsigned int afterTick, bool afterOver, uint64_t afterHash) {
+
+	// Steps on a finished round don't advance the simulation
+	if (afterTick != ticks + 1) {
+		return;
+	}
+
+	bool same = runLength > 0;
+	for (int i = 0; i < config.players && same; i++) {
+		same = (inputs[i] & 0x0f) == (runInputs[i] & 0x0f);
+	}
+	if (!same) {
+		flushRun();
+		for (int i = 0; i < config.players; i++) {
+			runInputs[i] = inputs[i];
+		}
+	}
+	runLength++;
+
+	ticks++;
+	chain = chainHash(chain, afterHash);
+	if (ticks % checkpointInterval == 0 || afterOver) {
+		writeVarint(checkpoints, ticks - lastCheckpoint);
+		uint32_t check = (uint32_t)chain;
+		for (int i = 0; i < 4; i++) {
+			checkpoints.push_back((uint8_t)(check >> (i * 8)));
+		}
+		checkpointCount++;
+		lastCheckpoint = ticks;
+	}
+
+}
+
+vector<uint8_t> ReplayRecorder::finish() {
+
+	flushRun();
+
+	vector<uint8_t> out(REPLAY_MAGIC, REPLAY_MAGIC + 4);
+	writeVarint(out, REPLAY_VERSION);
+	writeVarint(out, (uint64_t)tickRate);
+	writeSigned(out, config.width);
+	writeSigned(out, config.height);
+	writeSigned(out, config.cycleWidth);
+	writeSigned(out, config.cycleHeight);
+	writeSigned(out, config.maxSpeed);
+	writeSigned(out, config.directionChangeDelay);
+	writeVarint(out, config.seed);
+	writeVarint(out, (uint64_t)config.players);
+
+	writeVarint(out, runCount);
+	out.insert(out.end(), runs.begin(), runs.end());
+	writeVarint(out, checkpointCount);
+	out.insert(out.end(), checkpoints.begin(), checkpoints.end());
+
+	return out;
+
+}
+
+bool ReplayRecorder::save(const string& fileName) {
+
+	vector<uint8_t> data = finish();
+	ofstream file(fileName.c_str(), ios::binary | ios::trunc);
+	if (!file) {
+		return false;
+	}
+	file.write((const char*)data.data(), data.size());
+	return (bool)file;
+
+}
+
+ReplayPlayer::ReplayPlayer() {
+
+	config = DefaultSimConfig();
+	tickRate = 60;
+	length = 0;
+	chain = 0;
+	nextCheckpoint = 0;
+	desynced = false;
+	desyncTick = 0;
+	snapshotInterval = 600;
+
+}
+
+bool ReplayPlayer::load(const vector<uint8_t>& data) {
+
+	size_t pos = 4;
+	uint64_t value;
+
+	if (data.size() < 4 || data[0] != REPLAY_MAGIC[0] || data[1] != REPLAY_MAGIC[1] ||
+		data[2] != REPLAY_MAGIC[2] || data[3] != REPLAY_MAGIC[3]) {
+		return false;
+	}
+	if (!readVarint(data, pos, value) || value != REPLAY_VERSION) {
+		return false;
+	}
+	if (!readVarint(data, pos, value) || value == 0 || value > REPLAY_MAX_TICK_RATE) {
+		return false;
+	}
+	unsigned int loadedTickRate = (unsigned int)value;
+	uint64_t maxTicks = (uint64_t)loadedTickRate * REPLAY_MAX_SECONDS;
+
+	SimConfig loaded;
+	uint64_t seed, players;
+	if (!readSigned(data, pos, loaded.width) || !readSigned(data, pos, loaded.height) ||
+		!readSigned(data, pos, loaded.cycleWidth) || !readSigned(data, pos, loaded.cycleHeight) ||
+		!readSigned(data, pos, loaded.maxSpeed) || !readSigned(data, pos, loaded.directionChangeDelay) ||
+		!readVarint(data, pos, seed) || !readVarint(data, pos, players)) {
+		return false;
+	}
+	if (players < 2 || players > MAX_PLAYERS || loaded.width <= 0 || loaded.height <= 0 ||
+		loaded.width > 65536 || loaded.height > 65536) {
+		return false;
+	}
+	loaded.seed = (unsigned int)seed;
+	loaded.players = (int)players;
+	int packedBytes = PackedInputBytes(loaded.players);
+
+	uint64_t runCount;
+	if (!readVarint(data, pos, runCount)) {
+		return false;
+	}
+	// Decoded aside, so a bad file leaves the loaded replay as it was
+	vector<PLAYERINPUT> loadedInputs;
+	uint64_t ticks = 0;
+	for (uint64_t run = 0; run < runCount; run++) {
+		// Compared as what is left so a huge run can't wrap the sum
+		uint64_t runLength;
+		if (!readVarint(data, pos, runLength) || runLength == 0 || runLength > maxTicks - ticks ||
+			pos + packedBytes > data.size()) {
+			return false;
+		}
+		PLAYERINPUT runInputs[MAX_PLAYERS];
+		for (int i = 0; i < loaded.players; i++) {
+			runInputs[i] = (data[pos + i / 2] >> ((i & 1) * 4)) & 0x0f;
+		}
+		pos += packedBytes;
+		try {
+			for (uint64_t tick = 0; tick < runLength; tick++) {
+				loadedInputs.insert(loadedInputs.end(), runInputs, runInputs + loaded.players);
+			}
+		}
+		catch (const bad_alloc&) {
+			return false;
+		}
+		ticks += runLength;
+	}
+
+	uint64_t checkpointCount;
+	if (!readVarint(data, pos, checkpointCount)) {
+		return false;
+	}
+	vector<pair<unsigned int, uint32_t>> loadedCheckpoints;
+	unsigned int tick = 0;
+	for (uint64_t i = 0; i < checkpointCount; i++) {
+		if (!readVarint(data, pos, value) || value > ticks - tick || pos + 4 > data.size()) {
+			return false;
+		}
+		tick += (unsigned int)value;
+		uint32_t check = data[pos] | (data[pos + 1] << 8) | (data[pos + 2] << 16) |
+			((uint32_t)data[pos + 3] << 24);
+		pos += 4;
+		loadedCheckpoints.push_back(make_pair(tick, check));
+	}
+
+	config = loaded;
+	tickRate = (int)loadedTickRate;
+	inputs.swap(loadedInputs);
+	checkpoints.swap(loadedCheckpoints);
+	length = (unsigned int)ticks;
+	snapshots.clear();
+	restart();
+	return true;
+
+}
+
+bool ReplayPlayer::load(const string& fileName) {
+
+	ifstream file(fileName.c_str(), ios::binary);
+	if (!file) {
+		return false;
+	}
+	vector<uint8_t> data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+	return load(data);
+
+}
+
+void ReplayPlayer::restart() {
+
+	SimStart(state, config);
+	chain = 0;
+	nextCheckpoint = 0;
+	desynced = false;
+	desyncTick = 0;
+
+	if (snapshots.empty()) {
+		snapshots.push_back(Snapshot());
+		snapshots.back().state = state;
+		snapshots.back().chain = chain;
+		snapshots.back().checkpoint = nextCheckpoint;
+	}
+
+}
+
+bool ReplayPlayer::step() {
+
+	if (state.tick >= length || state.over) {
+		return false;
+	}
+
+	SimStep(state, &inputs[(size_t)state.tick * config.players]);
+	chain = chainHash(chain, StateHash(state));
+
+	if (nextCheckpoint < checkpoints.size() && checkpoints[nextCheckpoint].first == state.tick) {
+		if (checkpoints[nextCheckpoint].second != (uint32_t)chain && !desynced) {
+			desynced = true;
+			desyncTick = state.tick;
+		}
+		nextCheckpoint++;
+	}
+
+	// Keep a snapshot every snapshotInterval ticks for seeking
+	if (state.tick % snapshotInterval == 0 && snapshots.size() == state.tick / snapshotInterval) {
+		snapshots.push_back(Snapshot());
+		snapshots.back().state = state;
+		snapshots.back().chain = chain;
+		snapshots.back().checkpoint = nextCheckpoint;
+	}
+
+	return true;
+
+}
+
+unsigned int ReplayPlayer::fastForward(unsigned int count) {
+
+	unsigned int ran = 0;
+	while (ran < count && step()) {
+		ran++;
+	}
+	return ran;
+
+}
+
+void ReplayPlayer::seek(unsigned int tick) {
+
+	if (tick > length) {
+		tick = length;
+	}
+
+	// Restore the nearest snapshot unless stepping on from here is shorter
+	size_t index = tick / snapshotInterval;
+	if (index >= snapshots.size()) {
+		index = snapshots.size() - 1;
+	}
+	unsigned int snapshotTick = (unsigned int)(index * snapshotInterval);
+	if (state.tick > tick || state.tick < snapshotTick) {
+		const Snapshot& snapshot = snapshots[index];
+		state = snapshot.state;
+		chain = snapshot.chain;
+		nextCheckpoint = snapshot.checkpoint;
+	}
+
+	while (state.tick < tick && step()) {
+	}
+
+}
+
+void ReplayPlayer::setSnapshotInterval(unsigned int ticks) {
+
+	snapshotInterval = ticks > 0 ? ticks : 1;
+	// Only the round start is still on the new spacing
+	if (snapshots.size() > 1) {
+		snapshots.resize(1);
+	}
+
+}
@@ -0,0 +1,105 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "Simulation.h"
+
+// Replays store only what SimStep() needs to reproduce a round: the
+// config (seed included), the tick rate and every tick's inputs. Inputs
+// are run-length coded since keys are held far longer than a tick, and
+// all numbers are LEB128 varints, so an hour of play is a few kilobytes.
+//
+// A hash chain over StateHash() of every tick is checkpointed at
+// intervals so playback can prove it reproduced the recorded round.
+//
+// Layout: "LCRP", version, tick rate, SimConfig, player count,
+//         run count, runs (length, packed inputs),
+//         checkpoint count, checkpoints (tick delta, 32-bit chain)
+
+class ReplayRecorder {
+protected:
+	SimConfig config;
+	int tickRate;
+	unsigned int checkpointInterval;
+	std::vector<uint8_t> runs;
+	unsigned int runCount;
+	PLAYERINPUT runInputs[MAX_PLAYERS];
+	unsigned int runLength;
+	std::vector<uint8_t> checkpoints;
+	unsigned int checkpointCount;
+	unsigned int lastCheckpoint;
+	unsigned int ticks;
+	uint64_t chain;
+
+	void flushRun();
+
+public:
+	ReplayRecorder();
+
+	void start(const SimConfig& config, int tickRate, unsigned int checkpointInterval = 600);
+
+	// Call after every SimStep() with the inputs it was given
+	void record(const PLAYERINPUT inputs[], const GameState& after);
+	// The same from what the step left, for ticks only known to be final
+	// once the state has moved on, as with rollback
+	void record(const PLAYERINPUT inputs[], unsigned int afterTick, bool afterOver, uint64_t afterHash);
+
+	std::vector<uint8_t> finish();
+	bool save(const std::string& fileName);
+
+	unsigned int getTicks() { return ticks; };
+
+};
+
+class ReplayPlayer {
+protected:
+	struct Snapshot {
+		GameState state;
+		uint64_t chain;
+		size_t checkpoint;
+	};
+
+	SimConfig config;
+	int tickRate;
+	std::vector<PLAYERINPUT> inputs;	// config.players per tick
+	std::vector<std::pair<unsigned int, uint32_t>> checkpoints;
+	unsigned int length;
+
+	GameState state;
+	uint64_t chain;
+	size_t nextCheckpoint;
+	bool desynced;
+	unsigned int desyncTick;
+
+	unsigned int snapshotInterval;
+	std::vector<Snapshot> snapshots;	// snapshots[i] is the state at tick i * snapshotInterval
+
+public:
+	ReplayPlayer();
+
+	bool load(const std::vector<uint8_t>& data);
+	bool load(const std::string& fileName);
+
+	void restart();
+	// Advance one tick, false once the recording has run out
+	bool step();
+	// Run up to count ticks as fast as possible, returns how many ran
+	unsigned int fastForward(unsigned int count);
+	// Jump to any tick through the nearest earlier snapshot
+	void seek(unsigned int tick);
+
+	const GameState& getState() { return state; };
+	const PLAYERINPUT* getInputs(unsigned int tick) { return &inputs[(size_t)tick * config.players]; };
+	int getPlayers() { return config.players; };
+	unsigned int getTick() { return state.tick; };
+	unsigned int getLength() { return length; };
+	int getTickRate() { return tickRate; };
+	bool isDesynced() { return desynced; };
+	unsigned int getDesyncTick() { return desyncTick; };
+	void setSnapshotInterval(unsigned int ticks);
+
+};
+
+#endif
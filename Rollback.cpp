@@ -0,0 +1,165 @@
+#include "Rollback.h"
+#include <cstring>
+
+using namespace std;
+
+RollbackSession::RollbackSession() {
+
+	maxPrediction = 16;
+	memset(snapshots, 0, sizeof(snapshots));
+	memset(steps, 0, sizeof(steps));
+	memset(lastSettled, 0, sizeof(lastSettled));
+	rollbackFrom = NO_ROLLBACK;
+	handedOut = 0;
+	corrected = false;
+
+}
+
+bool RollbackSession::start(const SessionConfig& config, Transport* transport, NetClock clock) {
+
+	if (!NetSession::start(config, transport, clock)) {
+		return false;
+	}
+	memset(lastSettled, 0, sizeof(lastSettled));
+	rollbackFrom = NO_ROLLBACK;
+	handedOut = 0;
+	corrected = false;
+	return true;
+
+}
+
+void RollbackSession::setMaxPrediction(int ticks) {
+
+	maxPrediction = ticks < 1 ? 1 : (ticks > MAX_PREDICTION ? MAX_PREDICTION : ticks);
+
+}
+
+void RollbackSession::startRound(GameState& state) {
+
+	state.arena.setJournaling(true);
+
+}
+
+void RollbackSession::inputArrived(int player, unsigned int at, PLAYERINPUT input) {
+
+	if (at < tick && at < rollbackFrom && steps[at % WINDOW].inputs[player] != input) {
+		rollbackFrom = at;
+	}
+
+}
+
+PLAYERINPUT RollbackSession::guess(int player, unsigned int at) const {
+
+	if (hasInput(player, at)) {
+		return inputs[at % WINDOW][player];
+	}
+	// The latest input in an unbroken run from this player
+	unsigned int latest = peers[player].received;
+	return latest > settled ? inputs[(latest - 1) % WINDOW][player] : lastSettled[player];
+
+}
+
+void RollbackSession::step(GameState& state) {
+
+	SimSave(state, snapshots[tick % MAX_PREDICTION]);
+
+	SettledTick& record = steps[tick % WINDOW];
+	for (int i = 0; i < MAX_PLAYERS; i++) {
+		record.inputs[i] = i < config.players ? guess(i, tick) : PI_NONE;
+	}
+	SimStep(state, record.inputs);
+	record.roundTick = state.tick;
+	record.over = state.over;
+	record.hash = StateHash(state);
+	setHash(tick, record.hash);
+	tick++;
+
+}
+
+void RollbackSession::settleSteps(GameState& state) {
+
+	// Any wrong guess has been put right, so a tick with every input in was stepped on them
+	unsigned int until = settled;
+	while (until < tick && hasAllInputs(until)) {
+		until++;
+	}
+	if (until > settled) {
+		memcpy(lastSettled, inputs[(until - 1) % WINDOW], sizeof(lastSettled));
+		settle(until);
+	}
+
+	// Nothing will be restored from before the oldest unsettled tick
+	state.arena.forget(settled < tick ? snapshots[settled % MAX_PREDICTION].arenaJournal :
+		state.arena.getJournalPosition());
+
+}
+
+RollbackResult RollbackSession::advance(GameState& state, PLAYERINPUT localInput) {
+
+	if (transport == nullptr) {
+		return ROLLBACK_STALLED;
+	}
+
+	receivePackets();
+
+	// Go back to before the first wrong guess and step forward to the present
+	if (rollbackFrom != NO_ROLLBACK) {
+		unsigned int present = tick;
+		unsigned int depth = present - rollbackFrom;
+		SimRestore(state, snapshots[rollbackFrom % MAX_PREDICTION]);
+		tick = rollbackFrom;
+		rollbackFrom = NO_ROLLBACK;
+		// Ticks guessed past a round that now ends sooner are dropped, so the
+		// next round starts after the same tick as on the other peers
+		while (tick < present && !state.over) {
+			step(state);
+		}
+		stats.rollbacks++;
+		stats.resimulated += depth;
+		if (depth > stats.deepestRollback) {
+			stats.deepestRollback = depth;
+		}
+		corrected = true;
+	}
+	settleSteps(state);
+
+	RollbackResult result = ROLLBACK_STEPPED;
+	if (state.over) {
+		result = settled == tick ? ROLLBACK_ROUND_OVER : ROLLBACK_STALLED;
+	}
+	else if (tick - settled >= (unsigned int)maxPrediction) {
+		result = ROLLBACK_STALLED;
+	}
+	else {
+		scheduleLocalInput(localInput);
+		step(state);
+		stats.ticks++;
+		settleSteps(state);
+	}
+	if (result == ROLLBACK_STALLED) {
+		stats.stalls++;
+	}
+
+	sendPackets();
+	return result;
+
+}
+
+bool RollbackSession::nextSettled(SettledTick& settledTick) {
+
+	if (handedOut >= settled) {
+		return false;
+	}
+	settledTick = steps[handedOut % WINDOW];
+	handedOut++;
+	return true;
+
+}
+
+bool RollbackSession::takeCorrected() {
+
+	bool was = corrected;
+	corrected = false;
+	return was;
+
+}
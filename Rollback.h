@@ -0,0 +1,88 @@
+#ifndef ROLLBACK_H
+#define ROLLBACK_H
+
+#include "NetSession.h"
+
+// What a tick did, handed out once it is final, for a replay recorder
+struct SettledTick {
+	PLAYERINPUT inputs[MAX_PLAYERS];
+	unsigned int roundTick;		// state.tick after the step
+	bool over;
+	uint64_t hash;				// StateHash() after the step
+};
+
+enum RollbackResult {
+	ROLLBACK_STEPPED,			// State moved on a tick, maybe on guessed input
+	ROLLBACK_STALLED,			// Too far ahead of the inputs that are in to guess on
+	ROLLBACK_ROUND_OVER			// The round's last tick is final, start the next one
+};
+
+// GGPO-style rollback. Ticks are stepped as soon as they are due, guessing
+// that a remote player still holds whatever they held in their latest
+// input to arrive. A snapshot is kept from before every tick stepped on a
+// guess; when an input turns up that differs from the guess, the state is
+// restored from before that tick and stepped forward again to the present.
+// Guesses about held keys are nearly always right, so the game runs with
+// no delay and corrects itself a few ticks after a turn.
+//
+// Snapshots are SimSnapshot, plain data restored by memcpy with the trails
+// and arena wound back, so a rollback costs the ticks stepped again and
+// not the size of the round. Guessing stops maxPrediction ticks past the
+// last settled tick, bounding how far a rollback can go.
+//
+// A round only ends once its last tick is settled, so that every peer
+// starts the next round after the same tick whatever it guessed. Until then
+// advance() stalls on the finished round.
+class RollbackSession : public NetSession {
+public:
+	static const int MAX_PREDICTION = 32;
+
+protected:
+	int maxPrediction;
+	SimSnapshot snapshots[MAX_PREDICTION];	// State before each unsettled tick, at tick % MAX_PREDICTION
+	SettledTick steps[WINDOW];				// What each tick was stepped with, guesses included, at tick % WINDOW
+	PLAYERINPUT lastSettled[MAX_PLAYERS];	// Inputs of the tick before settled, the guess for a player not heard since
+	unsigned int rollbackFrom;				// Earliest tick stepped on a wrong guess, NO_ROLLBACK if none
+	unsigned int handedOut;					// Settled ticks below this have been through nextSettled()
+	bool corrected;
+
+	virtual void inputArrived(int player, unsigned int at, PLAYERINPUT input);
+	PLAYERINPUT guess(int player, unsigned int at) const;
+	// Snapshot, then step the next tick on the best inputs there are
+	void step(GameState& state);
+	void settleSteps(GameState& state);
+
+public:
+	static const unsigned int NO_ROLLBACK = 0xffffffffu;
+
+	RollbackSession();
+
+	virtual bool start(const SessionConfig& config, Transport* transport, NetClock clock = NetNow);
+	// 1 to MAX_PREDICTION, 16 unless set
+	void setMaxPrediction(int ticks);
+
+	// Call after every SimStart(), the first included. Turns on the arena
+	// journal that rollbacks rewind.
+	void startRound(GameState& state);
+
+	// One call per game tick. Reads what has arrived, rolls back and steps
+	// forward again if a guess turned out wrong, then schedules localInput
+	// inputDelay ticks ahead and steps the next tick. Stalls instead once
+	// maxPrediction ticks are unsettled, or while a finished round waits
+	// for its last tick to settle. Sends to the peers whatever happened.
+	// On ROLLBACK_ROUND_OVER, SimStart() the next round and startRound().
+	RollbackResult advance(GameState& state, PLAYERINPUT localInput);
+
+	// Hand out the ticks that have settled since the last call, in order
+	bool nextSettled(SettledTick& settledTick);
+	// Whether a rollback has changed what was shown since the last call.
+	// Trails may have been rewound rather than grown.
+	bool takeCorrected();
+
+	int getMaxPrediction() const { return maxPrediction; };
+	// Ticks stepped past the last settled one
+	unsigned int getPrediction() const { return tick - settled; };
+
+};
+
+#endif
@@ -0,0 +1,177 @@
+#include "RoomClient.h"
+#include <cstring>
+
+using namespace std;
+
+static void writeU32(uint8_t* out, uint32_t value) {
+
+	out[0] = (uint8_t)value;
+	out[1] = (uint8_t)(value >> 8);
+	out[2] = (uint8_t)(value >> 16);
+	out[3] = (uint8_t)(value >> 24);
+
+}
+
+static uint32_t readU32(const uint8_t* in) {
+
+	return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+
+}
+
+static void writeHeader(uint8_t* out, uint8_t type, uint32_t token) {
+
+	out[0] = ROOM_MAGIC[0];
+	out[1] = ROOM_MAGIC[1];
+	out[2] = ROOM_VERSION;
+	out[3] = type;
+	writeU32(out + 4, token);
+
+}
+
+RoomClient::RoomClient() {
+
+	transport = nullptr;
+	token = 0;
+	wantedRoom = ROOM_ANY;
+	welcomed = false;
+	full = false;
+	room = ROOM_ANY;
+	player = -1;
+	players = 0;
+	tickRate = 0;
+	updateRate = 0;
+	lastJoin = 0;
+	memset(&stats, 0, sizeof(stats));
+
+}
+
+bool RoomClient::start(Transport* transport, uint32_t token, uint32_t room, NetClock clock) {
+
+	if (transport == nullptr || token == 0) {
+		return false;
+	}
+	this->transport = transport;
+	this->token = token;
+	this->clock = clock;
+	wantedRoom = room;
+	welcomed = false;
+	full = false;
+	this->room = ROOM_ANY;
+	player = -1;
+	players = 0;
+	lastJoin = 0;
+	view.clear();
+	memset(&stats, 0, sizeof(stats));
+	return true;
+
+}
+
+bool RoomClient::PacketToken(const uint8_t* data, size_t size, uint32_t& token) {
+
+	if (size < ROOM_HEADER || data[0] != ROOM_MAGIC[0] || data[1] != ROOM_MAGIC[1] || data[2] != ROOM_VERSION) {
+		return false;
+	}
+	token = readU32(data + 4);
+	return true;
+
+}
+
+void RoomClient::receive() {
+
+	if (transport == nullptr) {
+		return;
+	}
+	uint8_t packet[Transport::MAX_DATAGRAM];
+	size_t size;
+	while ((size = transport->receive(packet, sizeof(packet))) > 0) {
+		handlePacket(packet, size);
+	}
+
+}
+
+void RoomClient::handlePacket(const uint8_t* data, size_t size) {
+
+	uint32_t to;
+	if (!PacketToken(data, size, to) || to != token) {
+		return;
+	}
+	stats.bytesReceived += size;
+
+	switch (data[3]) {
+	case ROOM_WELCOME:
+		if (size >= ROOM_HEADER + 8) {
+			welcomed = true;
+			room = readU32(data + ROOM_HEADER);
+			player = data[ROOM_HEADER + 4];
+			players = data[ROOM_HEADER + 5];
+			tickRate = data[ROOM_HEADER + 6];
+			updateRate = data[ROOM_HEADER + 7];
+		}
+		break;
+	case ROOM_FULL:
+		full = !welcomed;
+		break;
+	case ROOM_STATE:
+		if (!welcomed) {
+			break;
+		}
+		switch (view.apply(data + ROOM_HEADER, size - ROOM_HEADER)) {
+		case VIEW_APPLIED:
+			stats.updates++;
+			if (size >= ROOM_HEADER + 12 && readU32(data + ROOM_HEADER + 8) == NO_VIEW) {
+				stats.fullUpdates++;
+			}
+			break;
+		case VIEW_STALE:
+			stats.stale++;
+			break;
+		case VIEW_NO_BASE:
+			stats.noBase++;
+			break;
+		default:
+			stats.mismatches++;
+			break;
+		}
+		break;
+	}
+
+}
+
+void RoomClient::send(PLAYERINPUT input) {
+
+	if (transport == nullptr) {
+		return;
+	}
+	uint8_t packet[ROOM_HEADER + 5];
+
+	if (!welcomed) {
+		long long now = clock();
+		if (lastJoin != 0 && now - lastJoin < JOIN_INTERVAL) {
+			return;
+		}
+		lastJoin = now;
+		writeHeader(packet, ROOM_JOIN, token);
+		writeU32(packet + ROOM_HEADER, wantedRoom);
+		transport->send(0, packet, ROOM_HEADER + 4);
+		return;
+	}
+
+	writeHeader(packet, ROOM_INPUT, token);
+	writeU32(packet + ROOM_HEADER, view.getLatestTick());
+	packet[ROOM_HEADER + 4] = input;
+	transport->send(0, packet, ROOM_HEADER + 5);
+
+}
+
+void RoomClient::leave() {
+
+	if (transport == nullptr || !welcomed) {
+		return;
+	}
+	uint8_t packet[ROOM_HEADER];
+	writeHeader(packet, ROOM_LEAVE, token);
+	transport->send(0, packet, ROOM_HEADER);
+	welcomed = false;
+	view.clear();
+
+}
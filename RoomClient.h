@@ -0,0 +1,71 @@
+#ifndef ROOM_CLIENT_H
+#define ROOM_CLIENT_H
+
+#include "RoomProtocol.h"
+#include "StateDelta.h"
+#include "Transport.h"
+
+struct RoomClientStats {
+	unsigned long long updates;			// Updates applied
+	unsigned long long fullUpdates;		// Of those, ones not encoded against an earlier view
+	unsigned long long stale;			// Arrived after a newer one
+	unsigned long long noBase;			// Against a view no longer kept
+	unsigned long long mismatches;		// Rebuilt the wrong state, or couldn't read it
+	unsigned long long bytesReceived;
+};
+
+// One player in a server's room, over any Transport with the server as
+// peer 0. Plays no part in the rules: it sends the keys it is given and
+// rebuilds the room from the server's updates. Several clients can share
+// a transport by handing each the packets whose token is theirs.
+class RoomClient {
+protected:
+	Transport* transport;
+	NetClock clock;
+	uint32_t token;
+	uint32_t wantedRoom;
+	bool welcomed;
+	bool full;
+	uint32_t room;
+	int player;
+	int players;
+	int tickRate;
+	int updateRate;
+	long long lastJoin;
+	RoomView view;
+	RoomClientStats stats;
+
+public:
+	// A join goes out this often until the server answers
+	static const long long JOIN_INTERVAL = 250000;
+
+	RoomClient();
+
+	// token must be non-zero and not used by another client of the server
+	bool start(Transport* transport, uint32_t token, uint32_t room = ROOM_ANY, NetClock clock = NetNow);
+	// Read everything waiting on a transport of this client's own
+	void receive();
+	void handlePacket(const uint8_t* data, size_t size);
+	// Once a frame: asks to join until welcomed, then sends input and what
+	// has been applied
+	void send(PLAYERINPUT input);
+	void leave();
+
+	// The token a server packet is for, false if it isn't one
+	static bool PacketToken(const uint8_t* data, size_t size, uint32_t& token);
+
+	bool isWelcomed() const { return welcomed; };
+	// The server turned us away
+	bool isFull() const { return full; };
+	uint32_t getToken() const { return token; };
+	uint32_t getRoom() const { return room; };
+	int getPlayer() const { return player; };
+	int getPlayers() const { return players; };
+	int getTickRate() const { return tickRate; };
+	int getUpdateRate() const { return updateRate; };
+	const RoomView& getView() const { return view; };
+	const RoomClientStats& getStats() const { return stats; };
+
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef ROOM_PROTOCOL_H
+#define ROOM_PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Datagrams between a GameServer and its RoomClients. Every one starts
+//   'L' 'R' version type u32 token
+// where the token is a number the client picked for itself, not zero. The
+// server knows a client by its token rather than its address, so one socket
+// can carry many clients and a client whose address changes stays in its
+// room. Little-endian throughout.
+//
+// Client to server:
+//   ROOM_JOIN    u32 room wanted, or ROOM_ANY. Repeated until welcomed.
+//   ROOM_INPUT   u32 tick of the newest update applied (NO_VIEW for none),
+//                u8 keys held. Sent once a frame.
+//   ROOM_LEAVE
+// Server to client:
+//   ROOM_WELCOME u32 room, u8 player, u8 players, u8 tick rate, u8 update rate
+//   ROOM_FULL    every room is full
+//   ROOM_STATE   an update as written by EncodeDelta()
+
+const uint8_t ROOM_MAGIC[2] = { 'L', 'R' };
+const uint8_t ROOM_VERSION = 1;
+const size_t ROOM_HEADER = 8;
+
+const uint8_t ROOM_JOIN = 1,
+			  ROOM_INPUT = 2,
+			  ROOM_LEAVE = 3,
+			  ROOM_WELCOME = 4,
+			  ROOM_FULL = 5,
+			  ROOM_STATE = 6;
+
+const uint32_t ROOM_ANY = 0xffffffffu;
+
+#endif
@@ -0,0 +1,490 @@
+#include "SearchAI.h"
+#include <cstdlib>
+
+using namespace std;
+
+static const int SCORE_INFINITE = 1 << 30;
+static const int SCORE_WIN = 1000000;
+
+static const uint8_t BOUND_EXACT = 0,
+					 BOUND_LOWER = 1,
+					 BOUND_UPPER = 2;
+
+static uint64_t mix(uint64_t value) {
+
+	value += 0x9e3779b97f4a7c15ULL;
+	value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+	return value ^ (value >> 31);
+
+}
+
+SearchAI::SearchAI(int player, long long budgetMicroseconds, int tableBits) {
+
+	this->player = player;
+	budget = budgetMicroseconds;
+	macroTicks = 1;
+	cellSize = 8;
+	maxDepth = 32;
+	windowSize = 512;
+
+	if (tableBits < 1) {
+		tableBits = 1;
+	}
+	table.assign((size_t)1 << tableBits, TableEntry());
+	tableMask = ((uint64_t)1 << tableBits) - 1;
+	generation = 0;
+	for (auto entryIter = table.begin(); entryIter != table.end(); entryIter++) {
+		entryIter->generation = 0xff;
+	}
+
+	key = 0;
+	timeUp = false;
+	stats = SearchStats();
+
+}
+
+SearchAI::~SearchAI() {
+
+}
+
+void SearchAI::buildBoard(const GameState& state) {
+
+	const SimConfig& config = state.config;
+	int arenaWidth = state.arena.getWidth();
+	int arenaHeight = state.arena.getHeight();
+	if (arenaWidth <= windowSize && arenaHeight <= windowSize) {
+		BoardFromState(board, state);
+		return;
+	}
+
+	// Centre on both heads while they fit with room round them, else on ours
+	const CycleState& me = state.cycles[player];
+	const CycleState& them = state.cycles[1 - player];
+	int centreX = me.headX(config);
+	int centreY = me.headY(config);
+	int apartX = them.headX(config) - centreX;
+	int apartY = them.headY(config) - centreY;
+	if (them.alive && abs(apartX) <= windowSize / 2 && abs(apartY) <= windowSize / 2) {
+		centreX += apartX / 2;
+		centreY += apartY / 2;
+	}
+
+	int width = arenaWidth < windowSize ? arenaWidth : windowSize;
+	int height = arenaHeight < windowSize ? arenaHeight : windowSize;
+	int left = centreX - width / 2;
+	int top = centreY - height / 2;
+	left = left < 0 ? 0 : (left > arenaWidth - width ? arenaWidth - width : left);
+	top = top < 0 ? 0 : (top > arenaHeight - height ? arenaHeight - height : top);
+	// Whole words only, moving the window at most 63 pixels left
+	left &= ~63;
+	BoardFromState(board, state, left, top, width, height);
+
+}
+
+void SearchAI::buildCoarse() {
+
+	int width = (board.blocked.getWidth() + cellSize - 1) / cellSize;
+	int height = (board.blocked.getHeight() + cellSize - 1) / cellSize;
+
+	if (coarse.getWidth() != width || coarse.getHeight() != height) {
+		coarse.resize(width, height);
+		taken.resize(width, height);
+		contested.resize(width, height);
+		for (int i = 0; i < BOARD_PLAYERS; i++) {
+			reach[i].resize(width, height);
+			front[i].resize(width, height);
+			grown[i].resize(width, height);
+		}
+	}
+	coarse.clear();
+
+	// A coarse cell is blocked if any pixel in it is
+	const uint64_t* words = board.blocked.getWords();
+	int wordsPerRow = board.blocked.getWordsPerRow();
+	for (int y = 0; y < board.blocked.getHeight(); y++) {
+		for (int i = 0; i < wordsPerRow; i++) {
+			uint64_t bits = words[y * wordsPerRow + i];
+			while (bits != 0) {
+				int x = i * 64 + PopCount64((bits & (~bits + 1)) - 1);
+				coarse.set(x / cellSize, y / cellSize);
+				bits &= bits - 1;
+			}
+		}
+	}
+
+}
+
+void SearchAI::mark(int x, int y) {
+
+	int pixel = y * board.blocked.getWidth() + x;
+	board.blocked.set(x, y);
+	undoPixels.push_back(pixel);
+	key ^= mix((uint64_t)pixel);
+
+	int cx = x / cellSize;
+	int cy = y / cellSize;
+	if (!coarse.get(cx, cy)) {
+		coarse.set(cx, cy);
+		undoCells.push_back(cy * coarse.getWidth() + cx);
+	}
+
+}
+
+bool SearchAI::makeMoves(const DIRECTION moves[BOARD_PLAYERS], Undo& undo) {
+
+	for (int i = 0; i < BOARD_PLAYERS; i++) {
+		undo.cycles[i] = board.cycles[i];
+	}
+	undo.pixels = undoPixels.size();
+	undo.cells = undoCells.size();
+	undo.key = key;
+
+	for (int i = 0; i < BOARD_PLAYERS; i++) {
+		BoardCycle& head = board.cycles[i];
+		if (head.alive && moves[i] != head.direction) {
+			head.direction = moves[i];
+			head.cooldown = board.turnDelay;
+		}
+	}
+
+	// Step both cycles together so head-on crashes are caught on the right tick
+	for (int tick = 0; tick < macroTicks; tick++) {
+		int nextX[BOARD_PLAYERS], nextY[BOARD_PLAYERS];
+		bool crashed[BOARD_PLAYERS];
+		bool anyCrashed = false;
+
+		for (int i = 0; i < BOARD_PLAYERS; i++) {
+			BoardCycle& head = board.cycles[i];
+			crashed[i] = false;
+			if (!head.alive) {
+				continue;
+			}
+			int dx, dy;
+			DirectionDelta(head.direction, dx, dy);
+			nextX[i] = head.x + dx;
+			nextY[i] = head.y + dy;
+			crashed[i] = board.blocked.get(nextX[i], nextY[i]);
+			for (int j = 0; j < i; j++) {
+				if (board.cycles[j].alive && nextX[j] == nextX[i] && nextY[j] == nextY[i]) {
+					crashed[i] = crashed[j] = true;
+				}
+			}
+		}
+
+		for (int i = 0; i < BOARD_PLAYERS; i++) {
+			BoardCycle& head = board.cycles[i];
+			if (!head.alive) {
+				continue;
+			}
+			head.x = nextX[i];
+			head.y = nextY[i];
+			if (crashed[i]) {
+				head.alive = false;
+				anyCrashed = true;
+			}
+			else {
+				mark(head.x, head.y);
+			}
+		}
+
+		if (anyCrashed) {
+			return false;
+		}
+	}
+
+	for (int i = 0; i < BOARD_PLAYERS; i++) {
+		BoardCycle& head = board.cycles[i];
+		head.cooldown = head.cooldown > macroTicks ? head.cooldown - macroTicks : 0;
+	}
+
+	return true;
+
+}
+
+void SearchAI::unmakeMoves(const Undo& undo) {
+
+	int width = board.blocked.getWidth();
+	while (undoPixels.size() > undo.pixels) {
+		int pixel = undoPixels.back();
+		board.blocked.reset(pixel % width, pixel / width);
+		undoPixels.pop_back();
+	}
+
+	int coarseWidth = coarse.getWidth();
+	while (undoCells.size() > undo.cells) {
+		int cell = undoCells.back();
+		coarse.reset(cell % coarseWidth, cell / coarseWidth);
+		undoCells.pop_back();
+	}
+
+	for (int i = 0; i < BOARD_PLAYERS; i++) {
+		board.cycles[i] = undo.cycles[i];
+	}
+	key = undo.key;
+
+}
+
+int SearchAI::generateMoves(int who, DIRECTION moves[3], int first) {
+
+	const BoardCycle& head = board.cycles[who];
+	int count = 0;
+
+	// Dead cycles still need a placeholder move
+	if (!head.alive) {
+		moves[0] = head.direction;
+		return 1;
+	}
+
+	DIRECTION candidates[3] = { head.direction, (DIRECTION)((head.direction + 1) & 3),
+		(DIRECTION)((head.direction + 3) & 3) };
+	int candidateCount = head.cooldown > 0 ? 1 : 3;
+
+	for (int i = 0; i < candidateCount; i++) {
+		int dx, dy;
+		DirectionDelta(candidates[i], dx, dy);
+		if (board.blocked.get(head.x + dx, head.y + dy)) {
+			continue;
+		}
+		if (candidates[i] == first && count > 0) {
+			moves[count] = moves[0];
+			moves[0] = candidates[i];
+		}
+		else {
+			moves[count] = candidates[i];
+		}
+		count++;
+	}
+
+	// Boxed in, any move loses
+	if (count == 0) {
+		moves[0] = head.direction;
+		count = 1;
+	}
+
+	return count;
+
+}
+
+int SearchAI::terminalScore(int ply) {
+
+	bool mine = board.cycles[player].alive;
+	bool theirs = false;
+	for (int i = 0; i < BOARD_PLAYERS; i++) {
+		if (i != player && board.cycles[i].alive) {
+			theirs = true;
+		}
+	}
+
+	if (!mine && !theirs) {
+		return 0;
+	}
+	if (!mine) {
+		return -SCORE_WIN + ply;
+	}
+	return SCORE_WIN - ply;
+
+}
+
+int SearchAI::evaluate() {
+
+	// Grow every cycle's region one coarse cell per step, cells reached by
+	// more than one cycle on the same step belong to nobody
+	taken.copyFrom(coarse);
+	int count[BOARD_PLAYERS];
+	for (int i = 0; i < BOARD_PLAYERS; i++) {
+		const BoardCycle& head = board.cycles[i];
+		front[i].clear();
+		count[i] = 0;
+		if (head.alive) {
+			front[i].set(head.x / cellSize, head.y / cellSize);
+			taken.set(head.x / cellSize, head.y / cellSize);
+		}
+	}
+
+	bool growing = true;
+	while (growing) {
+		growing = false;
+		for (int i = 0; i < BOARD_PLAYERS; i++) {
+			front[i].dilate(taken, grown[i]);
+			grown[i].andNot(taken);
+		}
+
+		contested.clear();
+		for (int i = 0; i < BOARD_PLAYERS; i++) {
+			for (int j = i + 1; j < BOARD_PLAYERS; j++) {
+				reach[i].copyFrom(grown[i]);
+				reach[i].andWith(grown[j]);
+				contested.orWith(reach[i]);
+			}
+		}
+
+		for (int i = 0; i < BOARD_PLAYERS; i++) {
+			grown[i].andNot(contested);
+			int added = grown[i].popcount();
+			if (added > 0) {
+				count[i] += added;
+				taken.orWith(grown[i]);
+				growing = true;
+			}
+			front[i].copyFrom(grown[i]);
+		}
+		taken.orWith(contested);
+	}
+
+	int score = 0;
+	for (int i = 0; i < BOARD_PLAYERS; i++) {
+		score += i == player ? count[i] : -count[i];
+	}
+	return score;
+
+}
+
+int SearchAI::search(int depth, int ply, int alpha, int beta, DIRECTION* bestMove) {
+
+	stats.nodes++;
+	if (chrono::steady_clock::now() >= deadline) {
+		timeUp = true;
+	}
+	if (timeUp) {
+		return 0;
+	}
+	if (depth == 0) {
+		return evaluate();
+	}
+
+	uint64_t nodeKey = key;
+	for (int i = 0; i < BOARD_PLAYERS; i++) {
+		const BoardCycle& head = board.cycles[i];
+		nodeKey ^= mix(((uint64_t)i << 56) ^ ((uint64_t)head.x << 32) ^ ((uint64_t)head.y << 8) ^
+			((uint64_t)head.direction << 4) ^ (head.cooldown > 0 ? 2 : 0) ^ (head.alive ? 1 : 0));
+	}
+
+	TableEntry& entry = table[nodeKey & tableMask];
+	int tableMove = -1;
+	if (entry.generation == generation && entry.key == nodeKey) {
+		stats.tableHits++;
+		tableMove = entry.move;
+		if (entry.depth >= depth && ply > 0) {
+			if (entry.bound == BOUND_EXACT ||
+				(entry.bound == BOUND_LOWER && entry.score >= beta) ||
+				(entry.bound == BOUND_UPPER && entry.score <= alpha)) {
+				return entry.score;
+			}
+		}
+	}
+
+	// Paranoid: we commit to a move, then every opponent answers it
+	DIRECTION mine[3], theirs[3];
+	int opponent = 1 - player;
+	int mineCount = generateMoves(player, mine, tableMove);
+	int theirCount = generateMoves(opponent, theirs, -1);
+
+	int alphaStart = alpha;
+	int best = -SCORE_INFINITE;
+	DIRECTION bestDirection = mine[0];
+
+	for (int m = 0; m < mineCount; m++) {
+		int worst = SCORE_INFINITE;
+		for (int o = 0; o < theirCount; o++) {
+			DIRECTION moves[BOARD_PLAYERS];
+			moves[player] = mine[m];
+			moves[opponent] = theirs[o];
+
+			Undo undo;
+			int score;
+			if (makeMoves(moves, undo)) {
+				score = search(depth - 1, ply + 1, alpha, worst < beta ? worst : beta, nullptr);
+			}
+			else {
+				score = terminalScore(ply + 1);
+			}
+			unmakeMoves(undo);
+
+			if (timeUp) {
+				return 0;
+			}
+			if (score < worst) {
+				worst = score;
+			}
+			if (worst <= alpha) {
+				break;
+			}
+		}
+
+		if (worst > best) {
+			best = worst;
+			bestDirection = mine[m];
+		}
+		if (best > alpha) {
+			alpha = best;
+		}
+		if (alpha >= beta) {
+			break;
+		}
+	}
+
+	entry.key = nodeKey;
+	entry.score = best;
+	entry.depth = (int8_t)depth;
+	entry.bound = best <= alphaStart ? BOUND_UPPER : (best >= beta ? BOUND_LOWER : BOUND_EXACT);
+	entry.move = bestDirection;
+	entry.generation = generation;
+
+	if (bestMove != nullptr) {
+		*bestMove = bestDirection;
+	}
+	return best;
+
+}
+
+PLAYERINPUT SearchAI::chooseInput(const GameState& state) {
+
+	const CycleState& me = state.cycles[player];
+
+	if (state.over || !me.alive) {
+		return PI_NONE;
+	}
+	// Cycles sit still until their first key press
+	if (me.speedx == 0 && me.speedy == 0) {
+		return DirectionInput(me.direction);
+	}
+	// Nothing to decide while the turn delay runs
+	if (me.changingDirection) {
+		return PI_NONE;
+	}
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	deadline = start + chrono::microseconds(budget);
+	timeUp = false;
+	stats = SearchStats();
+	generation = (uint8_t)(generation + 1 == 0xff ? 0 : generation + 1);
+
+	macroTicks = state.config.directionChangeDelay > 0 ? state.config.directionChangeDelay : 1;
+	buildBoard(state);
+	buildCoarse();
+	undoPixels.clear();
+	undoCells.clear();
+	key = 0;
+
+	DIRECTION best = me.direction;
+	for (int depth = 1; depth <= maxDepth; depth++) {
+		DIRECTION move;
+		int score = search(depth, 0, -SCORE_INFINITE, SCORE_INFINITE, &move);
+		if (timeUp) {
+			break;
+		}
+		best = move;
+		stats.depth = depth;
+		// Nothing deeper can change a forced result
+		if (score >= SCORE_WIN - 1000 || score <= -SCORE_WIN + 1000) {
+			break;
+		}
+	}
+
+	stats.microseconds = chrono::duration_cast<chrono::microseconds>(
+		chrono::steady_clock::now() - start).count();
+
+	return best != me.direction ? DirectionInput(best) : PI_NONE;
+
+}
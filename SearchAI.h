@@ -0,0 +1,106 @@
+#ifndef SEARCH_AI_H
+#define SEARCH_AI_H
+
+#include <chrono>
+#include <vector>
+#include <cstdint>
+#include "BitBoard.h"
+#include "CpuPlayer.h"
+
+// Computer player: paranoid alpha-beta over the arena with iterative
+// deepening and a transposition table, scored by Voronoi territory.
+//
+// A ply is one heading held for macroTicks ticks, which matches the turn
+// delay, so depth counts decisions rather than pixels. Territory is
+// measured on a coarse grid of cellSize x cellSize pixel cells to keep
+// each evaluation to a few microseconds.
+//
+// Arenas larger than windowSize are only searched in a window of that
+// size round the heads, since copying in the whole of a 20,000 x 20,000
+// arena would take many times the budget. Past the window edge counts as
+// a wall, and an opponent too far away to share the window is ignored.
+//
+// The opponent is always 1 - player, so player has to be blue or orange.
+
+struct SearchStats {
+	unsigned long long nodes;
+	unsigned long long tableHits;
+	int depth;					// Deepest fully searched depth, in move pairs
+	long long microseconds;
+
+	double nodesPerSecond() const {
+		return microseconds > 0 ? nodes * 1000000.0 / microseconds : 0.0;
+	};
+};
+
+class SearchAI : public CpuPlayer {
+protected:
+	struct TableEntry {
+		uint64_t key;
+		int score;
+		int8_t depth;
+		uint8_t bound;
+		uint8_t move;
+		uint8_t generation;
+	};
+
+	struct Undo {
+		BoardCycle cycles[BOARD_PLAYERS];
+		size_t pixels;
+		size_t cells;
+		uint64_t key;
+	};
+
+	int player;
+	long long budget;
+	int macroTicks;
+	int cellSize;
+	int maxDepth;
+	int windowSize;
+
+	std::vector<TableEntry> table;
+	uint64_t tableMask;
+	uint8_t generation;
+
+	ArenaBoard board;
+	BitBoard coarse;
+	BitBoard reach[BOARD_PLAYERS], front[BOARD_PLAYERS], grown[BOARD_PLAYERS];
+	BitBoard taken, contested;
+	std::vector<int> undoPixels;
+	std::vector<int> undoCells;
+	uint64_t key;
+
+	std::chrono::steady_clock::time_point deadline;
+	bool timeUp;
+	SearchStats stats;
+
+	void buildBoard(const GameState& state);
+	void buildCoarse();
+	void mark(int x, int y);
+	bool makeMoves(const DIRECTION moves[BOARD_PLAYERS], Undo& undo);
+	void unmakeMoves(const Undo& undo);
+	int generateMoves(int who, DIRECTION moves[3], int first);
+	int terminalScore(int ply);
+	int evaluate();
+	int search(int depth, int ply, int alpha, int beta, DIRECTION* bestMove);
+
+public:
+	SearchAI(int player, long long budgetMicroseconds = 8000, int tableBits = 18);
+	virtual ~SearchAI();
+
+	// Input for this tick. Searches only when the cycle is free to turn.
+	virtual PLAYERINPUT chooseInput(const GameState& state);
+
+	int getPlayer() { return player; };
+	void setBudget(long long budgetMicroseconds) { budget = budgetMicroseconds; };
+	long long getBudget() { return budget; };
+	void setCellSize(int size) { cellSize = size > 0 ? size : 1; };
+	void setMaxDepth(int depth) { maxDepth = depth; };
+	// Rounded up to whole 64 pixel words, 256 at least
+	void setWindowSize(int size) { windowSize = size > 256 ? (size + 63) & ~63 : 256; };
+	int getWindowSize() { return windowSize; };
+	const SearchStats& getStats() { return stats; };
+
+};
+
+#endif
@@ -0,0 +1,423 @@
+#include "Simulation.h"
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+using namespace std;
+
+static void turn(CycleState& cycle, PLAYERINPUT input, int maxSpeed) {
+
+	if (cycle.changingDirection) {
+
+		return;
+
+	}
+
+	if ((input & PI_UP) && cycle.speedy >= 0) {
+		cycle.speedy = cycle.speedy - 1 < -maxSpeed ? -maxSpeed : cycle.speedy - 1;
+		cycle.speedx = 0;
+		cycle.direction = DIR_UP;
+		cycle.changingDirection = true;
+	}
+	else if ((input & PI_DOWN) && cycle.speedy <= 0) {
+		cycle.speedy = cycle.speedy + 1 > maxSpeed ? maxSpeed : cycle.speedy + 1;
+		cycle.speedx = 0;
+		cycle.direction = DIR_DOWN;
+		cycle.changingDirection = true;
+	}
+	else if ((input & PI_LEFT) && cycle.speedx >= 0) {
+		cycle.speedx = cycle.speedx - 1 < -maxSpeed ? -maxSpeed : cycle.speedx - 1;
+		cycle.speedy = 0;
+		cycle.direction = DIR_LEFT;
+		cycle.changingDirection = true;
+	}
+	else if ((input & PI_RIGHT) && cycle.speedx <= 0) {
+		cycle.speedx = cycle.speedx + 1 > maxSpeed ? maxSpeed : cycle.speedx + 1;
+		cycle.speedy = 0;
+		cycle.direction = DIR_RIGHT;
+		cycle.changingDirection = true;
+	}
+
+}
+
+static int clamp(int value, int low, int high) {
+
+	return value < low ? low : (value > high ? high : value);
+
+}
+
+static bool hasMoved(const CycleState& cycle, int x, int y) {
+
+	return cycle.trail.empty() || cycle.trail.back().x != x || cycle.trail.back().y != y;
+
+}
+
+static void addTrailPoint(GameState& state, CycleState& cycle, int x, int y) {
+
+	if (cycle.trail.empty()) {
+		state.arena.set(x, y);
+	}
+	else {
+		state.arena.stampSegment(cycle.trail.back().x, cycle.trail.back().y, x, y);
+	}
+
+	cycle.trail.append(x, y);
+
+}
+
+SimConfig DefaultSimConfig(int width, int height, int players) {
+
+	SimConfig config;
+	config.width = width;
+	config.height = height;
+	config.cycleWidth = 28;
+	config.cycleHeight = 28;
+	config.maxSpeed = 4;
+	config.directionChangeDelay = 20;	// A third of a second at 60 ticks per second
+	config.seed = 0;
+	config.players = players;
+	return config;
+
+}
+
+void DirectionDelta(DIRECTION direction, int& dx, int& dy) {
+
+	static const int deltas[4][2] = { { 0, -1 }, { 1, 0 }, { 0, 1 }, { -1, 0 } };
+	dx = deltas[direction & 3][0];
+	dy = deltas[direction & 3][1];
+
+}
+
+PLAYERINPUT DirectionInput(DIRECTION direction) {
+
+	static const PLAYERINPUT inputs[4] = { PI_UP, PI_RIGHT, PI_DOWN, PI_LEFT };
+	return inputs[direction & 3];
+
+}
+
+bool IsDeadly(const GameState& state, int x, int y) {
+
+	const SimConfig& config = state.config;
+	int xPos = x - config.cycleWidth / 2;
+	int yPos = y - config.cycleHeight / 2;
+
+	return xPos <= 0 || xPos >= config.width - config.cycleWidth ||
+		yPos <= 0 || yPos >= config.height - config.cycleHeight ||
+		state.arena.isOccupied(x, y);
+
+}
+
+static uint64_t hashMix(uint64_t hash, uint64_t value) {
+
+	hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+	hash = (hash ^ (hash >> 31)) * 0xbf58476d1ce4e5b9ULL;
+	return hash ^ (hash >> 29);
+
+}
+
+uint64_t StateHash(const GameState& state) {
+
+	uint64_t hash = hashMix(0, state.tick);
+	hash = hashMix(hash, (uint64_t)(state.over ? 1 : 0) | ((uint64_t)(state.winner + 1) << 1));
+
+	for (int i = 0; i < state.config.players; i++) {
+		const CycleState& cycle = state.cycles[i];
+		hash = hashMix(hash, (uint64_t)(uint32_t)cycle.xPos | ((uint64_t)(uint32_t)cycle.yPos << 32));
+		hash = hashMix(hash, (uint64_t)(uint32_t)cycle.speedx | ((uint64_t)(uint32_t)cycle.speedy << 32));
+		hash = hashMix(hash, (uint64_t)cycle.direction | ((uint64_t)cycle.changingDirection << 8) |
+			((uint64_t)cycle.alive << 9) | ((uint64_t)(uint32_t)cycle.directionChangeCounter << 16));
+		hash = hashMix(hash, cycle.trail.getLength() | ((uint64_t)cycle.trail.getPointCount() << 40));
+	}
+
+	return hash;
+
+}
+
+void SimStart(GameState& state, const SimConfig& config, Arena* arena) {
+
+	state.config = config;
+	state.config.players = clamp(config.players, 2, MAX_PLAYERS);
+	state.tick = 0;
+	state.over = false;
+	state.winner = -1;
+
+	if (state.arena.getWidth() != config.width ||
+		state.arena.getHeight() != config.height) {
+		state.arena.resize(config.width, config.height);
+	}
+	else {
+		state.arena.clear();
+	}
+
+	int players = state.config.players;
+	int columns = (players + 1) / 2;
+	for (int i = 0; i < MAX_PLAYERS; i++) {
+		CycleState& cycle = state.cycles[i];
+		cycle.speedx = 0;
+		cycle.speedy = 0;
+		cycle.changingDirection = false;
+		cycle.directionChangeCounter = 0;
+		cycle.alive = true;
+		cycle.trail.reset(arena);
+		cycle.crashX = cycle.crashY = 0;
+		cycle.crashStep = cycle.crashSteps = 0;
+
+		// Even players start near the bottom facing up, odd ones near the
+		// top facing down, one pair per column spread over the width
+		int column = i / 2;
+		cycle.xPos = config.width * (column + 1) / (columns + 1);
+		cycle.yPos = i % 2 == 0 ? config.height - 50 : 25;
+		cycle.direction = i % 2 == 0 ? DIR_UP : DIR_DOWN;
+		if (i >= players) {
+			cycle.alive = false;
+		}
+	}
+
+}
+
+// A moment within a tick: step pixels into a move of steps pixels
+struct TickTime {
+	int step;
+	int steps;
+};
+
+// Exact comparison by cross-multiplying, a move of no pixels happens at 0
+static int compareTime(TickTime a, TickTime b) {
+
+	long long left = (long long)a.step * (b.steps > 0 ? b.steps : 1);
+	long long right = (long long)b.step * (a.steps > 0 ? a.steps : 1);
+	return left < right ? -1 : (left > right ? 1 : 0);
+
+}
+
+// One tick of a head's travel, from where it was (not included) along a
+// straight line of length pixels
+struct HeadMove {
+	int x, y;
+	int dx, dy;
+	int length;
+};
+
+// A pixel some head crosses this tick, and when
+struct SweepStep {
+	TickTime time;
+	int player;
+	int x, y;
+};
+
+// Every head's pixels for the tick being stepped. Kept from call to call
+// so ticks stop allocating once it has grown, and one per thread since
+// batch runs step many rounds at once.
+static thread_local vector<SweepStep> sweep;
+
+void SimStep(GameState& state, const PLAYERINPUT inputs[]) {
+
+	if (state.over) {
+
+		return;
+
+	}
+
+	const SimConfig& config = state.config;
+	int players = config.players;
+	int maxX = config.width - config.cycleWidth;
+	int maxY = config.height - config.cycleHeight;
+
+	HeadMove moves[MAX_PLAYERS];
+	for (int i = 0; i < players; i++) {
+		CycleState& cycle = state.cycles[i];
+		HeadMove& move = moves[i];
+		move.x = cycle.headX(config);
+		move.y = cycle.headY(config);
+		move.dx = move.dy = move.length = 0;
+		if (!cycle.alive) {
+			continue;
+		}
+		turn(cycle, inputs[i], config.maxSpeed);
+		cycle.xPos = clamp(cycle.xPos + cycle.speedx, 0, maxX);
+		cycle.yPos = clamp(cycle.yPos + cycle.speedy, 0, maxY);
+		int dx = cycle.headX(config) - move.x;
+		int dy = cycle.headY(config) - move.y;
+		move.dx = dx > 0 ? 1 : (dx < 0 ? -1 : 0);
+		move.dy = dy > 0 ? 1 : (dy < 0 ? -1 : 0);
+		move.length = dx != 0 ? dx * move.dx : dy * move.dy;
+	}
+
+	bool hit[MAX_PLAYERS];
+	TickTime crashTime[MAX_PLAYERS];
+	for (int i = 0; i < players; i++) {
+		hit[i] = false;
+	}
+
+	// Gather the pixels every head crosses. Edges and trails laid before
+	// this tick are the same for everyone, so a head's pixels stop at the
+	// first of those.
+	sweep.clear();
+	for (int i = 0; i < players; i++) {
+		const CycleState& cycle = state.cycles[i];
+		const HeadMove& move = moves[i];
+		if (!cycle.alive) {
+			continue;
+		}
+		if (move.length == 0) {
+			if (cycle.xPos <= 0 || cycle.xPos >= maxX || cycle.yPos <= 0 || cycle.yPos >= maxY) {
+				hit[i] = true;
+				crashTime[i].step = crashTime[i].steps = 0;
+				state.cycles[i].crashX = move.x;
+				state.cycles[i].crashY = move.y;
+			}
+			continue;
+		}
+		for (int k = 1; k <= move.length; k++) {
+			SweepStep step = { { k, move.length }, i, move.x + move.dx * k, move.y + move.dy * k };
+			sweep.push_back(step);
+			if (IsDeadly(state, step.x, step.y)) {
+				break;
+			}
+		}
+	}
+
+	// Play the pixels out in time order against the one shared arena,
+	// laying each down as it is crossed. Whoever reaches a pixel later than
+	// another head finds it occupied, heads arriving on the same pixel at
+	// the same moment all crash, and a crashed cycle lays nothing further,
+	// so every cycle costs the same however many others there are.
+	sort(sweep.begin(), sweep.end(), [](const SweepStep& a, const SweepStep& b) {
+		int order = compareTime(a.time, b.time);
+		if (order != 0) {
+			return order < 0;
+		}
+		if (a.y != b.y) {
+			return a.y < b.y;
+		}
+		if (a.x != b.x) {
+			return a.x < b.x;
+		}
+		return a.player < b.player;
+	});
+	bool crashes[MAX_PLAYERS];
+	size_t first = 0;
+	while (first < sweep.size()) {
+		// One moment: each head crosses at most one pixel in it
+		size_t last = first + 1;
+		while (last < sweep.size() && compareTime(sweep[last].time, sweep[first].time) == 0) {
+			last++;
+		}
+
+		// Decide every crash before laying anything down, so heads arriving
+		// together see each other rather than each other's trail
+		size_t same = first;
+		while (same < last) {
+			size_t end = same + 1;
+			while (end < last && sweep[end].x == sweep[same].x && sweep[end].y == sweep[same].y) {
+				end++;
+			}
+			int arriving = 0;
+			for (size_t e = same; e < end; e++) {
+				if (!hit[sweep[e].player]) {
+					arriving++;
+				}
+			}
+			bool deadly = arriving > 1 || IsDeadly(state, sweep[same].x, sweep[same].y);
+			for (size_t e = same; e < end; e++) {
+				crashes[e - first] = deadly && !hit[sweep[e].player];
+			}
+			same = end;
+		}
+
+		for (size_t e = first; e < last; e++) {
+			const SweepStep& step = sweep[e];
+			if (crashes[e - first]) {
+				CycleState& cycle = state.cycles[step.player];
+				hit[step.player] = true;
+				crashTime[step.player] = step.time;
+				cycle.crashX = step.x;
+				cycle.crashY = step.y;
+			}
+			else if (!hit[step.player]) {
+				state.arena.set(step.x, step.y);
+			}
+		}
+		first = last;
+	}
+
+	// A crashed cycle stops where it hit, its trail up to the pixel before
+	for (int i = 0; i < players; i++) {
+		if (hit[i]) {
+			CycleState& cycle = state.cycles[i];
+			const HeadMove& move = moves[i];
+			cycle.crashStep = crashTime[i].step;
+			cycle.crashSteps = crashTime[i].steps;
+			cycle.xPos = cycle.crashX - config.cycleWidth / 2;
+			cycle.yPos = cycle.crashY - config.cycleHeight / 2;
+			if (cycle.crashStep > 1) {
+				addTrailPoint(state, cycle, move.x + move.dx * (cycle.crashStep - 1),
+					move.y + move.dy * (cycle.crashStep - 1));
+			}
+		}
+	}
+
+	int alive = 0;
+	for (int i = 0; i < players; i++) {
+		CycleState& cycle = state.cycles[i];
+		if (hit[i]) {
+			cycle.alive = false;
+			continue;
+		}
+		if (!cycle.alive) {
+			continue;
+		}
+		alive++;
+		state.winner = i;
+		int x = cycle.headX(config);
+		int y = cycle.headY(config);
+		if (hasMoved(cycle, x, y)) {
+			addTrailPoint(state, cycle, x, y);
+		}
+		if (cycle.changingDirection) {
+			cycle.directionChangeCounter++;
+			if (cycle.directionChangeCounter >= config.directionChangeDelay) {
+				cycle.directionChangeCounter = 0;
+				cycle.changingDirection = false;
+			}
+		}
+	}
+
+	if (alive <= 1) {
+		state.over = true;
+		if (alive == 0) {
+			state.winner = -1;
+		}
+	}
+
+	state.tick++;
+
+}
+
+static_assert(std::is_trivially_copyable<SimSnapshot>::value, "snapshots are copied with memcpy");
+
+void SimSave(const GameState& state, SimSnapshot& snapshot) {
+
+	snapshot.tick = state.tick;
+	snapshot.over = state.over;
+	snapshot.winner = state.winner;
+	for (int i = 0; i < MAX_PLAYERS; i++) {
+		memcpy(&snapshot.cycles[i], static_cast<const CycleCore*>(&state.cycles[i]), sizeof(CycleCore));
+		snapshot.trails[i] = state.cycles[i].trail.mark();
+	}
+	snapshot.arenaJournal = state.arena.getJournalPosition();
+
+}
+
+void SimRestore(GameState& state, const SimSnapshot& snapshot) {
+
+	state.tick = snapshot.tick;
+	state.over = snapshot.over;
+	state.winner = snapshot.winner;
+	for (int i = 0; i < MAX_PLAYERS; i++) {
+		memcpy(static_cast<CycleCore*>(&state.cycles[i]), &snapshot.cycles[i], sizeof(CycleCore));
+		state.cycles[i].trail.rewind(snapshot.trails[i]);
+	}
+	state.arena.rewind(snapshot.arenaJournal);
+
+}
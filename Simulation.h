@@ -0,0 +1,125 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include "OccupancyGrid.h"
+#include "Trail.h"
+
+// Headless Lightcycles rules. Nothing in here touches a window, a device
+// context or the keyboard, so the same step() drives the Win32 front end,
+// bots and server-side runs.
+
+typedef uint8_t PLAYERINPUT;
+const PLAYERINPUT PI_NONE = 0x00,
+				  PI_UP = 0x01,
+				  PI_DOWN = 0x02,
+				  PI_LEFT = 0x04,
+				  PI_RIGHT = 0x08;
+
+// Matches the cycle bitmaps, which are named after their rotation
+typedef uint8_t DIRECTION;
+const DIRECTION DIR_UP = 0,
+				DIR_RIGHT = 1,
+				DIR_DOWN = 2,
+				DIR_LEFT = 3;
+
+// The first two players keep the colors of the original two-player game
+const int PLAYER_BLUE = 0,
+		  PLAYER_ORANGE = 1,
+		  MAX_PLAYERS = 16;
+
+struct SimConfig {
+	int width;					// Arena size in pixels
+	int height;
+	int cycleWidth;				// Size of a cycle bitmap, the trail leaves from its centre
+	int cycleHeight;
+	int maxSpeed;
+	int directionChangeDelay;	// Ticks before a cycle may turn again
+	unsigned int seed;			// Recorded so a round can be reproduced
+	int players;				// Cycles in the round, 2 to MAX_PLAYERS
+};
+
+// Everything about a cycle but its trail. Plain data, so snapshots can
+// copy it with memcpy.
+struct CycleCore {
+	int xPos, yPos;				// Top-left corner of the cycle bitmap
+	int speedx, speedy;
+	DIRECTION direction;
+	bool changingDirection;
+	int directionChangeCounter;
+	bool alive;
+	// Where the head hit, and when: crashStep of the crashSteps pixels the
+	// cycle moved that tick. 0 of 0 when it crashed without moving.
+	int crashX, crashY;
+	int crashStep, crashSteps;
+
+	float crashFraction() const { return crashSteps > 0 ? (float)crashStep / crashSteps : 0.0f; };
+
+	int headX(const SimConfig& config) const { return xPos + config.cycleWidth / 2; };
+	int headY(const SimConfig& config) const { return yPos + config.cycleHeight / 2; };
+};
+
+struct CycleState : CycleCore {
+	Trail trail;				// Head positions, as corners
+};
+
+struct GameState {
+	SimConfig config;
+	unsigned int tick;
+	CycleState cycles[MAX_PLAYERS];	// The first config.players are in the round
+	OccupancyGrid arena;		// Every pixel covered by any trail
+	bool over;
+	int winner;					// Player index, or -1 for a draw
+};
+
+// A state as it stood after some tick of its round, small enough to keep
+// one per tick: the cycles without their trails, how far each trail had
+// got and where the arena's journal was. Trails and the arena only grow
+// within a round, so they are wound back instead of copied, and the whole
+// snapshot is plain data at about 1.4 KB. Only good within the round it
+// was taken in, with the arena journaling from the round's start.
+struct SimSnapshot {
+	unsigned int tick;
+	bool over;
+	int winner;
+	CycleCore cycles[MAX_PLAYERS];
+	TrailMark trails[MAX_PLAYERS];
+	size_t arenaJournal;
+};
+
+SimConfig DefaultSimConfig(int width = 500, int height = 400, int players = 2);
+
+// Unit step for a direction, y grows downwards
+void DirectionDelta(DIRECTION direction, int& dx, int& dy);
+PLAYERINPUT DirectionInput(DIRECTION direction);
+
+// Whether a cycle whose centre lands on x, y crashes into an edge or a trail
+bool IsDeadly(const GameState& state, int x, int y);
+
+// Hash of everything that decides what happens next, for spotting desyncs.
+// Trails are covered by their lengths and corner counts since they only
+// ever grow.
+uint64_t StateHash(const GameState& state);
+
+// Reset the state for a new round. Trails are kept in arena if one is
+// given, which must then not be reset until the next SimStart(). Cycles
+// start in pairs along the top and bottom edges, blue and orange facing
+// each other in the middle when there are two of them.
+void SimStart(GameState& state, const SimConfig& config, Arena* arena = nullptr);
+
+// Advance one tick: turn, move, collide, extend trails. Each head is swept
+// over every pixel it crosses, so no speed or tick rate lets it skip a
+// trail, and two cycles crossing paths in the same tick are ordered by
+// when each reaches the crossing. The round ends when one cycle or none
+// is left. inputs holds one entry per player in the round.
+void SimStep(GameState& state, const PLAYERINPUT inputs[]);
+
+// Save the state for SimRestore(), which puts it back however many ticks
+// of the same round have been stepped since. Restoring costs the trail
+// corners and arena pixels added since, never the whole round.
+void SimSave(const GameState& state, SimSnapshot& snapshot);
+void SimRestore(GameState& state, const SimSnapshot& snapshot);
+
+#endif
@@ -0,0 +1,150 @@
+#include "SoftwareRenderer.h"
+
+using namespace std;
+
+uint32_t PlayerColor(int player) {
+
+	static const uint32_t colors[MAX_PLAYERS] = {
+		0x0000ff, 0xffa500, 0x00c800, 0xdc0000, 0xffff00, 0x00ffff, 0xff69b4, 0x8000c0,
+		0xffffff, 0xa0ff00, 0x008080, 0x8b4513, 0x87cefa, 0xee82ee, 0xa0a0a0, 0x808000
+	};
+	return colors[player & (MAX_PLAYERS - 1)];
+
+}
+
+RenderImages::RenderImages() {
+
+	background = nullptr;
+	sprites = nullptr;
+	for (int i = 0; i < MAX_PLAYERS; i++) {
+		for (int d = 0; d < 4; d++) {
+			SpriteRect none = { 0, 0, 0, 0 };
+			cycles[i][d] = none;
+		}
+		trailColors[i] = PlayerColor(i);
+	}
+	backgroundColor = 0;
+	colorKey = PIXEL_MAGENTA;
+
+}
+
+SoftwareRenderer::SoftwareRenderer(int width, int height)
+	: frame(width, height), trails(width, height) {
+
+	for (int i = 0; i < MAX_PLAYERS; i++) {
+		paintedTrails[i] = Trail().mark();
+	}
+	trailsStale = true;
+
+}
+
+void SoftwareRenderer::resize(int width, int height) {
+
+	frame.resize(width, height);
+	trails.resize(width, height);
+	trailsStale = true;
+
+}
+
+void SoftwareRenderer::drawNewSegments(const CycleState& cycle, int player, uint32_t color) {
+
+	for (TrailSegment segment : cycle.trail.segmentsSince(paintedTrails[player])) {
+		trails.drawLine(segment.x1, segment.y1, segment.x2, segment.y2, color);
+	}
+	paintedTrails[player] = cycle.trail.mark();
+
+}
+
+void SoftwareRenderer::render(const GameState& state, const RenderImages& images, const Camera& camera) {
+
+	if (camera.showsWholeArena()) {
+		render(state, images);
+	}
+	else {
+		renderView(state, images, camera);
+	}
+
+}
+
+void SoftwareRenderer::renderView(const GameState& state, const RenderImages& images, const Camera& camera) {
+
+	int left = camera.getX(), top = camera.getY();
+
+	frame.fill(images.backgroundColor);
+	const PixelImage* background = images.background;
+	if (background != nullptr && background->width > 0 && background->height > 0) {
+		for (int y = top - top % background->height; y < top + camera.getHeight(); y += background->height) {
+			for (int x = left - left % background->width; x < left + camera.getWidth(); x += background->width) {
+				frame.blit(*background, x - left, y - top);
+			}
+		}
+	}
+
+	for (int i = 0; i < state.config.players; i++) {
+		for (TrailSegment segment : state.cycles[i].trail.segments()) {
+			if (camera.clip(segment)) {
+				frame.drawLine(segment.x1 - left, segment.y1 - top, segment.x2 - left, segment.y2 - top,
+					images.trailColors[i]);
+			}
+		}
+	}
+
+	// The trail layer only ever holds the whole arena
+	trailsStale = true;
+
+	if (images.sprites == nullptr) {
+		return;
+	}
+	for (int i = 0; i < state.config.players; i++) {
+		const CycleState& cycle = state.cycles[i];
+		const SpriteRect& source = images.cycles[i][cycle.direction & 3];
+		if (source.width > 0 && camera.sees(cycle.xPos, cycle.yPos,
+			cycle.xPos + source.width - 1, cycle.yPos + source.height - 1)) {
+			frame.blitKeyed(images.sprites->pixels.data() + (size_t)source.y * images.sprites->width + source.x,
+				source.width, source.height, images.sprites->width, cycle.xPos - left, cycle.yPos - top,
+				images.colorKey);
+		}
+	}
+
+}
+
+void SoftwareRenderer::render(const GameState& state, const RenderImages& images) {
+
+	// A trail that doesn't carry on from what was painted means a new round
+	int players = state.config.players;
+	for (int i = 0; i < players; i++) {
+		if (paintedTrails[i].length > 0 && !state.cycles[i].trail.extends(paintedTrails[i])) {
+			trailsStale = true;
+		}
+	}
+
+	if (trailsStale) {
+		trails.fill(images.backgroundColor);
+		if (images.background != nullptr) {
+			trails.blit(*images.background, 0, 0);
+		}
+		for (int i = 0; i < MAX_PLAYERS; i++) {
+			paintedTrails[i] = Trail().mark();
+		}
+		trailsStale = false;
+	}
+
+	for (int i = 0; i < players; i++) {
+		drawNewSegments(state.cycles[i], i, images.trailColors[i]);
+	}
+
+	frame.copyFrom(trails);
+
+	if (images.sprites == nullptr) {
+		return;
+	}
+	for (int i = 0; i < players; i++) {
+		const CycleState& cycle = state.cycles[i];
+		const SpriteRect& source = images.cycles[i][cycle.direction & 3];
+		if (source.width > 0) {
+			frame.blitKeyed(images.sprites->pixels.data() + (size_t)source.y * images.sprites->width + source.x,
+				source.width, source.height, images.sprites->width, cycle.xPos, cycle.yPos, images.colorKey);
+		}
+	}
+
+}
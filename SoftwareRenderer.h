@@ -0,0 +1,56 @@
+#ifndef SOFTWARE_RENDERER_H
+#define SOFTWARE_RENDERER_H
+
+#include "Framebuffer.h"
+#include "SpriteAtlas.h"
+#include "Simulation.h"
+#include "Camera.h"
+
+// Trail color of each player: blue and orange, then colors picked to stay
+// apart from them and from each other on the background
+uint32_t PlayerColor(int player);
+
+// Images for one round; any of them may be missing
+struct RenderImages {
+	const PixelImage* background;
+	const PixelImage* sprites;					// Sheet holding every cycle frame
+	SpriteRect cycles[MAX_PLAYERS][4];			// Indexed by DIRECTION, no width when missing
+	uint32_t trailColors[MAX_PLAYERS];
+	uint32_t backgroundColor;					// Used when there is no background image
+	uint32_t colorKey;
+
+	RenderImages();
+};
+
+// Draws a GameState the way GamePaint() does, without GDI: a trail layer
+// holds the background plus every trail segment drawn so far and gets new
+// segments only, then each frame is one copy of the layer plus the cycles
+// blitted with their color key.
+//
+// An arena bigger than the frame is drawn through a camera instead: the
+// background repeats across the arena and each frame draws only the trail
+// segments and cycles in view, clipped to it.
+class SoftwareRenderer {
+protected:
+	Framebuffer frame;
+	Framebuffer trails;
+	TrailMark paintedTrails[MAX_PLAYERS];	// How far each trail had got when last drawn
+	bool trailsStale;
+
+	void drawNewSegments(const CycleState& cycle, int player, uint32_t color);
+	void renderView(const GameState& state, const RenderImages& images, const Camera& camera);
+
+public:
+	SoftwareRenderer(int width = 0, int height = 0);
+
+	void resize(int width, int height);
+	// Redraw the trail layer from scratch on the next render, call on a new round
+	void reset() { trailsStale = true; };
+	void render(const GameState& state, const RenderImages& images);
+	void render(const GameState& state, const RenderImages& images, const Camera& camera);
+
+	Framebuffer& getFrame() { return frame; };
+
+};
+
+#endif
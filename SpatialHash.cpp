@@ -0,0 +1,87 @@
+#include "SpatialHash.h"
+#include <algorithm>
+
+using namespace std;
+
+SpatialHash::SpatialHash(int cellShift) {
+
+	this->cellShift = cellShift;
+	tests = 0;
+
+}
+
+const vector<CollisionPair>& SpatialHash::findPairs(const int32_t* left, const int32_t* top,
+	const int32_t* right, const int32_t* bottom, int count) {
+
+	pairs.clear();
+	entries.clear();
+	entryBuckets.clear();
+	tests = 0;
+
+	// A power of two at least twice the rect count keeps buckets short
+	uint32_t bucketCount = 16;
+	while (bucketCount < (uint32_t)count * 2) {
+		bucketCount *= 2;
+	}
+	uint32_t mask = bucketCount - 1;
+	bucketStart.assign(bucketCount + 1, 0);
+
+	// File each rect under every cell it touches. The shift rounds toward
+	// minus infinity, so negative coordinates land in the right cell.
+	for (int i = 0; i < count; i++) {
+		int32_t x0 = left[i] >> cellShift, x1 = right[i] >> cellShift;
+		int32_t y0 = top[i] >> cellShift, y1 = bottom[i] >> cellShift;
+		for (int32_t cy = y0; cy <= y1; cy++) {
+			for (int32_t cx = x0; cx <= x1; cx++) {
+				uint32_t bucket = bucketOf(cx, cy, mask);
+				Entry entry = { i, cx, cy, left[i], top[i], right[i], bottom[i] };
+				entries.push_back(entry);
+				entryBuckets.push_back(bucket);
+				bucketStart[bucket + 1]++;
+			}
+		}
+	}
+
+	// Counting sort by bucket, stable so each bucket lists rects in index order
+	for (uint32_t b = 0; b < bucketCount; b++) {
+		bucketStart[b + 1] += bucketStart[b];
+	}
+	sorted.resize(entries.size());
+	bucketNext.assign(bucketStart.begin(), bucketStart.end() - 1);
+	for (size_t e = 0; e < entries.size(); e++) {
+		sorted[bucketNext[entryBuckets[e]]++] = entries[e];
+	}
+	entries.swap(sorted);
+
+	for (uint32_t b = 0; b < bucketCount; b++) {
+		for (uint32_t m = bucketStart[b]; m < bucketStart[b + 1]; m++) {
+			const Entry& first = entries[m];
+			for (uint32_t n = m + 1; n < bucketStart[b + 1]; n++) {
+				const Entry& second = entries[n];
+				// Other cells can hash to the same bucket
+				if (first.cellX != second.cellX || first.cellY != second.cellY) {
+					continue;
+				}
+				tests++;
+				if (first.left > second.right || first.right < second.left ||
+					first.top > second.bottom || first.bottom < second.top) {
+					continue;
+				}
+				// A pair sharing several cells is reported from just one, the
+				// cell holding the top-left corner of the overlap
+				if ((max(first.left, second.left) >> cellShift) != first.cellX ||
+					(max(first.top, second.top) >> cellShift) != first.cellY) {
+					continue;
+				}
+				CollisionPair pair = { first.index, second.index };
+				pairs.push_back(pair);
+			}
+		}
+	}
+
+	sort(pairs.begin(), pairs.end(), [](const CollisionPair& a, const CollisionPair& b) {
+		return a.first != b.first ? a.first < b.first : a.second < b.second;
+	});
+	return pairs;
+
+}
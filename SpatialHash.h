@@ -0,0 +1,67 @@
+#ifndef SPATIAL_HASH_H
+#define SPATIAL_HASH_H
+
+#include <cstdint>
+#include <vector>
+
+// Two overlapping rects, by index, first < second
+struct CollisionPair {
+	int first;
+	int second;
+};
+
+// Broad phase for rect collisions. Each rect is filed under every grid
+// cell it touches, the cells hashed into a table sized to the rect count
+// so the world needs no fixed extent, and only rects sharing a cell are
+// tested against each other. The table is rebuilt from scratch on every
+// call with a counting sort, which costs two passes over the rects and no
+// allocation once it has grown.
+//
+// Rects are inclusive on all four sides, like Sprite::testCollision(), and
+// the pairs come back sorted by first then second index, so the result
+// does not depend on the hashing.
+class SpatialHash {
+protected:
+	// The rect is copied in so the pair tests read entries in order
+	// instead of jumping around the caller's columns
+	struct Entry {
+		int index;
+		int32_t cellX;
+		int32_t cellY;
+		int32_t left;
+		int32_t top;
+		int32_t right;
+		int32_t bottom;
+	};
+
+	int cellShift;
+	std::vector<uint32_t> bucketStart;
+	std::vector<Entry> entries;
+	std::vector<uint32_t> entryBuckets;
+	std::vector<Entry> sorted;
+	std::vector<uint32_t> bucketNext;
+	std::vector<CollisionPair> pairs;
+	unsigned long long tests;
+
+	uint32_t bucketOf(int32_t cellX, int32_t cellY, uint32_t mask) const {
+		return ((uint32_t)cellX * 73856093u ^ (uint32_t)cellY * 19349663u) & mask;
+	};
+
+public:
+	// Cells are 1 << cellShift units square, best about the size of a rect
+	SpatialHash(int cellShift = 5);
+
+	void setCellShift(int shift) { cellShift = shift; };
+	int getCellShift() const { return cellShift; };
+
+	// Every overlapping pair among count rects given as columns
+	const std::vector<CollisionPair>& findPairs(const int32_t* left, const int32_t* top,
+		const int32_t* right, const int32_t* bottom, int count);
+
+	const std::vector<CollisionPair>& getPairs() const { return pairs; };
+	// Rect tests made by the last findPairs()
+	unsigned long long getTests() const { return tests; };
+
+};
+
+#endif
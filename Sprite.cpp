@@ -11,6 +11,8 @@ Sprite::Sprite(BitMap* bitmap) {
 	SetRect(&bounds, 0, 0, 640, 480);
 	boundsAction = BA_STOP;
 	hidden = false;
+	hasFrame = false;
+	pool = NULL;
 }
 
 Sprite::Sprite(BitMap* bitmap, RECT& bounds, BOUNDSACTION boundsAction) {
@@ -45,6 +47,8 @@ Sprite::Sprite(BitMap* bitmap, RECT& bounds, BOUNDSACTION boundsAction) {
 	CopyRect(&(this->bounds), &bounds);
 	this->boundsAction = boundsAction;
 	hidden = false;
+	hasFrame = false;
+	pool = NULL;
 }
 
 Sprite::Sprite(BitMap* bitmap, POINT position, POINT velocity, int zOrder,
@@ -59,6 +63,8 @@ Sprite::Sprite(BitMap* bitmap, POINT position, POINT velocity, int zOrder,
 	CopyRect(&bounds, &boundary);
 	boundsAction = ba;
 	hidden = false;
+	hasFrame = false;
+	pool = NULL;
 }
 
 SPRITEACTION Sprite::Update() {
@@ -154,10 +160,24 @@ SPRITEACTION Sprite::Update() {
 
 void Sprite::Draw(HDC hdc) {
 	if (bitmap != NULL && !hidden) {
-		bitmap->draw(hdc, position.left, position.top, true);
+		if (hasFrame) {
+			bitmap->draw(hdc, position.left, position.top, frame, true);
+		}
+		else {
+			bitmap->draw(hdc, position.left, position.top, true);
+		}
 	}
 }
 
+void Sprite::setFrame(const RECT& source) {
+	CopyRect(&frame, &source);
+	hasFrame = true;
+	// The sprite takes the size of the frame
+	position.right = position.left + (frame.right - frame.left);
+	position.bottom = position.top + (frame.bottom - frame.top);
+	calcCollisionRect();
+}
+
 bool Sprite::isPointInside(int x, int y) {
 	POINT p;
 	p.x = x;
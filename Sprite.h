@@ -3,12 +3,8 @@
 
 #include "Windows.h"
 #include "BitMap.h"
-
-typedef WORD BOUNDSACTION;
-const BOUNDSACTION BA_STOP = 0,
-				   BA_WRAP = 1,
-				   BA_BOUNCE = 2,
-				   BA_DIE = 3;
+#include "SpriteStore.h"	// BOUNDSACTION
+#include "Arena.h"
 
 typedef WORD SPRITEACTION;
 const SPRITEACTION SA_NONE = 0x0000L,
@@ -18,6 +14,8 @@ class Sprite {
 	
 protected:
 	BitMap* bitmap;
+	RECT frame;
+	bool hasFrame;
 	RECT position;
 	POINT velocity;
 	int zOrder;
@@ -25,6 +23,7 @@ protected:
 	BOUNDSACTION boundsAction;
 	bool hidden;
 	RECT collision;
+	PoolBase* pool;		// Where the sprite was made, NULL if it was new'd
 	virtual void calcCollisionRect();
 
 public:
@@ -39,6 +38,9 @@ public:
 
 	void Draw(HDC);
 
+	// Draw only this part of the bitmap, e.g. one frame of a sprite sheet
+	void setFrame(const RECT&);
+
 	bool isPointInside(int x, int y);
 
 	RECT& getPosition() {
@@ -100,18 +102,26 @@ public:
 
 	int getWidth() {
 
-		return bitmap->getWidth();
+		return hasFrame ? frame.right - frame.left : bitmap->getWidth();
 
 	};
 
 	int getHeight() {
 
-		return bitmap->getHeight();
+		return hasFrame ? frame.bottom - frame.top : bitmap->getHeight();
 
 	};
 
 	bool testCollision(Sprite*);
 
+	PoolBase* getPool() {
+		return pool;
+	};
+
+	void setPool(PoolBase* p) {
+		pool = p;
+	};
+
 	RECT& getCollision() {
 		return collision;
 	};
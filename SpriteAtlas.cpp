@@ -0,0 +1,153 @@
+#include "SpriteAtlas.h"
+#include "BmpImage.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+using namespace std;
+
+SpriteAtlas::SpriteAtlas(int padding) {
+
+	this->padding = padding > 0 ? padding : 0;
+
+}
+
+int SpriteAtlas::add(const string& name, const PixelImage& frame) {
+
+	SpriteRect rect = { 0, 0, frame.width, frame.height };
+	names.push_back(name);
+	frames.push_back(rect);
+	pending.resize(frames.size());
+	pending.back() = frame;
+	return (int)frames.size() - 1;
+
+}
+
+void SpriteAtlas::pack(int maxWidth, uint32_t key) {
+
+	// Frames already in the sheet are carried over into the new layout
+	for (size_t i = 0; i < frames.size(); i++) {
+		if (i >= pending.size() || pending[i].pixels.empty()) {
+			if (i >= pending.size()) {
+				pending.resize(frames.size());
+			}
+			const SpriteRect& rect = frames[i];
+			pending[i].resize(rect.width, rect.height);
+			for (int y = 0; y < rect.height; y++) {
+				memcpy(&pending[i].pixels[(size_t)y * rect.width], getPixels((int)i) + (size_t)y * sheet.width,
+					rect.width * sizeof(uint32_t));
+			}
+		}
+	}
+
+	vector<int> order(frames.size());
+	for (size_t i = 0; i < order.size(); i++) {
+		order[i] = (int)i;
+	}
+	stable_sort(order.begin(), order.end(), [this](int a, int b) {
+		return frames[a].height > frames[b].height;
+	});
+
+	for (size_t i = 0; i < frames.size(); i++) {
+		if (frames[i].width + padding * 2 > maxWidth) {
+			maxWidth = frames[i].width + padding * 2;
+		}
+	}
+
+	// Shelf packing: fill a row left to right, start a new row below when full
+	int x = padding, y = padding, shelfHeight = 0, width = 0;
+	for (size_t i = 0; i < order.size(); i++) {
+		SpriteRect& rect = frames[order[i]];
+		if (x + rect.width + padding > maxWidth && x > padding) {
+			x = padding;
+			y += shelfHeight + padding;
+			shelfHeight = 0;
+		}
+		rect.x = x;
+		rect.y = y;
+		x += rect.width + padding;
+		if (x > width) {
+			width = x;
+		}
+		if (rect.height > shelfHeight) {
+			shelfHeight = rect.height;
+		}
+	}
+	int height = y + shelfHeight + padding;
+
+	sheet.resize(width, height);
+	std::fill(sheet.pixels.begin(), sheet.pixels.end(), key);
+	for (size_t i = 0; i < frames.size(); i++) {
+		const SpriteRect& rect = frames[i];
+		for (int row = 0; row < rect.height; row++) {
+			memcpy(&sheet.pixels[(size_t)(rect.y + row) * width + rect.x],
+				&pending[i].pixels[(size_t)row * rect.width], rect.width * sizeof(uint32_t));
+		}
+	}
+	pending.clear();
+
+}
+
+bool SpriteAtlas::save(const string& sheetName, const string& tableName) const {
+
+	if (!SaveBmp(sheetName, sheet)) {
+		return false;
+	}
+	ofstream table(tableName.c_str(), ios::trunc);
+	for (size_t i = 0; i < frames.size() && table; i++) {
+		table << names[i] << ' ' << frames[i].x << ' ' << frames[i].y << ' '
+			<< frames[i].width << ' ' << frames[i].height << '\n';
+	}
+	return (bool)table;
+
+}
+
+bool SpriteAtlas::load(const string& sheetName, const string& tableName) {
+
+	clear();
+
+	BmpFile file;
+	ifstream table(tableName.c_str());
+	if (!table || !file.open(sheetName)) {
+		return false;
+	}
+	file.getView().toPixelImage(sheet);
+
+	string name;
+	SpriteRect rect;
+	while (table >> name >> rect.x >> rect.y >> rect.width >> rect.height) {
+		if (rect.x < 0 || rect.y < 0 || rect.width <= 0 || rect.height <= 0 ||
+			rect.width > sheet.width - rect.x || rect.height > sheet.height - rect.y) {
+			clear();
+			return false;
+		}
+		names.push_back(name);
+		frames.push_back(rect);
+	}
+	if (!table.eof()) {
+		clear();
+		return false;
+	}
+	return true;
+
+}
+
+void SpriteAtlas::clear() {
+
+	names.clear();
+	frames.clear();
+	pending.clear();
+	sheet = PixelImage();
+
+}
+
+int SpriteAtlas::find(const string& name) const {
+
+	for (size_t i = 0; i < names.size(); i++) {
+		if (names[i] == name) {
+			return (int)i;
+		}
+	}
+	return -1;
+
+}
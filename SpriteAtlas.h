@@ -0,0 +1,56 @@
+#ifndef SPRITE_ATLAS_H
+#define SPRITE_ATLAS_H
+
+#include <string>
+#include <vector>
+#include "Framebuffer.h"
+
+struct SpriteRect {
+	int x;
+	int y;
+	int width;
+	int height;
+};
+
+// Every frame of every sprite packed into one sheet, looked up through a
+// table of sub-rects. One sheet means one bitmap handle however many
+// players and skins there are, and the frames sit next to each other in
+// memory instead of in separate allocations.
+//
+// On disk an atlas is the sheet as a .bmp plus a text table with one
+// "name x y width height" line per frame.
+class SpriteAtlas {
+protected:
+	std::vector<std::string> names;
+	std::vector<SpriteRect> frames;
+	std::vector<PixelImage> pending;	// Frames added since the last pack()
+	PixelImage sheet;
+	int padding;
+
+public:
+	SpriteAtlas(int padding = 1);
+
+	// Queue a frame for the next pack(), returns its index
+	int add(const std::string& name, const PixelImage& frame);
+	// Lay the frames out in shelves, tallest first, no wider than maxWidth
+	// unless a single frame is. Padding is filled with the color key.
+	void pack(int maxWidth = 1024, uint32_t key = PIXEL_MAGENTA);
+
+	bool save(const std::string& sheetName, const std::string& tableName) const;
+	bool load(const std::string& sheetName, const std::string& tableName);
+	void clear();
+
+	// Index of a frame by name, -1 if there is none
+	int find(const std::string& name) const;
+	int getFrameCount() const { return (int)frames.size(); };
+	const SpriteRect& getFrame(int index) const { return frames[index]; };
+	const std::string& getName(int index) const { return names[index]; };
+	// Top-left pixel of a frame, rows are getSheet().width pixels apart
+	const uint32_t* getPixels(int index) const {
+		return sheet.pixels.data() + (size_t)frames[index].y * sheet.width + frames[index].x;
+	};
+	const PixelImage& getSheet() const { return sheet; };
+
+};
+
+#endif
@@ -0,0 +1,376 @@
+#include "SpriteStore.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define SPRITE_STORE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+// a where mask is all ones, b where it is zero
+static inline int32_t Select(int32_t mask, int32_t a, int32_t b) {
+	return (a & mask) | (b & ~mask);
+}
+
+uint32_t SpriteStore::add(const SpriteRect& position, int vx, int vy, const SpriteRect& bounds,
+	BOUNDSACTION action, uint32_t img) {
+
+	uint32_t id;
+	if (!freeIds.empty()) {
+		id = freeIds.back();
+		freeIds.pop_back();
+	}
+	else {
+		id = (uint32_t)slots.size();
+		slots.push_back(-1);
+	}
+	slots[id] = (int)x.size();
+
+	x.push_back(position.x);
+	y.push_back(position.y);
+	velocityX.push_back(vx);
+	velocityY.push_back(vy);
+	width.push_back(position.width);
+	height.push_back(position.height);
+	boundsLeft.push_back(bounds.x);
+	boundsTop.push_back(bounds.y);
+	boundsRight.push_back(bounds.x + bounds.width);
+	boundsBottom.push_back(bounds.y + bounds.height);
+	boundsAction.push_back(action);
+	collisionLeft.push_back(0);
+	collisionTop.push_back(0);
+	collisionRight.push_back(0);
+	collisionBottom.push_back(0);
+	killed.push_back(0);
+	hidden.push_back(0);
+	image.push_back(img);
+	ids.push_back(id);
+
+	calcCollisionRect((int)x.size() - 1);
+	return id;
+
+}
+
+void SpriteStore::remove(uint32_t id) {
+
+	int index = indexOf(id);
+	if (index >= 0) {
+		killed[index] = 1;
+		compact();
+	}
+
+}
+
+void SpriteStore::clear() {
+
+	x.clear();
+	y.clear();
+	velocityX.clear();
+	velocityY.clear();
+	width.clear();
+	height.clear();
+	boundsLeft.clear();
+	boundsTop.clear();
+	boundsRight.clear();
+	boundsBottom.clear();
+	boundsAction.clear();
+	collisionLeft.clear();
+	collisionTop.clear();
+	collisionRight.clear();
+	collisionBottom.clear();
+	killed.clear();
+	hidden.clear();
+	image.clear();
+	ids.clear();
+	slots.clear();
+	freeIds.clear();
+
+}
+
+void SpriteStore::reserve(size_t count) {
+
+	x.reserve(count);
+	y.reserve(count);
+	velocityX.reserve(count);
+	velocityY.reserve(count);
+	width.reserve(count);
+	height.reserve(count);
+	boundsLeft.reserve(count);
+	boundsTop.reserve(count);
+	boundsRight.reserve(count);
+	boundsBottom.reserve(count);
+	boundsAction.reserve(count);
+	collisionLeft.reserve(count);
+	collisionTop.reserve(count);
+	collisionRight.reserve(count);
+	collisionBottom.reserve(count);
+	killed.reserve(count);
+	hidden.reserve(count);
+	image.reserve(count);
+	ids.reserve(count);
+
+}
+
+void SpriteStore::setPosition(int index, int px, int py) {
+
+	x[index] = px;
+	y[index] = py;
+	calcCollisionRect(index);
+
+}
+
+// Half the size of the sprite, centered, as Sprite::calcCollisionRect()
+void SpriteStore::calcCollisionRect(int index) {
+
+	int32_t xShrink = width[index] / 2;
+	int32_t yShrink = height[index] / 2;
+	collisionLeft[index] = x[index] + xShrink;
+	collisionTop[index] = y[index] + yShrink;
+	collisionRight[index] = x[index] + width[index] - xShrink;
+	collisionBottom[index] = y[index] + height[index] - yShrink;
+
+}
+
+// Sprites begin to end, one at a time. The columns are separate restrict
+// pointers so the compiler knows they never overlap and may vectorize this
+// too where it is allowed to.
+static int UpdateScalar(int begin, int end, int32_t* __restrict px, int32_t* __restrict py,
+	int32_t* __restrict pvx, int32_t* __restrict pvy,
+	const int32_t* __restrict pw, const int32_t* __restrict ph,
+	const int32_t* __restrict bl, const int32_t* __restrict bt,
+	const int32_t* __restrict br, const int32_t* __restrict bb,
+	const int32_t* __restrict action,
+	int32_t* __restrict cl, int32_t* __restrict ct,
+	int32_t* __restrict cr, int32_t* __restrict cb, int32_t* __restrict dead) {
+
+	int deaths = 0;
+
+	// Every bounds action is worked out for every sprite and the right one
+	// selected, which costs a few spare adds but keeps all lanes in step
+	for (int i = begin; i < end; i++) {
+		int32_t w = pw[i], h = ph[i];
+		int32_t vx = pvx[i], vy = pvy[i];
+		int32_t nx = px[i] + vx;
+		int32_t ny = py[i] + vy;
+
+		// BA_STOP and BA_BOUNCE clamp to the bounds. Conditions are all-ones
+		// or zero masks combined with & and |, as branches stop vectorizing.
+		int32_t lowX = -(nx < bl[i]), highX = -(nx + w > br[i]) & ~lowX;
+		int32_t lowY = -(ny < bt[i]), highY = -(ny + h > bb[i]) & ~lowY;
+		int32_t clampX = Select(lowX, bl[i], Select(highX, br[i] - w, nx));
+		int32_t clampY = Select(lowY, bt[i], Select(highY, bb[i] - h, ny));
+
+		// BA_WRAP comes back in on the far side once fully out
+		int32_t outLeft = -(nx + w < bl[i]), outRight = -(nx > br[i]) & ~outLeft;
+		int32_t outTop = -(ny + h < bt[i]), outBottom = -(ny > bb[i]) & ~outTop;
+		int32_t wrapX = Select(outLeft, br[i], Select(outRight, bl[i] - w, nx));
+		int32_t wrapY = Select(outTop, bb[i], Select(outBottom, bt[i] - h, ny));
+
+		int32_t a = action[i];
+		int32_t wrap = -(a == BA_WRAP), bounce = -(a == BA_BOUNCE), die = -(a == BA_DIE);
+		int32_t stop = ~(wrap | bounce | die);
+
+		int32_t newX = Select(wrap, wrapX, Select(die, nx, clampX));
+		int32_t newY = Select(wrap, wrapY, Select(die, ny, clampY));
+		px[i] = newX;
+		py[i] = newY;
+
+		int32_t stopped = stop & (lowX | highX | lowY | highY);
+		int32_t flipX = bounce & (lowX | highX);
+		int32_t flipY = bounce & (lowY | highY);
+		pvx[i] = ~stopped & Select(flipX, -vx, vx);
+		pvy[i] = ~stopped & Select(flipY, -vy, vy);
+
+		int32_t gone = die & (outLeft | outRight | outTop | outBottom) & 1;
+		dead[i] = gone;
+		deaths += gone;
+
+		int32_t xShrink = w / 2, yShrink = h / 2;
+		cl[i] = newX + xShrink;
+		ct[i] = newY + yShrink;
+		cr[i] = newX + w - xShrink;
+		cb[i] = newY + h - yShrink;
+	}
+
+	return deaths;
+
+}
+
+#ifdef SPRITE_STORE_SSE2
+
+static inline __m128i SelectSse2(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+#define LOAD(p) _mm_loadu_si128((const __m128i*)((p) + i))
+#define STORE(p, v) _mm_storeu_si128((__m128i*)((p) + i), (v))
+
+// UpdateScalar() four sprites at a time. SSE2 is part of every x64 CPU, so
+// unlike the framebuffer blits this needs no run-time check. Returns how
+// many sprites it did, the caller finishes the rest.
+static int UpdateSse2(int count, int& deaths, int32_t* px, int32_t* py, int32_t* pvx, int32_t* pvy,
+	const int32_t* pw, const int32_t* ph, const int32_t* bl, const int32_t* bt,
+	const int32_t* br, const int32_t* bb, const int32_t* action,
+	int32_t* cl, int32_t* ct, int32_t* cr, int32_t* cb, int32_t* dead) {
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i wrapAction = _mm_set1_epi32(BA_WRAP);
+	const __m128i bounceAction = _mm_set1_epi32(BA_BOUNCE);
+	const __m128i dieAction = _mm_set1_epi32(BA_DIE);
+	__m128i goneTotal = zero;
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i w = LOAD(pw), h = LOAD(ph);
+		__m128i vx = LOAD(pvx), vy = LOAD(pvy);
+		__m128i left = LOAD(bl), top = LOAD(bt), right = LOAD(br), bottom = LOAD(bb);
+		__m128i nx = _mm_add_epi32(LOAD(px), vx);
+		__m128i ny = _mm_add_epi32(LOAD(py), vy);
+		__m128i farX = _mm_add_epi32(nx, w);
+		__m128i farY = _mm_add_epi32(ny, h);
+
+		__m128i lowX = _mm_cmplt_epi32(nx, left);
+		__m128i highX = _mm_andnot_si128(lowX, _mm_cmpgt_epi32(farX, right));
+		__m128i lowY = _mm_cmplt_epi32(ny, top);
+		__m128i highY = _mm_andnot_si128(lowY, _mm_cmpgt_epi32(farY, bottom));
+		__m128i clampX = SelectSse2(lowX, left, SelectSse2(highX, _mm_sub_epi32(right, w), nx));
+		__m128i clampY = SelectSse2(lowY, top, SelectSse2(highY, _mm_sub_epi32(bottom, h), ny));
+
+		__m128i outLeft = _mm_cmplt_epi32(farX, left);
+		__m128i outRight = _mm_andnot_si128(outLeft, _mm_cmpgt_epi32(nx, right));
+		__m128i outTop = _mm_cmplt_epi32(farY, top);
+		__m128i outBottom = _mm_andnot_si128(outTop, _mm_cmpgt_epi32(ny, bottom));
+		__m128i wrapX = SelectSse2(outLeft, right, SelectSse2(outRight, _mm_sub_epi32(left, w), nx));
+		__m128i wrapY = SelectSse2(outTop, bottom, SelectSse2(outBottom, _mm_sub_epi32(top, h), ny));
+
+		__m128i a = LOAD(action);
+		__m128i wrap = _mm_cmpeq_epi32(a, wrapAction);
+		__m128i bounce = _mm_cmpeq_epi32(a, bounceAction);
+		__m128i die = _mm_cmpeq_epi32(a, dieAction);
+
+		__m128i newX = SelectSse2(wrap, wrapX, SelectSse2(die, nx, clampX));
+		__m128i newY = SelectSse2(wrap, wrapY, SelectSse2(die, ny, clampY));
+		STORE(px, newX);
+		STORE(py, newY);
+
+		__m128i hitX = _mm_or_si128(lowX, highX);
+		__m128i hitY = _mm_or_si128(lowY, highY);
+		__m128i stopped = _mm_andnot_si128(_mm_or_si128(_mm_or_si128(wrap, bounce), die),
+			_mm_or_si128(hitX, hitY));
+		__m128i flipX = _mm_and_si128(bounce, hitX);
+		__m128i flipY = _mm_and_si128(bounce, hitY);
+		STORE(pvx, _mm_andnot_si128(stopped, SelectSse2(flipX, _mm_sub_epi32(zero, vx), vx)));
+		STORE(pvy, _mm_andnot_si128(stopped, SelectSse2(flipY, _mm_sub_epi32(zero, vy), vy)));
+
+		__m128i gone = _mm_and_si128(die, _mm_or_si128(_mm_or_si128(outLeft, outRight),
+			_mm_or_si128(outTop, outBottom)));
+		STORE(dead, _mm_srli_epi32(gone, 31));
+		goneTotal = _mm_sub_epi32(goneTotal, gone);
+
+		// Sizes are never negative, so the shift is the same as w / 2
+		__m128i xShrink = _mm_srai_epi32(w, 1), yShrink = _mm_srai_epi32(h, 1);
+		STORE(cl, _mm_add_epi32(newX, xShrink));
+		STORE(ct, _mm_add_epi32(newY, yShrink));
+		STORE(cr, _mm_sub_epi32(_mm_add_epi32(newX, w), xShrink));
+		STORE(cb, _mm_sub_epi32(_mm_add_epi32(newY, h), yShrink));
+	}
+
+	int32_t lanes[4];
+	_mm_storeu_si128((__m128i*)lanes, goneTotal);
+	deaths += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	return i;
+
+}
+
+#undef LOAD
+#undef STORE
+
+#endif
+
+int SpriteStore::update(bool vectorized) {
+
+	int count = (int)x.size();
+	int deaths = 0;
+	int done = 0;
+
+#ifdef SPRITE_STORE_SSE2
+	if (vectorized) {
+		done = UpdateSse2(count, deaths, x.data(), y.data(), velocityX.data(), velocityY.data(),
+			width.data(), height.data(), boundsLeft.data(), boundsTop.data(),
+			boundsRight.data(), boundsBottom.data(), boundsAction.data(),
+			collisionLeft.data(), collisionTop.data(), collisionRight.data(), collisionBottom.data(),
+			killed.data());
+	}
+#else
+	(void)vectorized;
+#endif
+	deaths += UpdateScalar(done, count, x.data(), y.data(), velocityX.data(), velocityY.data(),
+		width.data(), height.data(), boundsLeft.data(), boundsTop.data(),
+		boundsRight.data(), boundsBottom.data(), boundsAction.data(),
+		collisionLeft.data(), collisionTop.data(), collisionRight.data(), collisionBottom.data(),
+		killed.data());
+
+	if (deaths > 0) {
+		compact();
+	}
+	return deaths;
+
+}
+
+// Drop every sprite marked killed, sliding the rest down in order
+void SpriteStore::compact() {
+
+	int count = (int)x.size();
+	int kept = 0;
+	for (int i = 0; i < count; i++) {
+		if (killed[i]) {
+			slots[ids[i]] = -1;
+			freeIds.push_back(ids[i]);
+			continue;
+		}
+		if (kept != i) {
+			x[kept] = x[i];
+			y[kept] = y[i];
+			velocityX[kept] = velocityX[i];
+			velocityY[kept] = velocityY[i];
+			width[kept] = width[i];
+			height[kept] = height[i];
+			boundsLeft[kept] = boundsLeft[i];
+			boundsTop[kept] = boundsTop[i];
+			boundsRight[kept] = boundsRight[i];
+			boundsBottom[kept] = boundsBottom[i];
+			boundsAction[kept] = boundsAction[i];
+			collisionLeft[kept] = collisionLeft[i];
+			collisionTop[kept] = collisionTop[i];
+			collisionRight[kept] = collisionRight[i];
+			collisionBottom[kept] = collisionBottom[i];
+			hidden[kept] = hidden[i];
+			image[kept] = image[i];
+			ids[kept] = ids[i];
+			slots[ids[kept]] = kept;
+		}
+		killed[kept] = 0;
+		kept++;
+	}
+
+	x.resize(kept);
+	y.resize(kept);
+	velocityX.resize(kept);
+	velocityY.resize(kept);
+	width.resize(kept);
+	height.resize(kept);
+	boundsLeft.resize(kept);
+	boundsTop.resize(kept);
+	boundsRight.resize(kept);
+	boundsBottom.resize(kept);
+	boundsAction.resize(kept);
+	collisionLeft.resize(kept);
+	collisionTop.resize(kept);
+	collisionRight.resize(kept);
+	collisionBottom.resize(kept);
+	killed.resize(kept);
+	hidden.resize(kept);
+	image.resize(kept);
+	ids.resize(kept);
+
+}
@@ -0,0 +1,86 @@
+#ifndef SPRITE_STORE_H
+#define SPRITE_STORE_H
+
+#include <cstdint>
+#include <vector>
+#include "SpriteAtlas.h"
+
+typedef uint16_t BOUNDSACTION;
+const BOUNDSACTION BA_STOP = 0,
+				   BA_WRAP = 1,
+				   BA_BOUNCE = 2,
+				   BA_DIE = 3;
+
+// Plain moving sprites kept as parallel arrays, one per field, instead of
+// one heap object each. update() is a single pass over the arrays with no
+// virtual call and no pointer chasing, written with selects instead of
+// branches so the compiler can vectorize it. It does what Sprite::Update()
+// does for each bounds action and refreshes the collision rects in the
+// same pass.
+//
+// Sprites are named by the id add() returns. Indexes into the arrays stay
+// valid until the next update() or remove(), which close the gaps left by
+// dead sprites (keeping the order they were added in).
+class SpriteStore {
+protected:
+	std::vector<int32_t> x, y;
+	std::vector<int32_t> velocityX, velocityY;
+	std::vector<int32_t> width, height;
+	std::vector<int32_t> boundsLeft, boundsTop, boundsRight, boundsBottom;
+	std::vector<int32_t> boundsAction;	// 32 bits wide like the other lanes
+	std::vector<int32_t> collisionLeft, collisionTop, collisionRight, collisionBottom;
+	std::vector<int32_t> killed;
+	std::vector<uint8_t> hidden;
+	std::vector<uint32_t> image;
+	std::vector<uint32_t> ids;
+	std::vector<int> slots;		// Index of each id, -1 once it is gone
+	std::vector<uint32_t> freeIds;
+
+	void calcCollisionRect(int index);
+	void compact();
+
+public:
+	// position gives the top-left corner and size
+	uint32_t add(const SpriteRect& position, int vx, int vy, const SpriteRect& bounds,
+		BOUNDSACTION action = BA_STOP, uint32_t image = 0);
+	void remove(uint32_t id);
+	void clear();
+	void reserve(size_t count);
+
+	// Move every sprite one step, returns how many died on the bounds.
+	// vectorized false keeps to the scalar loop, to check the SSE2 one against.
+	int update(bool vectorized = true);
+
+	// Index of a sprite, -1 if it is gone
+	int indexOf(uint32_t id) const {
+		return id < slots.size() ? slots[id] : -1;
+	};
+	void setPosition(int index, int px, int py);
+	void setVelocity(int index, int vx, int vy) {
+		velocityX[index] = vx;
+		velocityY[index] = vy;
+	};
+	void setHidden(int index, bool h) { hidden[index] = h ? 1 : 0; };
+
+	int getCount() const { return (int)x.size(); };
+	uint32_t getId(int index) const { return ids[index]; };
+	int getX(int index) const { return x[index]; };
+	int getY(int index) const { return y[index]; };
+	int getVelocityX(int index) const { return velocityX[index]; };
+	int getVelocityY(int index) const { return velocityY[index]; };
+	int getWidth(int index) const { return width[index]; };
+	int getHeight(int index) const { return height[index]; };
+	bool isHidden(int index) const { return hidden[index] != 0; };
+	uint32_t getImage(int index) const { return image[index]; };
+
+	// Whole columns, for passes over every sprite
+	const int32_t* getXs() const { return x.data(); };
+	const int32_t* getYs() const { return y.data(); };
+	const int32_t* getCollisionLefts() const { return collisionLeft.data(); };
+	const int32_t* getCollisionTops() const { return collisionTop.data(); };
+	const int32_t* getCollisionRights() const { return collisionRight.data(); };
+	const int32_t* getCollisionBottoms() const { return collisionBottom.data(); };
+
+};
+
+#endif
@@ -0,0 +1,428 @@
+#include "StateDelta.h"
+#include <cstring>
+
+using namespace std;
+
+// An update, after the packet header:
+//   u32 round, u32 tick, u32 base tick (NO_VIEW if in full), u8 over, u8 winner + 1, u32 view hash
+//   in full only: the SimConfig as varints
+//   u16 cycles changed, then for each a varint field mask and a zigzag varint difference per field set
+//   trail runs: u8 player, u16 count, count corners as zigzag differences from the one before,
+//   the first from the view's last corner, ended by END_OF_TRAILS
+static const size_t UPDATE_HEADER = 18;
+static const uint8_t END_OF_TRAILS = 0xff;
+static const int CYCLE_FIELDS = 12;
+
+static void writeU32(uint8_t* out, uint32_t value) {
+
+	out[0] = (uint8_t)value;
+	out[1] = (uint8_t)(value >> 8);
+	out[2] = (uint8_t)(value >> 16);
+	out[3] = (uint8_t)(value >> 24);
+
+}
+
+static uint32_t readU32(const uint8_t* in) {
+
+	return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+
+}
+
+// Bounded writing and reading of little-endian and variable-length values.
+// Running off the end sets a flag instead of touching memory, so a whole
+// section can be written or read before checking once.
+struct ByteWriter {
+	uint8_t* at;
+	uint8_t* end;
+	bool overflow;
+
+	void byte(uint8_t value) {
+		if (at < end) {
+			*at++ = value;
+		}
+		else {
+			overflow = true;
+		}
+	};
+	void u16(uint16_t value) {
+		byte((uint8_t)value);
+		byte((uint8_t)(value >> 8));
+	};
+	void varint(uint32_t value) {
+		while (value >= 0x80) {
+			byte((uint8_t)(value | 0x80));
+			value >>= 7;
+		}
+		byte((uint8_t)value);
+	};
+	void zigzag(int value) {
+		varint(((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+	};
+};
+
+struct ByteReader {
+	const uint8_t* at;
+	const uint8_t* end;
+	bool overflow;
+
+	uint8_t byte() {
+		if (at < end) {
+			return *at++;
+		}
+		overflow = true;
+		return 0;
+	};
+	uint16_t u16() {
+		uint16_t low = byte();
+		return (uint16_t)(low | (byte() << 8));
+	};
+	uint32_t varint() {
+		uint32_t value = 0;
+		for (int shift = 0; shift < 35; shift += 7) {
+			uint8_t next = byte();
+			value |= (uint32_t)(next & 0x7f) << shift;
+			if ((next & 0x80) == 0) {
+				return value;
+			}
+		}
+		overflow = true;
+		return 0;
+	};
+	int zigzag() {
+		uint32_t value = varint();
+		return (int)(value >> 1) ^ -(int)(value & 1);
+	};
+};
+
+// The cycle fields in the order of the field mask bits
+static int GetField(const CycleCore& cycle, int field) {
+
+	switch (field) {
+	case 0: return cycle.xPos;
+	case 1: return cycle.yPos;
+	case 2: return cycle.speedx;
+	case 3: return cycle.speedy;
+	case 4: return cycle.direction;
+	case 5: return cycle.changingDirection ? 1 : 0;
+	case 6: return cycle.directionChangeCounter;
+	case 7: return cycle.alive ? 1 : 0;
+	case 8: return cycle.crashX;
+	case 9: return cycle.crashY;
+	case 10: return cycle.crashStep;
+	default: return cycle.crashSteps;
+	}
+
+}
+
+static void SetField(CycleCore& cycle, int field, int value) {
+
+	switch (field) {
+	case 0: cycle.xPos = value; break;
+	case 1: cycle.yPos = value; break;
+	case 2: cycle.speedx = value; break;
+	case 3: cycle.speedy = value; break;
+	case 4: cycle.direction = (DIRECTION)value; break;
+	case 5: cycle.changingDirection = value != 0; break;
+	case 6: cycle.directionChangeCounter = value; break;
+	case 7: cycle.alive = value != 0; break;
+	case 8: cycle.crashX = value; break;
+	case 9: cycle.crashY = value; break;
+	case 10: cycle.crashStep = value; break;
+	default: cycle.crashSteps = value; break;
+	}
+
+}
+
+void ClearView(ClientView& view) {
+
+	memset(&view, 0, sizeof(view));
+	view.tick = NO_VIEW;
+	view.winner = -1;
+
+}
+
+uint32_t ViewHash(const ClientView& view, int players) {
+
+	// FNV-1a over the values rather than the bytes, which have padding
+	uint32_t hash = 2166136261u;
+	auto mix = [&hash](uint32_t value) {
+		for (int i = 0; i < 4; i++) {
+			hash = (hash ^ (uint8_t)(value >> (i * 8))) * 16777619u;
+		}
+	};
+	mix(view.round);
+	mix(view.tick);
+	mix(view.over ? 1 : 0);
+	mix((uint32_t)view.winner);
+	for (int i = 0; i < players && i < MAX_PLAYERS; i++) {
+		for (int field = 0; field < CYCLE_FIELDS; field++) {
+			mix((uint32_t)GetField(view.cycles[i], field));
+		}
+		mix(view.trailPoints[i]);
+		mix((uint32_t)view.trailEnds[i].x);
+		mix((uint32_t)view.trailEnds[i].y);
+	}
+	return hash;
+
+}
+
+size_t EncodeDelta(const GameState& state, uint32_t round, uint32_t tick, const ClientView* baseline,
+	uint8_t* out, size_t capacity, ClientView& view) {
+
+	if (capacity < UPDATE_HEADER) {
+		return 0;
+	}
+	int players = state.config.players;
+
+	// Against nothing, every field is a change from zero and every corner is new
+	ClientView none;
+	if (baseline == nullptr) {
+		ClearView(none);
+		baseline = &none;
+	}
+	view = *baseline;
+	view.round = round;
+	view.tick = tick;
+	view.over = state.over;
+	view.winner = state.winner;
+
+	ByteWriter writer = { out + UPDATE_HEADER, out + capacity, false };
+	if (baseline == &none) {
+		const SimConfig& config = state.config;
+		writer.varint((uint32_t)config.width);
+		writer.varint((uint32_t)config.height);
+		writer.varint((uint32_t)config.cycleWidth);
+		writer.varint((uint32_t)config.cycleHeight);
+		writer.varint((uint32_t)config.maxSpeed);
+		writer.varint((uint32_t)config.directionChangeDelay);
+		writer.varint(config.seed);
+		writer.varint((uint32_t)players);
+	}
+
+	// Cycles first, they always have to fit
+	uint16_t changed = 0;
+	uint16_t masks[MAX_PLAYERS];
+	for (int i = 0; i < players; i++) {
+		masks[i] = 0;
+		for (int field = 0; field < CYCLE_FIELDS; field++) {
+			if (GetField(state.cycles[i], field) != GetField(baseline->cycles[i], field)) {
+				masks[i] |= (uint16_t)(1 << field);
+			}
+		}
+		if (masks[i] != 0) {
+			changed |= (uint16_t)(1 << i);
+		}
+		view.cycles[i] = state.cycles[i];
+	}
+	writer.u16(changed);
+	for (int i = 0; i < players; i++) {
+		if (masks[i] == 0) {
+			continue;
+		}
+		writer.varint(masks[i]);
+		for (int field = 0; field < CYCLE_FIELDS; field++) {
+			if (masks[i] & (1 << field)) {
+				writer.zigzag(GetField(state.cycles[i], field) - GetField(baseline->cycles[i], field));
+			}
+		}
+	}
+	if (writer.overflow) {
+		return 0;
+	}
+
+	// Then trail corners while there is room, starting with a different
+	// player each tick so none is always last. The view's last corner is
+	// sent again since it may have slid on.
+	for (int n = 0; n < players; n++) {
+		int i = (int)((tick + n) % players);
+		const Trail& trail = state.cycles[i].trail;
+		size_t count = trail.getPointCount();
+		size_t had = baseline->trailPoints[i];
+		TrailPoint last = baseline->trailEnds[i];
+		if (count == had && (count == 0 || (trail.back().x == last.x && trail.back().y == last.y))) {
+			continue;
+		}
+		size_t from = had > 0 ? had - 1 : 0;
+		if (had == 0) {
+			last.x = 0;
+			last.y = 0;
+		}
+
+		// Player, count and at least one corner, leaving room for the end marker
+		uint8_t* run = writer.at;
+		if (writer.end - writer.at < 1 + 2 + 10 + 1) {
+			break;
+		}
+		writer.byte((uint8_t)i);
+		writer.u16(0);
+		uint16_t sent = 0;
+		for (size_t p = from; p < count && sent < 0xffff; p++) {
+			uint8_t* before = writer.at;
+			const TrailPoint& point = trail.getPoint(p);
+			writer.zigzag(point.x - last.x);
+			writer.zigzag(point.y - last.y);
+			if (writer.overflow || writer.end - writer.at < 1) {
+				writer.at = before;
+				writer.overflow = false;
+				break;
+			}
+			last = point;
+			sent++;
+		}
+		if (sent == 0) {
+			writer.at = run;
+			break;
+		}
+		run[1] = (uint8_t)sent;
+		run[2] = (uint8_t)(sent >> 8);
+		view.trailPoints[i] = (uint32_t)(from + sent);
+		view.trailEnds[i] = last;
+	}
+	writer.byte(END_OF_TRAILS);
+	if (writer.overflow) {
+		return 0;
+	}
+
+	writeU32(out, round);
+	writeU32(out + 4, tick);
+	writeU32(out + 8, baseline == &none ? NO_VIEW : baseline->tick);
+	out[12] = state.over ? 1 : 0;
+	out[13] = (uint8_t)(state.winner + 1);
+	writeU32(out + 14, ViewHash(view, players));
+	return (size_t)(writer.at - out);
+
+}
+
+RoomView::RoomView() {
+
+	clear();
+
+}
+
+void RoomView::clear() {
+
+	memset(&config, 0, sizeof(config));
+	for (int i = 0; i < VIEW_HISTORY; i++) {
+		ClearView(history[i]);
+	}
+	latest = NO_VIEW;
+	for (int i = 0; i < MAX_PLAYERS; i++) {
+		trails[i].clear();
+	}
+
+}
+
+ViewUpdate RoomView::apply(const uint8_t* data, size_t size) {
+
+	if (size < UPDATE_HEADER) {
+		return VIEW_MALFORMED;
+	}
+	uint32_t round = readU32(data);
+	uint32_t tick = readU32(data + 4);
+	uint32_t baseTick = readU32(data + 8);
+	uint32_t check = readU32(data + 14);
+	if (tick == NO_VIEW) {
+		return VIEW_MALFORMED;
+	}
+	// Room ticks keep counting across rounds, so anything older is late
+	if (latest != NO_VIEW && tick <= latest) {
+		return VIEW_STALE;
+	}
+
+	ByteReader reader = { data + UPDATE_HEADER, data + size, false };
+	ClientView base;
+	SimConfig newConfig = config;
+	if (baseTick == NO_VIEW) {
+		ClearView(base);
+		newConfig.width = (int)reader.varint();
+		newConfig.height = (int)reader.varint();
+		newConfig.cycleWidth = (int)reader.varint();
+		newConfig.cycleHeight = (int)reader.varint();
+		newConfig.maxSpeed = (int)reader.varint();
+		newConfig.directionChangeDelay = (int)reader.varint();
+		newConfig.seed = reader.varint();
+		newConfig.players = (int)reader.varint();
+		if (newConfig.players < 2 || newConfig.players > MAX_PLAYERS) {
+			return VIEW_MALFORMED;
+		}
+	}
+	else {
+		const ClientView& kept = history[baseTick % VIEW_HISTORY];
+		if (latest == NO_VIEW || kept.tick != baseTick || kept.round != round) {
+			return VIEW_NO_BASE;
+		}
+		base = kept;
+	}
+	int players = newConfig.players;
+
+	ClientView view = base;
+	view.round = round;
+	view.tick = tick;
+	view.over = data[12] != 0;
+	view.winner = (int)data[13] - 1;
+	uint16_t changed = reader.u16();
+	for (int i = 0; i < MAX_PLAYERS; i++) {
+		if ((changed & (1 << i)) == 0) {
+			continue;
+		}
+		if (i >= players) {
+			return VIEW_MALFORMED;
+		}
+		uint32_t mask = reader.varint();
+		for (int field = 0; field < CYCLE_FIELDS; field++) {
+			if (mask & (1 << field)) {
+				SetField(view.cycles[i], field, GetField(base.cycles[i], field) + reader.zigzag());
+			}
+		}
+	}
+	if (reader.overflow) {
+		return VIEW_MALFORMED;
+	}
+
+	// Nothing has been touched yet, so a bad update leaves the view as it was
+	// up to here. The trails are rebuilt from the base view's corners, which
+	// a later view applied already has since it came from the same round.
+	bool fresh = baseTick == NO_VIEW;
+	if (fresh) {
+		config = newConfig;
+	}
+	for (int i = 0; i < MAX_PLAYERS; i++) {
+		trails[i].resize(base.trailPoints[i]);
+		if (base.trailPoints[i] > 0) {
+			trails[i].back() = base.trailEnds[i];
+		}
+	}
+	while (true) {
+		uint8_t player = reader.byte();
+		if (reader.overflow || player == END_OF_TRAILS) {
+			break;
+		}
+		uint16_t count = reader.u16();
+		if (player >= players) {
+			reader.overflow = true;
+			break;
+		}
+		vector<TrailPoint>& trail = trails[player];
+		TrailPoint last = { 0, 0 };
+		if (!trail.empty()) {
+			last = trail.back();
+			trail.pop_back();
+		}
+		for (uint16_t p = 0; p < count && !reader.overflow; p++) {
+			last.x += reader.zigzag();
+			last.y += reader.zigzag();
+			trail.push_back(last);
+		}
+		view.trailPoints[player] = (uint32_t)trail.size();
+		view.trailEnds[player] = last;
+	}
+
+	if (reader.overflow || ViewHash(view, players) != check) {
+		clear();
+		return reader.overflow ? VIEW_MALFORMED : VIEW_MISMATCH;
+	}
+	history[tick % VIEW_HISTORY] = view;
+	latest = tick;
+	return VIEW_APPLIED;
+
+}
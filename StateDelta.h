@@ -0,0 +1,77 @@
+#ifndef STATE_DELTA_H
+#define STATE_DELTA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Simulation.h"
+
+// Delta-compressed room state for clients of a server. Each update is
+// encoded against a view the client has acknowledged: the cycle fields
+// that changed, as differences, and the trail corners added since. Both
+// ends keep the views of recent updates, so a lost update only makes the
+// next one a little longer. With nothing acknowledged, or after the round
+// changed, the update is encoded against nothing and carries everything.
+
+const uint32_t NO_VIEW = 0xffffffffu;	// Tick of a view that isn't there
+const int VIEW_HISTORY = 16;			// Views kept by each end, at tick % VIEW_HISTORY
+
+// What one client has been sent of a round. Plain data, copied once per
+// update on the server.
+struct ClientView {
+	uint32_t round;
+	uint32_t tick;						// Room tick the view is of, NO_VIEW for none
+	bool over;
+	int winner;
+	CycleCore cycles[MAX_PLAYERS];
+	uint32_t trailPoints[MAX_PLAYERS];	// Trail corners the client has
+	TrailPoint trailEnds[MAX_PLAYERS];	// Its copy of the last one, which may since have slid on
+};
+
+void ClearView(ClientView& view);
+
+// Hash of the first players cycles of a view, sent with each update so the
+// client can tell it rebuilt exactly what the server meant
+uint32_t ViewHash(const ClientView& view, int players);
+
+// Encode state as the update for room tick tick of round round, against
+// baseline or in full if that is null, into at most capacity bytes. Trail
+// corners that don't fit follow in later updates. view gets what the
+// client will have once it applies the update. Returns the encoded size,
+// 0 if not even the cycles fit.
+size_t EncodeDelta(const GameState& state, uint32_t round, uint32_t tick, const ClientView* baseline,
+	uint8_t* out, size_t capacity, ClientView& view);
+
+enum ViewUpdate {
+	VIEW_APPLIED,
+	VIEW_STALE,			// No newer than the latest applied, it arrived late
+	VIEW_NO_BASE,		// Encoded against a view no longer kept
+	VIEW_MALFORMED,
+	VIEW_MISMATCH		// Rebuilt state failed the hash, the view starts over
+};
+
+// A client's copy of a room's round, rebuilt from updates
+class RoomView {
+protected:
+	SimConfig config;
+	ClientView history[VIEW_HISTORY];
+	uint32_t latest;					// Tick of the newest view applied, NO_VIEW for none
+	std::vector<TrailPoint> trails[MAX_PLAYERS];
+
+public:
+	RoomView();
+
+	void clear();
+	ViewUpdate apply(const uint8_t* data, size_t size);
+
+	// What to acknowledge, NO_VIEW before the first update
+	uint32_t getLatestTick() const { return latest; };
+	bool hasView() const { return latest != NO_VIEW; };
+	// Only meaningful once hasView()
+	const ClientView& getView() const { return history[latest % VIEW_HISTORY]; };
+	const SimConfig& getConfig() const { return config; };
+	const std::vector<TrailPoint>& getTrail(int player) const { return trails[player]; };
+
+};
+
+#endif
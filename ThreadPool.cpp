@@ -0,0 +1,128 @@
+#include "ThreadPool.h"
+
+using namespace std;
+
+// Lets submit() from inside a task push onto the calling worker's own deque
+static thread_local ThreadPool* currentPool = nullptr;
+static thread_local int currentWorker = -1;
+
+ThreadPool::ThreadPool(int threadCount) {
+
+	if (threadCount <= 0) {
+		threadCount = (int)thread::hardware_concurrency();
+	}
+	if (threadCount <= 0) {
+		threadCount = 1;
+	}
+
+	queued = 0;
+	pending = 0;
+	nextQueue = 0;
+	steals = 0;
+	stopping = false;
+
+	for (int i = 0; i < threadCount; i++) {
+		queues.push_back(unique_ptr<WorkerQueue>(new WorkerQueue));
+	}
+	for (int i = 0; i < threadCount; i++) {
+		threads.push_back(thread(&ThreadPool::workerLoop, this, i));
+	}
+
+}
+
+ThreadPool::~ThreadPool() {
+
+	{
+		lock_guard<mutex> guard(idleLock);
+		stopping = true;
+	}
+	idle.notify_all();
+
+	for (auto threadIter = threads.begin(); threadIter != threads.end(); threadIter++) {
+		threadIter->join();
+	}
+
+}
+
+void ThreadPool::submit(function<void()> task) {
+
+	int worker = currentPool == this ? currentWorker :
+		(int)(nextQueue++ % queues.size());
+
+	pending++;
+	{
+		lock_guard<mutex> guard(queues[worker]->lock);
+		queues[worker]->tasks.push_back(move(task));
+	}
+	queued++;
+
+	{
+		lock_guard<mutex> guard(idleLock);
+	}
+	idle.notify_one();
+
+}
+
+void ThreadPool::wait() {
+
+	unique_lock<mutex> lock(idleLock);
+	done.wait(lock, [this] { return pending == 0; });
+
+}
+
+bool ThreadPool::takeTask(int worker, function<void()>& task) {
+
+	// Own deque first, newest task first
+	{
+		WorkerQueue& own = *queues[worker];
+		lock_guard<mutex> guard(own.lock);
+		if (!own.tasks.empty()) {
+			task = move(own.tasks.back());
+			own.tasks.pop_back();
+			queued--;
+			return true;
+		}
+	}
+
+	// Then steal the oldest task from the others
+	int count = (int)queues.size();
+	for (int i = 1; i < count; i++) {
+		WorkerQueue& victim = *queues[(worker + i) % count];
+		lock_guard<mutex> guard(victim.lock);
+		if (!victim.tasks.empty()) {
+			task = move(victim.tasks.front());
+			victim.tasks.pop_front();
+			queued--;
+			steals++;
+			return true;
+		}
+	}
+
+	return false;
+
+}
+
+void ThreadPool::workerLoop(int worker) {
+
+	currentPool = this;
+	currentWorker = worker;
+
+	while (true) {
+		function<void()> task;
+		if (takeTask(worker, task)) {
+			task();
+			if (--pending == 0) {
+				lock_guard<mutex> guard(idleLock);
+				done.notify_all();
+			}
+			continue;
+		}
+
+		unique_lock<mutex> lock(idleLock);
+		idle.wait(lock, [this] { return stopping || queued > 0; });
+		if (stopping && queued <= 0) {
+			return;
+		}
+	}
+
+}
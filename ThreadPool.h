@@ -0,0 +1,49 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads, each with its own task deque. A worker runs
+// its own tasks newest first and steals the oldest task from another worker
+// when it runs dry, so uneven tasks still keep every core busy.
+class ThreadPool {
+protected:
+	struct WorkerQueue {
+		std::mutex lock;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	std::vector<std::unique_ptr<WorkerQueue>> queues;
+	std::vector<std::thread> threads;
+	std::mutex idleLock;
+	std::condition_variable idle;
+	std::condition_variable done;
+	std::atomic<int> queued;
+	std::atomic<int> pending;
+	std::atomic<unsigned int> nextQueue;
+	std::atomic<unsigned long long> steals;
+	bool stopping;
+
+	bool takeTask(int worker, std::function<void()>& task);
+	void workerLoop(int worker);
+
+public:
+	ThreadPool(int threadCount = 0);
+	virtual ~ThreadPool();
+
+	void submit(std::function<void()> task);
+	void wait();
+
+	int getThreadCount() { return (int)threads.size(); };
+	unsigned long long getSteals() { return steals; };
+
+};
+
+#endif
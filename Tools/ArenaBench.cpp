@@ -0,0 +1,94 @@
+// Benchmark: occupancy memory as the arena grows.
+//
+//   ArenaBench [players] [ticks] [seed]
+//
+// Plays one round with the random policy in arenas from 500 x 400 up to
+// 20,000 x 20,000, stopping after ticks ticks if it is still going, and
+// prints the tiles the trails touched, the bytes the occupancy grid holds
+// against what one bit per pixel would take, and the process resident set
+// size. Arenas go smallest first, so the resident size only ever grows;
+// it should stay close to flat while the dense size climbs into the tens
+// of megabytes.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. Tools/ArenaBench.cpp BatchRunner.cpp Simulation.cpp OccupancyGrid.cpp
+//       Trail.cpp Arena.cpp ThreadPool.cpp -pthread -o ArenaBench
+
+#include "BatchRunner.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Resident set size of this process in kilobytes, 0 if it can't be had
+static size_t ResidentKilobytes() {
+
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return counters.WorkingSetSize / 1024;
+	}
+	return 0;
+#else
+	FILE* file = fopen("/proc/self/statm", "r");
+	if (file == NULL) {
+		return 0;
+	}
+	unsigned long size = 0, resident = 0;
+	int read = fscanf(file, "%lu %lu", &size, &resident);
+	fclose(file);
+	return read == 2 ? resident * (size_t)sysconf(_SC_PAGESIZE) / 1024 : 0;
+#endif
+
+}
+
+int main(int argc, char* argv[]) {
+
+	int players = argc > 1 ? atoi(argv[1]) : 16;
+	unsigned int maxTicks = argc > 2 ? (unsigned int)strtoul(argv[2], NULL, 10) : 20000;
+	unsigned int seed = argc > 3 ? (unsigned int)strtoul(argv[3], NULL, 10) : 1;
+	const int sizes[][2] = { { 500, 400 }, { 2000, 2000 }, { 5000, 5000 }, { 10000, 10000 }, { 20000, 20000 } };
+
+	printf("start: %zu KB resident\n", ResidentKilobytes());
+	printf("%12s %8s %10s %8s %12s %12s %12s %10s\n", "arena", "ticks", "trail px", "tiles",
+		"grid KB", "dense KB", "resident KB", "us/tick");
+	for (const int* size : sizes) {
+		GameState state;
+		Arena arena;
+		SimConfig config = DefaultSimConfig(size[0], size[1], players);
+		config.seed = seed;
+		SimStart(state, config, &arena);
+		mt19937 rng(seed);
+		PLAYERINPUT inputs[MAX_PLAYERS];
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		while (!state.over && state.tick < maxTicks) {
+			for (int i = 0; i < state.config.players; i++) {
+				inputs[i] = RandomPolicy(state, i, rng);
+			}
+			SimStep(state, inputs);
+		}
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		unsigned long long trail = 0;
+		for (int i = 0; i < state.config.players; i++) {
+			trail += state.cycles[i].trail.getLength();
+		}
+		char name[32];
+		snprintf(name, sizeof(name), "%dx%d", size[0], size[1]);
+		printf("%12s %8u %10llu %8zu %12zu %12llu %12zu %10.2f\n", name, state.tick, trail,
+			state.arena.getTileCount(), state.arena.getBytesReserved() / 1024,
+			(unsigned long long)(size[0] + 63) / 64 * 8 * size[1] / 1024, ResidentKilobytes(),
+			state.tick > 0 ? seconds * 1e6 / state.tick : 0.0);
+	}
+	return 0;
+
+}
@@ -0,0 +1,82 @@
+// Benchmark: headless self-play throughput as threads are added.
+//
+//   BatchBench [matches] [seed] [players] [max threads]
+//
+// Runs the same batch of random-policy matches with RunBatch() on 1, 2,
+// 4, ... threads up to the core count or max threads (which is always
+// included), and prints matches a second and matches a second per thread
+// for each, with the speedup and efficiency against one thread. Match i
+// gets the same seed whichever thread plays it, so every run must come out
+// with the same wins, draws, unfinished rounds and ticks; the bench fails
+// if any differ. Scaling stops at the physical cores, and falls short of
+// linear where hyperthreads or other work share them.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. Tools/BatchBench.cpp BatchRunner.cpp Simulation.cpp OccupancyGrid.cpp Trail.cpp
+//       Arena.cpp ThreadPool.cpp -pthread -o BatchBench
+
+#include "BatchRunner.h"
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static bool SameResults(const BatchStats& a, const BatchStats& b) {
+
+	if (a.matches != b.matches || a.draws != b.draws || a.unfinished != b.unfinished || a.ticks != b.ticks ||
+		a.shortest != b.shortest || a.longest != b.longest) {
+		return false;
+	}
+	for (int i = 0; i < MAX_PLAYERS; i++) {
+		if (a.wins[i] != b.wins[i]) {
+			return false;
+		}
+	}
+	return true;
+
+}
+
+int main(int argc, char* argv[]) {
+
+	int matches = argc > 1 ? atoi(argv[1]) : 2000;
+	unsigned int seed = argc > 2 ? (unsigned int)strtoul(argv[2], NULL, 10) : 1;
+	int players = argc > 3 ? atoi(argv[3]) : 2;
+	matches = matches < 1 ? 1 : matches;
+	players = players < 2 ? 2 : (players > MAX_PLAYERS ? MAX_PLAYERS : players);
+
+	int cores = (int)thread::hardware_concurrency();
+	cores = cores < 1 ? 1 : cores;
+	int maxThreads = argc > 4 ? atoi(argv[4]) : cores;
+	maxThreads = maxThreads < 1 ? 1 : maxThreads;
+	vector<int> threadCounts;
+	for (int threads = 1; threads < maxThreads; threads *= 2) {
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads);
+
+	BatchConfig config = DefaultBatchConfig(matches, seed);
+	config.sim = DefaultSimConfig(500, 400, players);
+	vector<Policy> policies(players, Policy(RandomPolicy));
+
+	printf("%d matches of %d players, %d cores\n", matches, players, cores);
+	printf("%8s %10s %12s %14s %9s %11s %12s\n", "threads", "seconds", "matches/s", "matches/s/core", "speedup",
+		"efficiency", "avg ticks");
+	config.threads = 1;
+	BatchStats first = RunBatch(config, policies.data());
+	for (size_t i = 0; i < threadCounts.size(); i++) {
+		config.threads = threadCounts[i];
+		BatchStats stats = i == 0 ? first : RunBatch(config, policies.data());
+		if (!SameResults(first, stats)) {
+			printf("Results on %d threads differ from one thread\n", stats.threads);
+			return 1;
+		}
+		double speedup = first.seconds > 0 && stats.seconds > 0 ? first.seconds / stats.seconds : 0.0;
+		printf("%8d %10.3f %12.1f %14.1f %8.2fx %10.0f%% %12.1f\n", stats.threads, stats.seconds,
+			stats.matchesPerSecond(), stats.matchesPerSecondPerCore(), speedup, 100.0 * speedup / stats.threads,
+			stats.averageLength());
+	}
+	return 0;
+
+}
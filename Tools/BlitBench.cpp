@@ -0,0 +1,208 @@
+// Benchmark: keyed blits on each path, and whole SoftwareRenderer frames.
+//
+//   BlitBench [blits] [frames] [seed]
+//
+// Run from the repository root, it reads Res/Cycles.bmp, Res/Cycles.atlas
+// and Res/Background.bmp. For the scalar, SSE2 and AVX2 keyed row copies,
+// whichever the CPU has, switched with Framebuffer::SetBlitPath(), draws
+// the given number of cycle frames (28 pixels a row) and as many copies of
+// the whole sheet (233 pixels a row, mostly color key between frames) at
+// random places on a 1920 x 1080 frame, half of them hanging off an edge,
+// and prints nanoseconds a blit and millions of pixels a second. The
+// scalar loop may still be vectorized by the compiler. Then renders the
+// given number of frames of a 500 x 400 round and of a 2000 x 2000 round
+// seen through a 500 x 400 camera, and prints microseconds a frame. Every path has to
+// leave the same pixels as the scalar one, or the benchmark stops.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. Tools/BlitBench.cpp SoftwareRenderer.cpp Framebuffer.cpp SpriteAtlas.cpp
+//       BmpImage.cpp MappedFile.cpp Camera.cpp BatchRunner.cpp Simulation.cpp OccupancyGrid.cpp
+//       Trail.cpp Arena.cpp ThreadPool.cpp -pthread -o BlitBench
+
+#include "BatchRunner.h"
+#include "BmpImage.h"
+#include "SoftwareRenderer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+static const int FRAME_WIDTH = 1920;
+static const int FRAME_HEIGHT = 1080;
+static const int VIEW_WIDTH = 500;
+static const int VIEW_HEIGHT = 400;
+
+struct Placement {
+	int x, y;
+};
+
+// Half inside the frame, half hanging off an edge so clipping is timed too
+static vector<Placement> Places(int count, int width, int height, unsigned int seed) {
+
+	mt19937 random(seed);
+	uniform_int_distribution<int> insideX(0, FRAME_WIDTH - width), insideY(0, FRAME_HEIGHT - height);
+	uniform_int_distribution<int> anyX(-width + 1, FRAME_WIDTH - 1), anyY(-height + 1, FRAME_HEIGHT - 1);
+	vector<Placement> places(count);
+	for (int i = 0; i < count; i++) {
+		places[i].x = i % 2 == 0 ? insideX(random) : anyX(random);
+		places[i].y = i % 2 == 0 ? insideY(random) : anyY(random);
+	}
+	return places;
+
+}
+
+// Nanoseconds a blit, with the frame left holding what they drew
+static double TimeBlits(Framebuffer& frame, const uint32_t* src, int width, int height, int pitch,
+	const vector<Placement>& places) {
+
+	frame.fill(0);
+	frame.resetPixelsWritten();
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (size_t i = 0; i < places.size(); i++) {
+		frame.blitKeyed(src, width, height, pitch, places[i].x, places[i].y, PIXEL_MAGENTA);
+	}
+	return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / places.size();
+
+}
+
+// A round played this many ticks by the random policy
+static void PlayRound(GameState& state, int width, int height, unsigned int seed, unsigned int ticks) {
+
+	SimConfig config = DefaultSimConfig(width, height);
+	config.seed = seed;
+	SimStart(state, config);
+	mt19937 random(seed);
+	PLAYERINPUT inputs[MAX_PLAYERS];
+	while (!state.over && state.tick < ticks) {
+		for (int i = 0; i < config.players; i++) {
+			inputs[i] = RandomPolicy(state, i, random);
+		}
+		SimStep(state, inputs);
+	}
+
+}
+
+// Microseconds a frame, after one to draw the trail layer
+static double TimeFrames(SoftwareRenderer& renderer, const GameState& state, const RenderImages& images,
+	const Camera* camera, int frames) {
+
+	renderer.reset();
+	if (camera != nullptr) {
+		renderer.render(state, images, *camera);
+	}
+	else {
+		renderer.render(state, images);
+	}
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (int i = 0; i < frames; i++) {
+		if (camera != nullptr) {
+			renderer.render(state, images, *camera);
+		}
+		else {
+			renderer.render(state, images);
+		}
+	}
+	return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / frames;
+
+}
+
+static bool SamePixels(const Framebuffer& a, const Framebuffer& b) {
+
+	return a.getWidth() == b.getWidth() && a.getHeight() == b.getHeight() &&
+		equal(a.getPixels(), a.getPixels() + (size_t)a.getPitch() * a.getHeight(), b.getPixels());
+
+}
+
+int main(int argc, char* argv[]) {
+
+	int blits = argc > 1 ? atoi(argv[1]) : 100000;
+	int frames = argc > 2 ? atoi(argv[2]) : 500;
+	unsigned int seed = argc > 3 ? (unsigned int)strtoul(argv[3], NULL, 10) : 1;
+	blits = blits < 1 ? 1 : blits;
+	frames = frames < 1 ? 1 : frames;
+
+	SpriteAtlas atlas;
+	BmpFile backgroundFile;
+	PixelImage background;
+	if (!atlas.load("Res/Cycles.bmp", "Res/Cycles.atlas") || atlas.find("CycleBlue_0") < 0 ||
+		!backgroundFile.open("Res/Background.bmp")) {
+		fprintf(stderr, "Run from the repository root, Res/Cycles.bmp, Res/Cycles.atlas and Res/Background.bmp are needed\n");
+		return 1;
+	}
+	backgroundFile.getView().toPixelImage(background);
+	const PixelImage& sheet = atlas.getSheet();
+	const SpriteRect& cycle = atlas.getFrame(atlas.find("CycleBlue_0"));
+
+	RenderImages images;
+	images.background = &background;
+	images.sprites = &sheet;
+	const char* const names[2][4] = {
+		{ "CycleBlue_0", "CycleBlue_90", "CycleBlue_180", "CycleBlue_270" },
+		{ "CycleOrange_0", "CycleOrange_90", "CycleOrange_180", "CycleOrange_270" }
+	};
+	for (int i = 0; i < 2; i++) {
+		for (int d = 0; d < 4; d++) {
+			int index = atlas.find(names[i][d]);
+			if (index >= 0) {
+				images.cycles[i][d] = atlas.getFrame(index);
+			}
+		}
+	}
+
+	GameState window, arena;
+	PlayRound(window, VIEW_WIDTH, VIEW_HEIGHT, seed, 300);
+	PlayRound(arena, 2000, 2000, seed, 1500);
+	Camera camera(VIEW_WIDTH, VIEW_HEIGHT);
+	camera.setArena(2000, 2000);
+	camera.follow(arena.cycles[PLAYER_BLUE].headX(arena.config), arena.cycles[PLAYER_BLUE].headY(arena.config));
+
+	vector<Placement> cyclePlaces = Places(blits, cycle.width, cycle.height, seed);
+	vector<Placement> sheetPlaces = Places(blits, sheet.width, sheet.height, seed + 1);
+	const uint32_t* cyclePixels = atlas.getPixels(atlas.find("CycleBlue_0"));
+
+	printf("%d blits, %d frames, %s picked at start-up\n", blits, frames, Framebuffer::GetBlitPath());
+	printf("%8s %12s %12s %12s %12s %12s %12s\n", "path", "cycle ns", "cycle Mpx/s", "sheet ns", "sheet Mpx/s",
+		"frame us", "camera us");
+	Framebuffer scalarCycles(FRAME_WIDTH, FRAME_HEIGHT), scalarSheets(FRAME_WIDTH, FRAME_HEIGHT);
+	Framebuffer scalarFrame, scalarCamera;
+	const char* const paths[] = { "scalar", "sse2", "avx2" };
+	for (const char* path : paths) {
+		if (!Framebuffer::SetBlitPath(path)) {
+			printf("%8s %12s\n", path, "not on this CPU");
+			continue;
+		}
+
+		Framebuffer cycles(FRAME_WIDTH, FRAME_HEIGHT), sheets(FRAME_WIDTH, FRAME_HEIGHT);
+		double cycleTime = TimeBlits(cycles, cyclePixels, cycle.width, cycle.height, sheet.width, cyclePlaces);
+		double cycleMegapixels = cycles.getPixelsWritten() / (cycleTime * blits / 1000.0);
+		double sheetTime = TimeBlits(sheets, sheet.pixels.data(), sheet.width, sheet.height, sheet.width, sheetPlaces);
+		double sheetMegapixels = sheets.getPixelsWritten() / (sheetTime * blits / 1000.0);
+
+		SoftwareRenderer renderer(VIEW_WIDTH, VIEW_HEIGHT);
+		double frameTime = TimeFrames(renderer, window, images, nullptr, frames);
+		Framebuffer rendered;
+		rendered.copyFrom(renderer.getFrame());
+		double cameraTime = TimeFrames(renderer, arena, images, &camera, frames);
+
+		if (path == paths[0]) {
+			scalarCycles.copyFrom(cycles);
+			scalarSheets.copyFrom(sheets);
+			scalarFrame.copyFrom(rendered);
+			scalarCamera.copyFrom(renderer.getFrame());
+		}
+		else if (!SamePixels(cycles, scalarCycles) || !SamePixels(sheets, scalarSheets) ||
+			!SamePixels(rendered, scalarFrame) || !SamePixels(renderer.getFrame(), scalarCamera)) {
+			printf("%s and scalar blits leave different pixels\n", path);
+			return 1;
+		}
+		printf("%8s %12.1f %12.0f %12.1f %12.0f %12.1f %12.1f\n", path, cycleTime, cycleMegapixels,
+			sheetTime, sheetMegapixels, frameTime, cameraTime);
+		fflush(stdout);
+	}
+	return 0;
+
+}
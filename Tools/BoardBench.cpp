@@ -0,0 +1,147 @@
+// Benchmark: ArenaBoard copies and move generation against GameState.
+//
+//   BoardBench [seed]
+//
+// Plays a two-player round in the 500 x 400 arena with the random policy
+// and stops it at ticks from 50 to 800, then times what a search does
+// at every node both ways: copy the position, and list each cycle's moves
+// that don't crash straight away. The GameState path is a full assignment,
+// trails and occupancy tiles included, and IsDeadly() on the three
+// headings the way a policy tests its moves; the board path is
+// ArenaBoard::copyFrom() and LegalMoves(). Copies must come out equal.
+// A round that ends before the next checkpoint is played again with the
+// next seed. Besides the times it prints the moves found a cycle each way
+// and how many copy-and-generate nodes a second each path manages.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. Tools/BoardBench.cpp BitBoard.cpp BatchRunner.cpp Simulation.cpp OccupancyGrid.cpp
+//       Trail.cpp Arena.cpp ThreadPool.cpp -pthread -o BoardBench
+
+#include "BatchRunner.h"
+#include "BitBoard.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+static const int COPIES = 20000;
+static const int GENERATIONS = 2000000;
+static const unsigned int MAX_ROUNDS = 1000;
+
+// Moves without crashing next tick, as a policy finds them on a GameState
+static int StateMoves(const GameState& state, int who, DIRECTION moves[3]) {
+
+	const CycleState& cycle = state.cycles[who];
+	moves[0] = cycle.direction;
+	if (!cycle.alive || cycle.changingDirection) {
+		return 1;
+	}
+
+	int x = cycle.headX(state.config);
+	int y = cycle.headY(state.config);
+	int count = 0;
+	for (int turn = 0; turn < 4; turn++) {
+		if (turn == 2) {
+			continue;
+		}
+		DIRECTION direction = (DIRECTION)((cycle.direction + turn) & 3);
+		int dx, dy;
+		DirectionDelta(direction, dx, dy);
+		if (!IsDeadly(state, x + dx, y + dy)) {
+			moves[count++] = direction;
+		}
+	}
+	return count > 0 ? count : 1;
+
+}
+
+static double MicrosSince(chrono::steady_clock::time_point start) {
+
+	return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+
+}
+
+int main(int argc, char* argv[]) {
+
+	unsigned int seed = argc > 1 ? (unsigned int)strtoul(argv[1], NULL, 10) : 1;
+	const unsigned int checkpoints[] = { 50, 100, 200, 400, 800 };
+
+	GameState state;
+	SimConfig config = DefaultSimConfig();
+	config.seed = seed;
+	SimStart(state, config);
+	mt19937 rng(seed);
+	unsigned int rounds = 1;
+
+	printf("%6s %6s %14s %14s %14s %14s %6s %6s %12s %12s\n", "tick", "tiles", "state copy us", "board copy us",
+		"state gen ns", "board gen ns", "st mv", "bd mv", "state /s", "board /s");
+	for (unsigned int checkpoint : checkpoints) {
+		// Rounds that end too soon are played again with the next seed
+		PLAYERINPUT inputs[MAX_PLAYERS];
+		while (state.tick < checkpoint && rounds <= MAX_ROUNDS) {
+			if (state.over) {
+				config.seed = MatchSeed(seed, rounds++);
+				SimStart(state, config);
+				rng.seed(config.seed);
+			}
+			for (int i = 0; i < config.players && !state.over; i++) {
+				inputs[i] = RandomPolicy(state, i, rng);
+			}
+			if (!state.over) {
+				SimStep(state, inputs);
+			}
+		}
+		if (state.tick < checkpoint) {
+			break;
+		}
+
+		ArenaBoard board;
+		BoardFromState(board, state);
+
+		// One copy first so the timed ones reuse the storage, as a search would
+		GameState stateCopy = state;
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (int i = 0; i < COPIES; i++) {
+			stateCopy = state;
+		}
+		double stateCopyTime = MicrosSince(start) / COPIES;
+
+		ArenaBoard boardCopy;
+		boardCopy.copyFrom(board);
+		start = chrono::steady_clock::now();
+		for (int i = 0; i < COPIES; i++) {
+			boardCopy.copyFrom(board);
+		}
+		double boardCopyTime = MicrosSince(start) / COPIES;
+
+		if (StateHash(stateCopy) != StateHash(state) || !boardCopy.blocked.equals(board.blocked)) {
+			printf("Copies differ at tick %u\n", state.tick);
+			return 1;
+		}
+
+		// Both cycles a generation, the counts summed so none can be skipped
+		DIRECTION moves[3];
+		long long stateMoves = 0, boardMoves = 0;
+		start = chrono::steady_clock::now();
+		for (int i = 0; i < GENERATIONS; i++) {
+			stateMoves += StateMoves(stateCopy, i & 1, moves);
+		}
+		double stateGenTime = MicrosSince(start) * 1000.0 / GENERATIONS;
+		start = chrono::steady_clock::now();
+		for (int i = 0; i < GENERATIONS; i++) {
+			boardMoves += LegalMoves(boardCopy, i & 1, moves);
+		}
+		double boardGenTime = MicrosSince(start) * 1000.0 / GENERATIONS;
+
+		// A node: one copy and moves for both cycles
+		double stateNode = stateCopyTime + 2 * stateGenTime / 1000.0;
+		double boardNode = boardCopyTime + 2 * boardGenTime / 1000.0;
+		printf("%6u %6zu %14.2f %14.2f %14.1f %14.1f %6.2f %6.2f %12.0f %12.0f\n", state.tick,
+			state.arena.getTileCount(), stateCopyTime, boardCopyTime, stateGenTime, boardGenTime,
+			(double)stateMoves / GENERATIONS, (double)boardMoves / GENERATIONS, 1000000.0 / stateNode,
+			1000000.0 / boardNode);
+	}
+	return 0;
+
+}
@@ -0,0 +1,105 @@
+// Benchmark: spatial hash broad phase against testing every pair.
+//
+//   CollisionBench [seed]
+//
+// Sweeps sprite counts from 10 to 50,000. Sprites are 28 x 28 like the
+// cycles, scattered over a square world grown with the count so the number
+// of sprites per screen stays the same. Both methods must find the same
+// pairs; the all-pairs test is skipped once it would take too long.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. Tools/CollisionBench.cpp SpatialHash.cpp -o CollisionBench
+
+#include "SpatialHash.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+using namespace std;
+
+static const int SPRITE_SIZE = 28;
+static const int ALL_PAIRS_LIMIT = 20000;
+
+static void AllPairs(const vector<int32_t>& left, const vector<int32_t>& top,
+	const vector<int32_t>& right, const vector<int32_t>& bottom, vector<CollisionPair>& pairs) {
+
+	pairs.clear();
+	int count = (int)left.size();
+	for (int i = 0; i < count; i++) {
+		for (int j = i + 1; j < count; j++) {
+			if (left[i] <= right[j] && right[i] >= left[j] &&
+				top[i] <= bottom[j] && bottom[i] >= top[j]) {
+				CollisionPair pair = { i, j };
+				pairs.push_back(pair);
+			}
+		}
+	}
+
+}
+
+static bool SamePairs(const vector<CollisionPair>& a, const vector<CollisionPair>& b) {
+
+	if (a.size() != b.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < a.size(); i++) {
+		if (a[i].first != b[i].first || a[i].second != b[i].second) {
+			return false;
+		}
+	}
+	return true;
+
+}
+
+int main(int argc, char* argv[]) {
+
+	unsigned int seed = argc > 1 ? (unsigned int)strtoul(argv[1], NULL, 10) : 1;
+	const int counts[] = { 10, 100, 500, 1000, 5000, 10000, 20000, 50000 };
+
+	printf("%8s %8s %12s %14s %14s\n", "sprites", "pairs", "tests", "hash us", "all pairs us");
+	for (int count : counts) {
+		mt19937 random(seed);
+		// About as crowded as 64 sprites on a 640 x 480 screen
+		int world = (int)sqrt((double)count * 640 * 480 / 64);
+		uniform_int_distribution<int> place(-world / 2, world / 2);
+
+		vector<int32_t> left(count), top(count), right(count), bottom(count);
+		for (int i = 0; i < count; i++) {
+			left[i] = place(random);
+			top[i] = place(random);
+			right[i] = left[i] + SPRITE_SIZE;
+			bottom[i] = top[i] + SPRITE_SIZE;
+		}
+
+		SpatialHash hash;
+		int rounds = count <= 1000 ? 200 : 20;
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (int r = 0; r < rounds; r++) {
+			hash.findPairs(left.data(), top.data(), right.data(), bottom.data(), count);
+		}
+		double hashTime = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / rounds;
+
+		char allPairsTime[32] = "-";
+		if (count <= ALL_PAIRS_LIMIT) {
+			vector<CollisionPair> expected;
+			int allRounds = count <= 1000 ? 20 : 1;
+			start = chrono::steady_clock::now();
+			for (int r = 0; r < allRounds; r++) {
+				AllPairs(left, top, right, bottom, expected);
+			}
+			snprintf(allPairsTime, sizeof(allPairsTime), "%.1f",
+				chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / allRounds);
+			if (!SamePairs(expected, hash.getPairs())) {
+				printf("Pairs differ at %d sprites\n", count);
+				return 1;
+			}
+		}
+
+		printf("%8d %8zu %12llu %14.1f %14s\n", count, hash.getPairs().size(), hash.getTests(),
+			hashTime, allPairsTime);
+	}
+	return 0;
+
+}
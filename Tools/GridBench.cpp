@@ -0,0 +1,136 @@
+// Benchmark: occupancy grid lookups against scanning the trail points.
+//
+//   GridBench [seed]
+//
+// Lays trails from 100 to 100,000 points in a 2048 x 2048 arena, a random
+// walk two pixels a tick with a turn now and then, the way a cycle's centre
+// was recorded before the grid. Then tests the same head positions, half on
+// the trail and half anywhere, both ways: the old loop over every segment's
+// bounding box, and one OccupancyGrid bit. Both must agree on every
+// position. Times are per position tested, and a tick tests one per cycle.
+// The scan only gets through a few positions once trails are long; the grid
+// tests all of them, so its hits stay near half.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. Tools/GridBench.cpp OccupancyGrid.cpp -o GridBench
+
+#include "OccupancyGrid.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+static const int ARENA_SIZE = 2048;
+static const int MARGIN = 8;
+static const int STEP = 2;
+static const int POSITIONS = 4096;	// A power of two
+
+typedef vector<pair<int, int>> TrailPoints;
+
+static void LayTrail(mt19937& random, int count, TrailPoints& trail) {
+
+	static const int dx[4] = { 0, 1, 0, -1 };
+	static const int dy[4] = { -1, 0, 1, 0 };
+	trail.clear();
+	int x = ARENA_SIZE / 2, y = ARENA_SIZE / 2;
+	int direction = random() % 4;
+	for (int i = 0; i < count; i++) {
+		trail.push_back(make_pair(x, y));
+		// Turn now and then, and always rather than leave the arena
+		for (int turns = 0; turns < 4; turns++) {
+			int nx = x + dx[direction] * STEP, ny = y + dy[direction] * STEP;
+			bool inside = nx >= MARGIN && ny >= MARGIN && nx < ARENA_SIZE - MARGIN && ny < ARENA_SIZE - MARGIN;
+			if (inside && (turns > 0 || random() % 20 != 0)) {
+				break;
+			}
+			direction = (direction + (random() % 2 == 0 ? 1 : 3)) % 4;
+		}
+		x += dx[direction] * STEP;
+		y += dy[direction] * STEP;
+	}
+
+}
+
+// The collision test before the grid: every segment's bounding box
+static bool ScanHits(const TrailPoints& trail, int x, int y) {
+
+	for (size_t i = 1; i < trail.size(); ++i) {
+		int x1 = trail[i - 1].first, y1 = trail[i - 1].second;
+		int x2 = trail[i].first, y2 = trail[i].second;
+		if (x >= min(x1, x2) && x <= max(x1, x2) && y >= min(y1, y2) && y <= max(y1, y2)) {
+			return true;
+		}
+	}
+	return false;
+
+}
+
+int main(int argc, char* argv[]) {
+
+	unsigned int seed = argc > 1 ? (unsigned int)strtoul(argv[1], NULL, 10) : 1;
+	const int counts[] = { 100, 300, 1000, 3000, 10000, 30000, 100000 };
+
+	printf("%8s %8s %8s %10s %12s %10s %10s\n", "points", "scan hit", "of", "grid hit", "scan ns", "grid ns", "speedup");
+	for (int count : counts) {
+		mt19937 random(seed);
+		TrailPoints trail;
+		LayTrail(random, count, trail);
+
+		OccupancyGrid grid(ARENA_SIZE, ARENA_SIZE);
+		grid.set(trail[0].first, trail[0].second);
+		for (size_t i = 1; i < trail.size(); i++) {
+			grid.stampSegment(trail[i - 1].first, trail[i - 1].second, trail[i].first, trail[i].second);
+		}
+
+		vector<pair<int, int>> positions;
+		uniform_int_distribution<int> anywhere(0, ARENA_SIZE - 1);
+		for (int i = 0; i < POSITIONS; i++) {
+			if (i % 2 == 0) {
+				positions.push_back(trail[random() % trail.size()]);
+			}
+			else {
+				positions.push_back(make_pair(anywhere(random), anywhere(random)));
+			}
+		}
+
+		// Enough passes for a few million grid lookups, and the scan capped near 100M segments
+		int scanPositions = (int)min<long long>(POSITIONS, 100000000LL / count);
+		int hits = 0;
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (int i = 0; i < scanPositions; i++) {
+			hits += ScanHits(trail, positions[i].first, positions[i].second) ? 1 : 0;
+		}
+		double scanTime = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / scanPositions;
+
+		int rounds = 1000;
+		int gridHits = 0;
+		start = chrono::steady_clock::now();
+		for (int r = 0; r < rounds; r++) {
+			// Each round starts somewhere else, so no round can be worked out once for all
+			for (int i = 0; i < POSITIONS; i++) {
+				const pair<int, int>& at = positions[(i + r) & (POSITIONS - 1)];
+				gridHits += grid.isOccupied(at.first, at.second) ? 1 : 0;
+			}
+		}
+		double gridTime = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() /
+			((double)rounds * POSITIONS);
+
+		for (int i = 0; i < POSITIONS; i++) {
+			if (ScanHits(trail, positions[i].first, positions[i].second) !=
+				grid.isOccupied(positions[i].first, positions[i].second)) {
+				printf("Scan and grid disagree at (%d, %d) with %d points\n", positions[i].first, positions[i].second, count);
+				return 1;
+			}
+		}
+
+		printf("%8d %8d %8d %10d %12.1f %10.2f %9.0fx\n", count, hits, scanPositions, gridHits / rounds, scanTime,
+			gridTime, gridTime > 0 ? scanTime / gridTime : 0.0);
+	}
+	return 0;
+
+}
@@ -0,0 +1,94 @@
+// Headless Lightcycles server: many rooms, no window.
+//
+//   HeadlessServer [port] [rooms] [players] [workers] [report seconds]
+//
+// Runs a GameServer until interrupted. Clients join with RoomClient; a
+// room starts playing when its first client sits down, with the computer
+// in the empty seats, and stops when the last one leaves or goes quiet.
+// Every report seconds it prints the rooms in play, the server CPU they
+// took as rooms per core, and the tick latency percentiles since the last
+// report. ServerBench runs one in-process with bots on loopback.
+//
+// Build from the repository root (Linux):
+//   g++ -std=c++17 -O2 -I. Tools/HeadlessServer.cpp GameServer.cpp StateDelta.cpp Transport.cpp BatchRunner.cpp
+//       Simulation.cpp OccupancyGrid.cpp Trail.cpp Arena.cpp ThreadPool.cpp -pthread -o HeadlessServer
+
+#include "GameServer.h"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+using namespace std;
+
+static atomic<bool> stopping(false);
+
+static void Interrupted(int) {
+
+	stopping = true;
+
+}
+
+static void Report(GameServer& server) {
+
+	ServerStats stats = server.getStats();
+	const LatencyHistogram& latency = server.getLatency();
+	printf("%d rooms, %d clients, %.2f cores, %.0f rooms/core, tick latency p50 %.2f p99 %.2f p99.9 %.2f max %.2f ms, "
+		"%llu overruns, %.0f KB/s out, %llu send failures\n", stats.activeRooms, stats.clients, stats.coresUsed(),
+		stats.roomsPerCore(), latency.percentile(0.5) / 1000.0, latency.percentile(0.99) / 1000.0,
+		latency.percentile(0.999) / 1000.0, latency.getMax() / 1000.0, stats.overruns,
+		stats.wallSeconds > 0 ? stats.bytesSent / 1024.0 / stats.wallSeconds : 0.0, stats.sendFailures);
+	fflush(stdout);
+	server.resetStats();
+
+}
+
+int main(int argc, char* argv[]) {
+
+	ServerConfig config = DefaultServerConfig();
+	if (argc > 1) {
+		config.port = (uint16_t)atoi(argv[1]);
+	}
+	if (argc > 2) {
+		config.rooms = atoi(argv[2]);
+	}
+	if (argc > 3) {
+		config.playersPerRoom = atoi(argv[3]);
+	}
+	if (argc > 4) {
+		config.workers = atoi(argv[4]);
+	}
+	int reportSeconds = argc > 5 ? atoi(argv[5]) : 10;
+	reportSeconds = reportSeconds < 1 ? 1 : reportSeconds;
+
+	GameServer server;
+	if (!server.start(config)) {
+		fprintf(stderr, "Can't start the server: %s\n", server.getError().c_str());
+		return 1;
+	}
+	signal(SIGINT, Interrupted);
+	signal(SIGTERM, Interrupted);
+	printf("Listening on UDP port %u: %d rooms of %d, %d ticks and %d updates a second\n", server.getPort(),
+		config.rooms, config.playersPerRoom, config.tickRate, config.updateRate);
+	fflush(stdout);
+
+	thread reporter([&server, reportSeconds]() {
+		chrono::steady_clock::time_point next = chrono::steady_clock::now();
+		while (!stopping) {
+			next += chrono::seconds(reportSeconds);
+			while (!stopping && chrono::steady_clock::now() < next) {
+				this_thread::sleep_for(chrono::milliseconds(100));
+			}
+			if (!stopping) {
+				Report(server);
+			}
+		}
+	});
+	server.run(stopping);
+	reporter.join();
+	server.close();
+	return 0;
+
+}
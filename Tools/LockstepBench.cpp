@@ -0,0 +1,237 @@
+// Benchmark: lockstep sessions over simulated and real links.
+//
+//   LockstepBench [players] [ticks] [delay]
+//   LockstepBench udp [players] [ticks] [delay] [base port]
+//
+// Runs players lockstep peers in one process, each driving its own cycle
+// with the random policy, until every peer has stepped ticks ticks; rounds
+// restart as they end. By default the peers talk over an in-process
+// loopback on a simulated clock, once per link in the table below, so
+// loss and latency cost no real time. With udp they talk over UDP
+// sockets on localhost from base port up, in real time at 60 ticks a
+// second.
+//
+// Prints the stalls (ticks a peer spent waiting for someone's input),
+// the round trip the sessions measured, datagrams sent and dropped, and
+// whether every peer saw the same state hash on every tick. The round
+// trip includes up to a tick each way of waiting to be read, since a
+// session reads once per tick. With the input delay covering the one-way
+// trip a link should run with few stalls despite heavy loss, and must
+// never desync.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. Tools/LockstepBench.cpp Lockstep.cpp NetSession.cpp Transport.cpp LoopbackTransport.cpp
+//       UdpTransport.cpp BatchRunner.cpp Simulation.cpp OccupancyGrid.cpp Trail.cpp Arena.cpp
+//       ThreadPool.cpp -pthread -o LockstepBench
+//   (add -lws2_32 on Windows)
+
+#include "Lockstep.h"
+#include "LoopbackTransport.h"
+#include "UdpTransport.h"
+#include "BatchRunner.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+using namespace std;
+
+const int TICK_RATE = 60;
+const unsigned int SESSION = 0x4c4b0001;
+
+struct Link {
+	const char* name;
+	LinkConditions conditions;
+};
+
+const Link links[] = {
+	{ "perfect", { 0, 0, 0, 0 } },
+	{ "lan", { 0, 0, 2000, 1000 } },
+	{ "50ms", { 0, 0, 50000, 0 } },
+	{ "50ms 10% loss", { 10, 0, 50000, 10000 } },
+	{ "100ms 20% loss", { 20, 5, 100000, 30000 } },
+	{ "150ms 30% loss", { 30, 5, 150000, 50000 } }
+};
+
+// One peer: its session, its copy of the game and its state hash after every tick
+struct Peer {
+	LockstepSession session;
+	GameState state;
+	mt19937 rng;
+	unsigned int round;
+	vector<uint64_t> hashes;
+};
+
+static void StartRound(Peer& peer, int players) {
+
+	SimConfig config = DefaultSimConfig(500, 400, players);
+	config.seed = SESSION + peer.round;
+	SimStart(peer.state, config);
+
+}
+
+// Step one peer once, starting the next round if this tick ended one
+static void RunTick(Peer& peer, int player, int players) {
+
+	PLAYERINPUT input = RandomPolicy(peer.state, player, peer.rng);
+	if (peer.session.advance(peer.state, input)) {
+		peer.hashes.push_back(StateHash(peer.state));
+		if (peer.state.over) {
+			peer.round++;
+			StartRound(peer, players);
+		}
+	}
+
+}
+
+// Whether every peer stepped the same states, over the ticks all of them got to
+static bool SameHashes(const vector<unique_ptr<Peer>>& peers, unsigned int ticks) {
+
+	for (size_t p = 1; p < peers.size(); p++) {
+		for (unsigned int t = 0; t < ticks; t++) {
+			if (peers[p]->hashes[t] != peers[0]->hashes[t]) {
+				return false;
+			}
+		}
+	}
+	return true;
+
+}
+
+static unsigned int SlowestTick(const vector<unique_ptr<Peer>>& peers) {
+
+	unsigned int slowest = peers[0]->session.getTick();
+	for (size_t p = 1; p < peers.size(); p++) {
+		if (peers[p]->session.getTick() < slowest) {
+			slowest = peers[p]->session.getTick();
+		}
+	}
+	return slowest;
+
+}
+
+static void PrintResult(const char* name, const vector<unique_ptr<Peer>>& peers, unsigned long long calls,
+	unsigned int ticks, unsigned long long sent, unsigned long long dropped) {
+
+	unsigned long long stalls = 0;
+	long long roundTrip = -1;
+	bool desynced = false;
+	for (size_t p = 0; p < peers.size(); p++) {
+		stalls += peers[p]->session.getStats().stalls;
+		if (peers[p]->session.getMaxRoundTrip() > roundTrip) {
+			roundTrip = peers[p]->session.getMaxRoundTrip();
+		}
+		desynced = desynced || peers[p]->session.isDesynced();
+	}
+	printf("%-16s %8u %8llu %7.1f%% %9.1f %9llu %9llu %8s %6s\n", name, ticks, stalls,
+		calls > 0 ? 100.0 * stalls / calls : 0.0, roundTrip / 1000.0, sent, dropped,
+		desynced ? "yes" : "no", SameHashes(peers, ticks) ? "yes" : "NO");
+
+}
+
+static void RunSimulated(int players, unsigned int ticks, int delay) {
+
+	for (const Link& link : links) {
+		long long now = 0;
+		NetClock clock = [&now]() { return now; };
+		LoopbackNetwork network(players);
+		vector<unique_ptr<LossyTransport>> ends;
+		vector<unique_ptr<Peer>> peers;
+		for (int p = 0; p < players; p++) {
+			ends.emplace_back(new LossyTransport(&network.getEnd(p), link.conditions, 100 + p, clock));
+			peers.emplace_back(new Peer());
+			Peer& peer = *peers.back();
+			SessionConfig config = { players, p, delay, SESSION };
+			peer.session.start(config, ends.back().get(), clock);
+			peer.rng.seed(p + 1);
+			peer.round = 0;
+			StartRound(peer, players);
+		}
+
+		// Every peer gets one call per tick of simulated time, as the game loop gives it
+		unsigned long long calls = 0;
+		for (long long frame = 1; SlowestTick(peers) < ticks; frame++) {
+			for (int p = 0; p < players; p++) {
+				RunTick(*peers[p], p, players);
+			}
+			calls += players;
+			now = frame * 1000000 / TICK_RATE;
+		}
+
+		unsigned long long sent = 0, dropped = 0;
+		for (int p = 0; p < players; p++) {
+			sent += peers[p]->session.getStats().packetsSent;
+			dropped += ends[p]->getDropped();
+		}
+		PrintResult(link.name, peers, calls, ticks, sent, dropped);
+	}
+
+}
+
+static bool RunUdp(int players, unsigned int ticks, int delay, int basePort) {
+
+	vector<unique_ptr<UdpTransport>> sockets;
+	vector<unique_ptr<Peer>> peers;
+	for (int p = 0; p < players; p++) {
+		sockets.emplace_back(new UdpTransport());
+		if (!sockets.back()->open((uint16_t)(basePort + p))) {
+			fprintf(stderr, "port %d: %s\n", basePort + p, sockets.back()->getError().c_str());
+			return false;
+		}
+		for (int other = 0; other < players; other++) {
+			if (other != p) {
+				sockets.back()->setPeer(other, "127.0.0.1", (uint16_t)(basePort + other));
+			}
+		}
+		peers.emplace_back(new Peer());
+		Peer& peer = *peers.back();
+		SessionConfig config = { players, p, delay, SESSION };
+		peer.session.start(config, sockets.back().get());
+		peer.rng.seed(p + 1);
+		peer.round = 0;
+		StartRound(peer, players);
+	}
+
+	chrono::steady_clock::time_point next = chrono::steady_clock::now();
+	unsigned long long calls = 0;
+	while (SlowestTick(peers) < ticks) {
+		for (int p = 0; p < players; p++) {
+			RunTick(*peers[p], p, players);
+		}
+		calls += players;
+		next += chrono::microseconds(1000000 / TICK_RATE);
+		this_thread::sleep_until(next);
+	}
+
+	unsigned long long sent = 0;
+	for (int p = 0; p < players; p++) {
+		sent += peers[p]->session.getStats().packetsSent;
+	}
+	PrintResult("udp localhost", peers, calls, ticks, sent, 0);
+	return true;
+
+}
+
+int main(int argc, char* argv[]) {
+
+	bool udp = argc > 1 && strcmp(argv[1], "udp") == 0;
+	int arg = udp ? 2 : 1;
+	int players = argc > arg ? atoi(argv[arg]) : 2;
+	unsigned int ticks = argc > arg + 1 ? (unsigned int)strtoul(argv[arg + 1], NULL, 10) : (udp ? 600 : 6000);
+	int delay = argc > arg + 2 ? atoi(argv[arg + 2]) : 6;
+	int basePort = argc > arg + 3 ? atoi(argv[arg + 3]) : 47000;
+	players = players < 2 ? 2 : (players > MAX_PLAYERS ? MAX_PLAYERS : players);
+
+	printf("%d players, %d tick input delay (%d ms at %d ticks a second)\n", players, delay,
+		delay * 1000 / TICK_RATE, TICK_RATE);
+	printf("%-16s %8s %8s %8s %9s %9s %9s %8s %6s\n", "link", "ticks", "stalls", "stalled",
+		"rtt ms", "sent", "dropped", "desync", "match");
+	if (udp) {
+		return RunUdp(players, ticks, delay, basePort) ? 0 : 1;
+	}
+	RunSimulated(players, ticks, delay);
+	return 0;
+
+}
@@ -0,0 +1,142 @@
+// Benchmark: MctsAI playouts a second, and strength, as workers are added.
+//
+//   MctsBench [matches] [budget us] [seed] [max workers]
+//
+// For 1, 2, 4, ... workers up to the core count or max workers, first
+// times searches of a fixed playout budget from the same mid-round
+// position and prints playouts a second in all and per worker. Then gives
+// each decision budget microseconds and plays matches rounds as blue
+// against the random policy and matches against SearchAI on the same
+// budget, printing wins, draws and losses. With the time fixed, more
+// workers mean more playouts a move, which should show as more wins.
+// Rounds that last 5,000 ticks count as draws.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. Tools/MctsBench.cpp MctsAI.cpp SearchAI.cpp BitBoard.cpp BatchRunner.cpp Simulation.cpp
+//       OccupancyGrid.cpp Trail.cpp Arena.cpp ThreadPool.cpp -pthread -o MctsBench
+
+#include "BatchRunner.h"
+#include "MctsAI.h"
+#include "SearchAI.h"
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static const int TIMED_PLAYOUTS = 20000;
+static const int TIMED_SEARCHES = 3;
+static const unsigned int MAX_TICKS = 5000;
+
+struct Score {
+	int wins, draws, losses;
+};
+
+// A round a little way in, blue free to turn, for every worker count to search
+static void MidRound(GameState& state, unsigned int seed) {
+
+	SimConfig config = DefaultSimConfig();
+	for (unsigned int attempt = 0; ; attempt++) {
+		config.seed = MatchSeed(seed, attempt);
+		SimStart(state, config);
+		mt19937 rng(config.seed);
+		PLAYERINPUT inputs[MAX_PLAYERS];
+		while (!state.over && state.tick < 60) {
+			inputs[0] = RandomPolicy(state, 0, rng);
+			inputs[1] = RandomPolicy(state, 1, rng);
+			SimStep(state, inputs);
+		}
+		if (!state.over && !state.cycles[PLAYER_BLUE].changingDirection) {
+			return;
+		}
+	}
+
+}
+
+// MctsAI as blue against opponent as orange, or the random policy if there is none
+static Score PlayMatches(int matches, long long budget, int workers, unsigned int seed, CpuPlayer* opponent) {
+
+	Score score = { 0, 0, 0 };
+	MctsAI mcts(PLAYER_BLUE, 1 << 30, workers);
+	mcts.setTimeBudget(budget);
+	for (int match = 0; match < matches; match++) {
+		GameState state;
+		SimConfig config = DefaultSimConfig();
+		config.seed = MatchSeed(seed, (unsigned int)match);
+		SimStart(state, config);
+		mt19937 rng(config.seed);
+		PLAYERINPUT inputs[MAX_PLAYERS];
+		while (!state.over && state.tick < MAX_TICKS) {
+			inputs[PLAYER_BLUE] = mcts.chooseInput(state);
+			inputs[PLAYER_ORANGE] = opponent != nullptr ? opponent->chooseInput(state) :
+				RandomPolicy(state, PLAYER_ORANGE, rng);
+			SimStep(state, inputs);
+		}
+		if (!state.over || state.winner < 0) {
+			score.draws++;
+		}
+		else if (state.winner == PLAYER_BLUE) {
+			score.wins++;
+		}
+		else {
+			score.losses++;
+		}
+	}
+	return score;
+
+}
+
+int main(int argc, char* argv[]) {
+
+	int matches = argc > 1 ? atoi(argv[1]) : 10;
+	long long budget = argc > 2 ? atoll(argv[2]) : 2000;
+	unsigned int seed = argc > 3 ? (unsigned int)strtoul(argv[3], NULL, 10) : 1;
+	int cores = (int)thread::hardware_concurrency();
+	cores = cores < 1 ? 1 : cores;
+	int maxWorkers = argc > 4 ? atoi(argv[4]) : cores;
+	maxWorkers = maxWorkers < 1 ? 1 : maxWorkers;
+	budget = budget < 1 ? 1 : budget;
+
+	vector<int> workerCounts;
+	for (int workers = 1; workers < maxWorkers; workers *= 2) {
+		workerCounts.push_back(workers);
+	}
+	workerCounts.push_back(maxWorkers);
+
+	GameState position;
+	MidRound(position, seed);
+
+	printf("%d cores, %lld us a move, %d matches against each opponent\n", cores, budget, matches);
+	printf("%8s %12s %12s %8s %10s %16s %16s\n", "workers", "playouts/s", "per worker", "speedup", "nodes",
+		"vs random W/D/L", "vs search W/D/L");
+	double single = 0;
+	for (int workers : workerCounts) {
+		MctsAI timed(PLAYER_BLUE, TIMED_PLAYOUTS, workers);
+		unsigned long long playouts = 0, nodes = 0;
+		long long microseconds = 0;
+		for (int i = 0; i < TIMED_SEARCHES; i++) {
+			timed.chooseInput(position);
+			playouts += timed.getStats().playouts;
+			nodes += timed.getStats().nodes;
+			microseconds += timed.getStats().microseconds;
+		}
+		double rate = microseconds > 0 ? playouts * 1000000.0 / microseconds : 0.0;
+		if (single == 0) {
+			single = rate;
+		}
+
+		Score random = PlayMatches(matches, budget, workers, seed, nullptr);
+		SearchAI search(PLAYER_ORANGE, budget);
+		Score searched = PlayMatches(matches, budget, workers, seed, &search);
+
+		char againstRandom[32], againstSearch[32];
+		snprintf(againstRandom, sizeof(againstRandom), "%d/%d/%d", random.wins, random.draws, random.losses);
+		snprintf(againstSearch, sizeof(againstSearch), "%d/%d/%d", searched.wins, searched.draws, searched.losses);
+		printf("%8d %12.0f %12.0f %7.2fx %10llu %16s %16s\n", timed.getStats().threads, rate, rate / workers,
+			single > 0 ? rate / single : 0.0, nodes / TIMED_SEARCHES, againstRandom, againstSearch);
+		fflush(stdout);
+	}
+	return 0;
+
+}
@@ -0,0 +1,163 @@
+// Offline tool: packs every bitmap named in Resource.h into one archive.
+//
+//   PackAssets [-z] [-atlas <prefix> <sheet.bmp> <table>] Resource.h Res Res/Assets.lcpk
+//
+// Each "#define IDB_<Name> <id>" line becomes an entry keyed by <id> and
+// <Name>, read from <Name>.bmp in the image directory. -z compresses the
+// entries that get smaller. -atlas also packs the images whose names
+// start with prefix into a SpriteAtlas and saves its sheet and table, as
+// the game loads when there is no archive:
+//
+//   PackAssets -atlas Cycle Res/Cycles.bmp Res/Cycles.atlas Resource.h Res Res/Assets.lcpk
+//
+// Afterwards the tool times loading every image from the archive against
+// loading the .bmp files one by one.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. Tools/PackAssets.cpp AssetArchive.cpp Compression.cpp
+//       BmpImage.cpp MappedFile.cpp Framebuffer.cpp SpriteAtlas.cpp -o PackAssets
+
+#include "AssetArchive.h"
+#include "BmpImage.h"
+#include "SpriteAtlas.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+struct ResourceImage {
+	uint32_t id;
+	string name;
+};
+
+static bool ReadResourceIds(const string& fileName, vector<ResourceImage>& images) {
+
+	ifstream header(fileName.c_str());
+	if (!header) {
+		return false;
+	}
+
+	string line;
+	while (getline(header, line)) {
+		istringstream words(line);
+		string directive, symbol;
+		long long id;
+		if (words >> directive >> symbol >> id && directive == "#define" &&
+			symbol.compare(0, 4, "IDB_") == 0 && id >= 0) {
+			ResourceImage image = { (uint32_t)id, symbol.substr(4) };
+			images.push_back(image);
+		}
+	}
+	return true;
+
+}
+
+static double SecondsSince(chrono::steady_clock::time_point start) {
+
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+}
+
+int main(int argc, char* argv[]) {
+
+	bool compress = false;
+	string atlasPrefix, atlasSheet, atlasTable;
+	int arg = 1;
+	if (arg < argc && strcmp(argv[arg], "-z") == 0) {
+		compress = true;
+		arg++;
+	}
+	if (arg + 3 < argc && strcmp(argv[arg], "-atlas") == 0) {
+		atlasPrefix = argv[arg + 1];
+		atlasSheet = argv[arg + 2];
+		atlasTable = argv[arg + 3];
+		arg += 4;
+	}
+	if (argc - arg != 3) {
+		fprintf(stderr, "usage: PackAssets [-z] [-atlas <prefix> <sheet.bmp> <table>] Resource.h <image dir> <archive>\n");
+		return 2;
+	}
+	string resourceHeader = argv[arg], imageDir = argv[arg + 1], archiveName = argv[arg + 2];
+
+	vector<ResourceImage> images;
+	if (!ReadResourceIds(resourceHeader, images) || images.empty()) {
+		fprintf(stderr, "%s: no IDB_ bitmaps found\n", resourceHeader.c_str());
+		return 1;
+	}
+
+	AssetArchiveWriter writer;
+	SpriteAtlas atlas;
+	size_t fileBytes = 0;
+	for (size_t i = 0; i < images.size(); i++) {
+		string path = imageDir + "/" + images[i].name + ".bmp";
+		BmpFile file;
+		if (!file.open(path)) {
+			fprintf(stderr, "%s: %s\n", path.c_str(), file.getError());
+			return 1;
+		}
+		PixelImage image;
+		file.getView().toPixelImage(image);
+		writer.add(images[i].id, images[i].name, image, compress);
+		fileBytes += file.getView().getPixelBytes();
+		if (!atlasPrefix.empty() && images[i].name.compare(0, atlasPrefix.size(), atlasPrefix) == 0) {
+			atlas.add(images[i].name, image);
+		}
+	}
+	if (!writer.save(archiveName)) {
+		fprintf(stderr, "%s: write failed\n", archiveName.c_str());
+		return 1;
+	}
+	if (!atlasPrefix.empty()) {
+		atlas.pack();
+		if (atlas.getFrameCount() == 0 || !atlas.save(atlasSheet, atlasTable)) {
+			fprintf(stderr, "%s: no %s images, or write failed\n", atlasSheet.c_str(), atlasPrefix.c_str());
+			return 1;
+		}
+		printf("%d frames in a %dx%d atlas\n", atlas.getFrameCount(), atlas.getSheet().width, atlas.getSheet().height);
+	}
+
+	AssetArchive archive;
+	if (!archive.open(archiveName)) {
+		fprintf(stderr, "%s: %s\n", archiveName.c_str(), archive.getError());
+		return 1;
+	}
+	for (int i = 0; i < archive.getCount(); i++) {
+		printf("%6u %-20s %4dx%-4d %s\n", archive.getId(i), archive.getName(i).c_str(),
+			archive.getWidth(i), archive.getHeight(i), archive.isCompressed(i) ? "lz" : "raw");
+	}
+	printf("%d images, %zu bytes of pixels in the files, %zu bytes packed\n",
+		archive.getCount(), fileBytes, archive.getSize());
+	archive.close();
+
+	// Start-up cost of each path: open and decode every image into memory
+	// we own, so the raw archive path pays for touching its pixels too
+	const int runs = 200;
+	PixelImage scratch;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (int run = 0; run < runs; run++) {
+		AssetArchive timed;
+		timed.open(archiveName);
+		for (size_t i = 0; i < images.size(); i++) {
+			timed.readImage(timed.find(images[i].id), scratch);
+		}
+	}
+	double archiveSeconds = SecondsSince(start) / runs;
+
+	start = chrono::steady_clock::now();
+	for (int run = 0; run < runs; run++) {
+		for (size_t i = 0; i < images.size(); i++) {
+			BmpFile file;
+			file.open(imageDir + "/" + images[i].name + ".bmp");
+			file.getView().toPixelImage(scratch);
+		}
+	}
+	double fileSeconds = SecondsSince(start) / runs;
+
+	printf("load all: archive %.1f us, separate files %.1f us\n",
+		archiveSeconds * 1e6, fileSeconds * 1e6);
+	return 0;
+
+}
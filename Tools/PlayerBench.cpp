@@ -0,0 +1,80 @@
+// Benchmark: SimStep() cost as rounds grow from 2 to 16 cycles.
+//
+//   PlayerBench [matches] [seed]
+//
+// Plays the matches for each player count with the random policy, keeping
+// every tick's inputs, then steps the same rounds again with nothing but
+// SimStep() on the clock. The arena grows with the player count so each
+// cycle has the room it would have in a 500 x 400 two-player round. Cost
+// per live cycle per tick should stay flat as players are added.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. Tools/PlayerBench.cpp BatchRunner.cpp Simulation.cpp OccupancyGrid.cpp
+//       Trail.cpp Arena.cpp ThreadPool.cpp -pthread -o PlayerBench
+
+#include "BatchRunner.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+struct RecordedMatch {
+	SimConfig config;
+	vector<PLAYERINPUT> inputs;		// config.players per tick
+};
+
+int main(int argc, char* argv[]) {
+
+	int matches = argc > 1 ? atoi(argv[1]) : 200;
+	unsigned int seed = argc > 2 ? (unsigned int)strtoul(argv[2], NULL, 10) : 1;
+	const int counts[] = { 2, 4, 8, 16 };
+
+	printf("%8s %10s %10s %12s %12s %16s\n", "players", "arena", "ticks", "cycle ticks", "us/tick", "ns/cycle tick");
+	for (int players : counts) {
+		double scale = sqrt(players / 2.0);
+		SimConfig config = DefaultSimConfig((int)(500 * scale), (int)(400 * scale), players);
+
+		vector<RecordedMatch> recorded(matches);
+		unsigned long long ticks = 0, cycleTicks = 0;
+		GameState state;
+		Arena arena;
+		for (int match = 0; match < matches; match++) {
+			RecordedMatch& round = recorded[match];
+			round.config = config;
+			round.config.seed = MatchSeed(seed, (unsigned int)match);
+			arena.reset();
+			SimStart(state, round.config, &arena);
+			mt19937 rng(round.config.seed);
+			PLAYERINPUT inputs[MAX_PLAYERS];
+			while (!state.over && state.tick < 100000) {
+				for (int i = 0; i < players; i++) {
+					inputs[i] = RandomPolicy(state, i, rng);
+					cycleTicks += state.cycles[i].alive ? 1 : 0;
+				}
+				round.inputs.insert(round.inputs.end(), inputs, inputs + players);
+				SimStep(state, inputs);
+			}
+			ticks += state.tick;
+		}
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (int match = 0; match < matches; match++) {
+			const RecordedMatch& round = recorded[match];
+			arena.reset();
+			SimStart(state, round.config, &arena);
+			for (size_t tick = 0; tick * players < round.inputs.size(); tick++) {
+				SimStep(state, &round.inputs[tick * players]);
+			}
+		}
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		char size[32];
+		snprintf(size, sizeof(size), "%dx%d", config.width, config.height);
+		printf("%8d %10s %10llu %12llu %12.2f %16.1f\n", players, size, ticks, cycleTicks,
+			seconds * 1e6 / ticks, seconds * 1e9 / cycleTicks);
+	}
+	return 0;
+
+}
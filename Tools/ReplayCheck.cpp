@@ -0,0 +1,186 @@
+// Check: replays survive a round trip, and bad files are refused.
+//
+//   ReplayCheck [rounds] [seed]
+//
+// Records rounds of the random policy, loads each back and plays it
+// through, which must end on the recorded state with no desync. Then feeds
+// ReplayPlayer::load() every truncation of a recording, recordings with
+// random bytes flipped, and handmade files whose runs are huge or wrap
+// around 2^64 when added up. Those must be refused without throwing, and
+// without asking for more memory than a real match could need, while the
+// replay loaded before them stays as it was. Prints what it checked and
+// returns nonzero on the first failure.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. Tools/ReplayCheck.cpp Replay.cpp BatchRunner.cpp Simulation.cpp OccupancyGrid.cpp
+//       Trail.cpp Arena.cpp ThreadPool.cpp -pthread -o ReplayCheck
+
+#include "BatchRunner.h"
+#include "Replay.h"
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+using namespace std;
+
+static void writeVarint(vector<uint8_t>& out, uint64_t value) {
+
+	while (value >= 0x80) {
+		out.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((uint8_t)value);
+
+}
+
+// A two-player replay made by hand, one input byte per run
+static vector<uint8_t> Handmade(const vector<uint64_t>& runLengths, uint64_t checkpointTick = 0) {
+
+	vector<uint8_t> out = { 'L', 'C', 'R', 'P' };
+	writeVarint(out, 2);		// Version
+	writeVarint(out, 60);		// Tick rate
+	const int config[6] = { 500, 400, 28, 28, 2, 6 };
+	for (int value : config) {
+		writeVarint(out, (uint64_t)value << 1);
+	}
+	writeVarint(out, 1);		// Seed
+	writeVarint(out, 2);		// Players
+	writeVarint(out, runLengths.size());
+	for (uint64_t length : runLengths) {
+		writeVarint(out, length);
+		out.push_back(0);
+	}
+	writeVarint(out, checkpointTick > 0 ? 1 : 0);
+	if (checkpointTick > 0) {
+		writeVarint(out, checkpointTick);
+		out.insert(out.end(), 4, 0);
+	}
+	return out;
+
+}
+
+static vector<uint8_t> Record(unsigned int seed, GameState& end) {
+
+	SimConfig config = DefaultSimConfig();
+	config.seed = seed;
+	SimStart(end, config);
+	ReplayRecorder recorder;
+	recorder.start(config, 60, 100);
+	mt19937 rng(seed);
+	PLAYERINPUT inputs[MAX_PLAYERS];
+	while (!end.over && end.tick < 20000) {
+		for (int i = 0; i < config.players; i++) {
+			inputs[i] = RandomPolicy(end, i, rng);
+		}
+		SimStep(end, inputs);
+		recorder.record(inputs, end);
+	}
+	return recorder.finish();
+
+}
+
+// load() must say no, and not throw
+static bool Refused(ReplayPlayer& player, const vector<uint8_t>& data) {
+
+	try {
+		return !player.load(data);
+	}
+	catch (...) {
+		return false;
+	}
+
+}
+
+int main(int argc, char* argv[]) {
+
+	int rounds = argc > 1 ? atoi(argv[1]) : 20;
+	unsigned int seed = argc > 2 ? (unsigned int)strtoul(argv[2], NULL, 10) : 1;
+
+	// Round trips
+	size_t bytes = 0;
+	unsigned int ticks = 0;
+	for (int round = 0; round < rounds; round++) {
+		GameState end;
+		vector<uint8_t> data = Record(MatchSeed(seed, (unsigned int)round), end);
+		ReplayPlayer player;
+		if (!player.load(data)) {
+			printf("Round %d didn't load\n", round);
+			return 1;
+		}
+		player.fastForward(player.getLength());
+		if (player.isDesynced() || player.getTick() != end.tick || StateHash(player.getState()) != StateHash(end)) {
+			printf("Round %d didn't play back to where it ended\n", round);
+			return 1;
+		}
+		bytes += data.size();
+		ticks += end.tick;
+	}
+	printf("%d round trips, %u ticks in %zu bytes\n", rounds, ticks, bytes);
+
+	// Every truncation of a good recording
+	GameState end;
+	vector<uint8_t> good = Record(seed, end);
+	ReplayPlayer player;
+	if (!player.load(good)) {
+		printf("The recording didn't load\n");
+		return 1;
+	}
+	unsigned int goodLength = player.getLength();
+	for (size_t size = 0; size < good.size(); size++) {
+		if (!Refused(player, vector<uint8_t>(good.begin(), good.begin() + size))) {
+			printf("A recording cut to %zu of %zu bytes loaded\n", size, good.size());
+			return 1;
+		}
+	}
+	printf("%zu truncations refused\n", good.size());
+
+	// Garbage: random bytes flipped past the magic. Some still parse, none may throw.
+	mt19937 random(seed);
+	int loaded = 0, garbage = 20000;
+	for (int i = 0; i < garbage; i++) {
+		vector<uint8_t> data = good;
+		for (int flips = 1 + random() % 4; flips > 0; flips--) {
+			data[4 + random() % (data.size() - 4)] = (uint8_t)random();
+		}
+		try {
+			loaded += player.load(data) ? 1 : 0;
+		}
+		catch (...) {
+			printf("A damaged recording threw\n");
+			return 1;
+		}
+	}
+	printf("%d damaged recordings, %d still parsed\n", garbage, loaded);
+
+	// Huge runs: wrapping the sum, past four hours, a checkpoint past the end
+	player.load(good);
+	const uint64_t hours = 60ull * 60 * 60 * 4;
+	struct Case {
+		const char* name;
+		vector<uint8_t> data;
+	} cases[] = {
+		{ "a run of 2^64 - 1", Handmade({ ~0ull }) },
+		{ "runs of 1 and 2^64 - 1", Handmade({ 1, ~0ull }) },
+		{ "runs adding up to 2^64", Handmade({ 1ull << 63, 1ull << 63 }) },
+		{ "a run just past four hours", Handmade({ hours + 1 }) },
+		{ "runs just past four hours", Handmade({ hours, 1 }) },
+		{ "a checkpoint past the end", Handmade({ 100 }, 101) },
+	};
+	for (const Case& test : cases) {
+		if (!Refused(player, test.data)) {
+			printf("Loaded %s\n", test.name);
+			return 1;
+		}
+	}
+	if (player.getLength() != goodLength) {
+		printf("A refused file changed the loaded replay\n");
+		return 1;
+	}
+	if (!player.load(Handmade({ hours })) || player.getLength() != hours) {
+		printf("Four hours of input didn't load\n");
+		return 1;
+	}
+	printf("%zu oversized files refused, four hours loaded\n", sizeof(cases) / sizeof(cases[0]));
+	return 0;
+
+}
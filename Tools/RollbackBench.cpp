@@ -0,0 +1,226 @@
+// Benchmark: rollback depth against frame time, over simulated latency.
+//
+//   RollbackBench [players] [ticks] [delay] [max prediction]
+//
+// Runs players rollback peers in one process, each driving its own cycle
+// with the random policy, until every peer has settled ticks ticks; rounds
+// restart as they end. The peers talk over an in-process loopback on a
+// simulated clock, once per link in the table below, so latency costs no
+// real time and the only time measured is the CPU spent in advance(),
+// snapshots and re-simulation included.
+//
+// The game draws a frame every two ticks, so the peers are timed a frame
+// at a time: two advance() calls each. Per link it prints the rollbacks,
+// their average and deepest depth, the ticks spent stalled at the
+// prediction limit, frame time percentiles and whether every peer settled
+// on the same state hash on every tick. A table over all the links then
+// groups the frames by how many ticks they stepped again, to show what a
+// rollback of each depth costs against the 33 ms a frame has at 30 frames
+// a second. Rolling back 8 ticks or more has to fit with room to spare.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. Tools/RollbackBench.cpp Rollback.cpp NetSession.cpp Transport.cpp LoopbackTransport.cpp
+//       BatchRunner.cpp Simulation.cpp OccupancyGrid.cpp Trail.cpp Arena.cpp ThreadPool.cpp -pthread -o RollbackBench
+
+#include "Rollback.h"
+#include "LoopbackTransport.h"
+#include "BatchRunner.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+using namespace std;
+
+const int TICK_RATE = 60;
+const int TICKS_PER_FRAME = 2;
+const double FRAME_BUDGET = 1000.0 / 30;
+const unsigned int SESSION = 0x524b0001;
+const int MAX_DEPTH = RollbackSession::MAX_PREDICTION * TICKS_PER_FRAME;
+
+struct Link {
+	const char* name;
+	LinkConditions conditions;
+};
+
+// One-way latencies from a frame to past the default prediction limit
+const Link links[] = {
+	{ "16ms", { 0, 0, 16000, 0 } },
+	{ "50ms", { 0, 0, 50000, 5000 } },
+	{ "100ms", { 0, 0, 100000, 10000 } },
+	{ "100ms 10% loss", { 10, 5, 100000, 20000 } },
+	{ "150ms", { 0, 0, 150000, 20000 } },
+	{ "250ms 5% loss", { 5, 0, 250000, 30000 } }
+};
+
+// One peer: its session, its copy of the game and the state hash of every settled tick
+struct Peer {
+	RollbackSession session;
+	GameState state;
+	mt19937 rng;
+	unsigned int round;
+	vector<uint64_t> hashes;
+};
+
+static void StartRound(Peer& peer, int players) {
+
+	SimConfig config = DefaultSimConfig(500, 400, players);
+	config.seed = SESSION + peer.round;
+	SimStart(peer.state, config);
+	peer.session.startRound(peer.state);
+
+}
+
+// Step one peer once, starting the next round once the last one is final
+static void RunTick(Peer& peer, int player, int players) {
+
+	PLAYERINPUT input = RandomPolicy(peer.state, player, peer.rng);
+	if (peer.session.advance(peer.state, input) == ROLLBACK_ROUND_OVER) {
+		peer.round++;
+		StartRound(peer, players);
+	}
+	SettledTick settled;
+	while (peer.session.nextSettled(settled)) {
+		peer.hashes.push_back(settled.hash);
+	}
+
+}
+
+// Whether every peer settled on the same states, over the ticks all of them got to
+static bool SameHashes(const vector<unique_ptr<Peer>>& peers, unsigned int ticks) {
+
+	for (size_t p = 1; p < peers.size(); p++) {
+		for (unsigned int t = 0; t < ticks; t++) {
+			if (peers[p]->hashes[t] != peers[0]->hashes[t]) {
+				return false;
+			}
+		}
+	}
+	return true;
+
+}
+
+static unsigned int SlowestSettled(const vector<unique_ptr<Peer>>& peers) {
+
+	unsigned int slowest = peers[0]->session.getSettledTick();
+	for (size_t p = 1; p < peers.size(); p++) {
+		if (peers[p]->session.getSettledTick() < slowest) {
+			slowest = peers[p]->session.getSettledTick();
+		}
+	}
+	return slowest;
+
+}
+
+// Milliseconds at fraction of the way through sorted times
+static double Percentile(const vector<double>& sorted, double fraction) {
+
+	if (sorted.empty()) {
+		return 0;
+	}
+	size_t at = (size_t)(fraction * (sorted.size() - 1) + 0.5);
+	return sorted[at];
+
+}
+
+// Frame times of every peer, by how many ticks the frame stepped again
+static vector<double> depthFrames[MAX_DEPTH + 1];
+
+static void RunLink(const Link& link, int players, unsigned int ticks, int delay, int maxPrediction) {
+
+	long long now = 0;
+	NetClock clock = [&now]() { return now; };
+	LoopbackNetwork network(players);
+	vector<unique_ptr<LossyTransport>> ends;
+	vector<unique_ptr<Peer>> peers;
+	for (int p = 0; p < players; p++) {
+		ends.emplace_back(new LossyTransport(&network.getEnd(p), link.conditions, 100 + p, clock));
+		peers.emplace_back(new Peer());
+		Peer& peer = *peers.back();
+		SessionConfig config = { players, p, delay, SESSION };
+		peer.session.start(config, ends.back().get(), clock);
+		peer.session.setMaxPrediction(maxPrediction);
+		peer.rng.seed(p + 1);
+		peer.round = 0;
+		StartRound(peer, players);
+	}
+
+	// Every peer gets one call per tick of simulated time, as the game loop gives it,
+	// and the calls of each frame are timed together
+	vector<double> frames;
+	vector<double> frameTimes(players);
+	vector<unsigned long long> resimulatedBefore(players);
+	long long tick = 0;
+	while (SlowestSettled(peers) < ticks) {
+		for (int p = 0; p < players; p++) {
+			frameTimes[p] = 0;
+			resimulatedBefore[p] = peers[p]->session.getStats().resimulated;
+		}
+		for (int t = 0; t < TICKS_PER_FRAME; t++, tick++) {
+			now = tick * 1000000 / TICK_RATE;
+			for (int p = 0; p < players; p++) {
+				chrono::steady_clock::time_point start = chrono::steady_clock::now();
+				RunTick(*peers[p], p, players);
+				frameTimes[p] += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+			}
+		}
+		for (int p = 0; p < players; p++) {
+			unsigned long long depth = peers[p]->session.getStats().resimulated - resimulatedBefore[p];
+			depthFrames[depth > (unsigned long long)MAX_DEPTH ? MAX_DEPTH : depth].push_back(frameTimes[p]);
+			frames.push_back(frameTimes[p]);
+		}
+	}
+
+	unsigned long long stalls = 0, rollbacks = 0, resimulated = 0;
+	unsigned int deepest = 0;
+	bool desynced = false;
+	for (int p = 0; p < players; p++) {
+		const SessionStats& stats = peers[p]->session.getStats();
+		stalls += stats.stalls;
+		rollbacks += stats.rollbacks;
+		resimulated += stats.resimulated;
+		deepest = max(deepest, stats.deepestRollback);
+		desynced = desynced || peers[p]->session.isDesynced();
+	}
+	sort(frames.begin(), frames.end());
+	printf("%-16s %8u %8llu %9llu %6.1f %7u %8.3f %8.3f %8.3f %7s %6s\n", link.name, ticks, stalls, rollbacks,
+		rollbacks > 0 ? (double)resimulated / rollbacks : 0.0, deepest, Percentile(frames, 0.5),
+		Percentile(frames, 0.99), frames.back(), desynced ? "yes" : "no", SameHashes(peers, ticks) ? "yes" : "NO");
+
+}
+
+int main(int argc, char* argv[]) {
+
+	int players = argc > 1 ? atoi(argv[1]) : 4;
+	unsigned int ticks = argc > 2 ? (unsigned int)strtoul(argv[2], NULL, 10) : 6000;
+	int delay = argc > 3 ? atoi(argv[3]) : 1;
+	int maxPrediction = argc > 4 ? atoi(argv[4]) : 16;
+	players = players < 2 ? 2 : (players > MAX_PLAYERS ? MAX_PLAYERS : players);
+	maxPrediction = maxPrediction < 1 ? 1 : min(maxPrediction, (int)RollbackSession::MAX_PREDICTION);
+
+	printf("%d players, %d tick input delay, guessing up to %d ticks (%d ms) ahead\n", players, delay,
+		maxPrediction, maxPrediction * 1000 / TICK_RATE);
+	printf("%-16s %8s %8s %9s %6s %7s %8s %8s %8s %7s %6s\n", "link", "ticks", "stalls", "rollbacks",
+		"depth", "deepest", "p50 ms", "p99 ms", "max ms", "desync", "match");
+	for (const Link& link : links) {
+		RunLink(link, players, ticks, delay, maxPrediction);
+	}
+
+	printf("\n%-10s %9s %9s %9s %9s %9s\n", "resimmed", "frames", "mean ms", "p99 ms", "max ms", "of frame");
+	for (int depth = 0; depth <= MAX_DEPTH; depth++) {
+		vector<double>& times = depthFrames[depth];
+		if (times.empty()) {
+			continue;
+		}
+		sort(times.begin(), times.end());
+		double total = 0;
+		for (double ms : times) {
+			total += ms;
+		}
+		printf("%-10d %9zu %9.3f %9.3f %9.3f %8.1f%%\n", depth, times.size(), total / times.size(),
+			Percentile(times, 0.99), times.back(), 100.0 * times.back() / FRAME_BUDGET);
+	}
+	return 0;
+
+}
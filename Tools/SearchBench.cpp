@@ -0,0 +1,98 @@
+// Benchmark: SearchAI nodes a second, depth and time a move by arena size.
+//
+//   SearchBench [budget us] [ticks] [seed]
+//
+// Plays SearchAI as blue against the random policy for up to ticks ticks
+// in arenas from the default 500 x 400 to 20,000 x 20,000, once with the
+// default search window and once with a window as large as the arena,
+// which is what every search did before the window. Prints how many
+// searches ran, the mean and worst time a search took against budget,
+// nodes a second and the mean depth completed. The board is built before
+// the deadline is checked, so a worst time well over budget is the cost
+// of the board rather than of searching.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. Tools/SearchBench.cpp SearchAI.cpp BitBoard.cpp BatchRunner.cpp Simulation.cpp
+//       OccupancyGrid.cpp Trail.cpp Arena.cpp ThreadPool.cpp -pthread -o SearchBench
+
+#include "BatchRunner.h"
+#include "SearchAI.h"
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+struct Totals {
+	int searches;
+	unsigned long long nodes;
+	long long microseconds;
+	long long worst;
+	long long depths;
+};
+
+static Totals PlayRound(int width, int height, int window, long long budget, unsigned int ticks, unsigned int seed) {
+
+	Totals totals = { 0, 0, 0, 0, 0 };
+	SearchAI search(PLAYER_BLUE, budget);
+	search.setWindowSize(window);
+
+	GameState state;
+	SimConfig config = DefaultSimConfig(width, height);
+	config.seed = seed;
+	SimStart(state, config);
+	mt19937 rng(config.seed);
+	PLAYERINPUT inputs[MAX_PLAYERS];
+	while (!state.over && state.tick < ticks) {
+		// Only a cycle on the move and free to turn is searched for
+		const CycleState& me = state.cycles[PLAYER_BLUE];
+		bool searched = me.alive && (me.speedx != 0 || me.speedy != 0) && !me.changingDirection;
+		inputs[PLAYER_BLUE] = search.chooseInput(state);
+		inputs[PLAYER_ORANGE] = RandomPolicy(state, PLAYER_ORANGE, rng);
+		if (searched) {
+			const SearchStats& stats = search.getStats();
+			totals.searches++;
+			totals.nodes += stats.nodes;
+			totals.microseconds += stats.microseconds;
+			totals.worst = stats.microseconds > totals.worst ? stats.microseconds : totals.worst;
+			totals.depths += stats.depth;
+		}
+		SimStep(state, inputs);
+	}
+	return totals;
+
+}
+
+int main(int argc, char* argv[]) {
+
+	long long budget = argc > 1 ? atoll(argv[1]) : 5500;
+	unsigned int ticks = argc > 2 ? (unsigned int)strtoul(argv[2], NULL, 10) : 600;
+	unsigned int seed = argc > 3 ? (unsigned int)strtoul(argv[3], NULL, 10) : 1;
+	budget = budget < 1 ? 1 : budget;
+
+	static const int sizes[][2] = { { 500, 400 }, { 2000, 2000 }, { 5000, 5000 }, { 20000, 20000 } };
+	SearchAI defaults(PLAYER_BLUE);
+	int defaultWindow = defaults.getWindowSize();
+
+	printf("%lld us a move, up to %u ticks\n", budget, ticks);
+	printf("%14s %8s %9s %10s %10s %12s %7s\n", "arena", "window", "searches", "mean us", "worst us",
+		"nodes/s", "depth");
+	for (const int* size : sizes) {
+		int windows[2] = { defaultWindow, size[0] > size[1] ? size[0] : size[1] };
+		for (int i = 0; i < 2; i++) {
+			if (i == 1 && windows[1] <= windows[0]) {
+				continue;
+			}
+			Totals totals = PlayRound(size[0], size[1], windows[i], budget, ticks, seed);
+			int searches = totals.searches > 0 ? totals.searches : 1;
+			char arena[32];
+			snprintf(arena, sizeof(arena), "%d x %d", size[0], size[1]);
+			printf("%14s %8d %9d %10lld %10lld %12.0f %7.1f\n", arena, windows[i], totals.searches,
+				totals.microseconds / searches, totals.worst,
+				totals.microseconds > 0 ? totals.nodes * 1000000.0 / totals.microseconds : 0.0,
+				(double)totals.depths / searches);
+			fflush(stdout);
+		}
+	}
+	return 0;
+
+}
@@ -0,0 +1,212 @@
+// Benchmark: a GameServer under load from bot clients on loopback.
+//
+//   ServerBench [rooms[,rooms...]] [players] [workers] [seconds] [clients per socket]
+//
+// For each room count, starts a server on a free port with that many rooms
+// of players seats, and fills every seat with a bot: a RoomClient sending
+// random turns at the update rate over UDP on localhost. Bots share sockets,
+// clients per socket to each, with a thread per socket. Once everyone is
+// seated and a second has passed, the server's counters start over and the
+// run is measured for seconds seconds.
+//
+// Per room count it prints the server CPU used (workers stepping rooms and
+// the event loop, not the bots) as cores and as rooms per core, the tick
+// latency percentiles (from when a tick was due to when its updates were
+// sent), ticks skipped because a room was still busy, the size of an
+// average update and how many were deltas rather than full, how many the
+// bots applied, and whether every client rebuilt exactly the state the
+// server sent. Updates still in flight at either end of the window are
+// counted on one side only, so applied can read a little over 100%. The
+// bots run in the same process, so once the machine is busy the latencies
+// include waiting for them.
+//
+// Build from the repository root (Linux):
+//   g++ -std=c++17 -O2 -I. Tools/ServerBench.cpp GameServer.cpp RoomClient.cpp StateDelta.cpp Transport.cpp
+//       UdpTransport.cpp BatchRunner.cpp Simulation.cpp OccupancyGrid.cpp Trail.cpp Arena.cpp ThreadPool.cpp
+//       -pthread -o ServerBench
+
+#include "GameServer.h"
+#include "RoomClient.h"
+#include "UdpTransport.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Bots on one socket, stepped by one thread
+struct BotGroup {
+	UdpTransport socket;
+	vector<unique_ptr<RoomClient>> clients;
+	uint32_t firstToken;
+	thread runner;
+};
+
+// Once a frame: hand out what arrived by token, then every bot sends its keys
+static void RunBots(BotGroup& group, int updateRate, const atomic<bool>& stop, unsigned int seed) {
+
+	mt19937 rng(seed);
+	uint8_t packet[Transport::MAX_DATAGRAM];
+	chrono::steady_clock::time_point next = chrono::steady_clock::now();
+	while (!stop) {
+		size_t size;
+		while ((size = group.socket.receive(packet, sizeof(packet))) > 0) {
+			uint32_t token;
+			if (RoomClient::PacketToken(packet, size, token) && token >= group.firstToken &&
+				token - group.firstToken < group.clients.size()) {
+				group.clients[token - group.firstToken]->handlePacket(packet, size);
+			}
+		}
+		for (size_t i = 0; i < group.clients.size(); i++) {
+			PLAYERINPUT input = rng() % 20 == 0 ? (PLAYERINPUT)(1 << (rng() % 4)) : PI_NONE;
+			group.clients[i]->send(input);
+		}
+		next += chrono::microseconds(1000000 / updateRate);
+		this_thread::sleep_until(next);
+	}
+	for (size_t i = 0; i < group.clients.size(); i++) {
+		group.clients[i]->leave();
+	}
+
+}
+
+static RoomClientStats SumClientStats(const vector<unique_ptr<BotGroup>>& groups, int& welcomed) {
+
+	RoomClientStats sum;
+	memset(&sum, 0, sizeof(sum));
+	welcomed = 0;
+	for (size_t g = 0; g < groups.size(); g++) {
+		for (size_t i = 0; i < groups[g]->clients.size(); i++) {
+			const RoomClient& client = *groups[g]->clients[i];
+			const RoomClientStats& stats = client.getStats();
+			sum.updates += stats.updates;
+			sum.fullUpdates += stats.fullUpdates;
+			sum.stale += stats.stale;
+			sum.noBase += stats.noBase;
+			sum.mismatches += stats.mismatches;
+			sum.bytesReceived += stats.bytesReceived;
+			welcomed += client.isWelcomed() ? 1 : 0;
+		}
+	}
+	return sum;
+
+}
+
+static bool RunRooms(int rooms, int players, int workers, int seconds, int perSocket) {
+
+	GameServer server;
+	ServerConfig config = DefaultServerConfig(rooms, players);
+	config.port = 0;
+	config.workers = workers;
+	if (!server.start(config)) {
+		fprintf(stderr, "server: %s\n", server.getError().c_str());
+		return false;
+	}
+	atomic<bool> stopServer(false);
+	thread loop([&server, &stopServer]() { server.run(stopServer); });
+
+	int clients = rooms * players;
+	vector<unique_ptr<BotGroup>> groups;
+	atomic<bool> stopBots(false);
+	bool opened = true;
+	for (int first = 0; first < clients && opened; first += perSocket) {
+		groups.emplace_back(new BotGroup());
+		BotGroup& group = *groups.back();
+		opened = group.socket.open(0) && group.socket.setPeer(0, "127.0.0.1", server.getPort());
+		group.firstToken = (uint32_t)first + 1;
+		for (int i = first; i < clients && i < first + perSocket; i++) {
+			group.clients.emplace_back(new RoomClient());
+			group.clients.back()->start(&group.socket, (uint32_t)i + 1);
+		}
+	}
+	for (size_t g = 0; opened && g < groups.size(); g++) {
+		groups[g]->runner = thread(RunBots, ref(*groups[g]), config.updateRate, cref(stopBots), 1000 + (unsigned int)g);
+	}
+
+	// Everyone seated and a second to settle, then measure
+	int welcomed = 0;
+	RoomClientStats before;
+	for (int wait = 0; opened && wait < 50; wait++) {
+		this_thread::sleep_for(chrono::milliseconds(100));
+		SumClientStats(groups, welcomed);
+		if (welcomed == clients) {
+			break;
+		}
+	}
+	// Clients are counted inside the server's window so none of theirs fall outside it
+	this_thread::sleep_for(chrono::seconds(1));
+	server.resetStats();
+	before = SumClientStats(groups, welcomed);
+	this_thread::sleep_for(chrono::seconds(seconds));
+	RoomClientStats after = SumClientStats(groups, welcomed);
+	ServerStats stats = server.getStats();
+	const LatencyHistogram& latency = server.getLatency();
+
+	stopBots = true;
+	for (size_t g = 0; g < groups.size(); g++) {
+		if (groups[g]->runner.joinable()) {
+			groups[g]->runner.join();
+		}
+	}
+	stopServer = true;
+	loop.join();
+	server.close();
+	if (!opened) {
+		fprintf(stderr, "couldn't open the bot sockets\n");
+		return false;
+	}
+
+	unsigned long long updates = stats.fullUpdates + stats.deltaUpdates;
+	unsigned long long applied = after.updates - before.updates;
+	printf("%6d %7d/%-7d %6.2f %10.1f %8.2f %8.2f %8.2f %8.2f %9llu %8.1f %6.1f%% %6.1f%% %9llu\n",
+		stats.activeRooms, welcomed, clients, stats.coresUsed(), stats.roomsPerCore(),
+		latency.percentile(0.5) / 1000.0, latency.percentile(0.99) / 1000.0, latency.percentile(0.999) / 1000.0,
+		latency.getMax() / 1000.0, stats.overruns, updates > 0 ? (double)stats.bytesSent / stats.packetsSent : 0.0,
+		updates > 0 ? 100.0 * stats.deltaUpdates / updates : 0.0, updates > 0 ? 100.0 * applied / updates : 0.0,
+		after.mismatches);
+	return true;
+
+}
+
+int main(int argc, char* argv[]) {
+
+	vector<int> roomCounts;
+	const char* list = argc > 1 ? argv[1] : "50,100,200,400";
+	for (const char* at = list; *at != 0;) {
+		char* end;
+		long rooms = strtol(at, &end, 10);
+		if (end == at) {
+			break;
+		}
+		if (rooms > 0) {
+			roomCounts.push_back((int)rooms);
+		}
+		at = *end == ',' ? end + 1 : end;
+	}
+	int players = argc > 2 ? atoi(argv[2]) : 4;
+	int workers = argc > 3 ? atoi(argv[3]) : 0;
+	int seconds = argc > 4 ? atoi(argv[4]) : 5;
+	int perSocket = argc > 5 ? atoi(argv[5]) : 100;
+	players = players < 2 ? 2 : (players > MAX_PLAYERS ? MAX_PLAYERS : players);
+	seconds = seconds < 1 ? 1 : seconds;
+	perSocket = perSocket < 1 ? 1 : perSocket;
+
+	ServerConfig defaults = DefaultServerConfig();
+	printf("%d players a room, %d ticks and %d updates a second, %d workers, %d s a run\n", players,
+		defaults.tickRate, defaults.updateRate, workers > 0 ? workers : (int)thread::hardware_concurrency(), seconds);
+	printf("%6s %15s %6s %10s %8s %8s %8s %8s %9s %8s %7s %7s %9s\n", "rooms", "seated", "cores", "rooms/core",
+		"p50 ms", "p99 ms", "p99.9 ms", "max ms", "overruns", "bytes", "delta", "applied", "mismatch");
+	for (int rooms : roomCounts) {
+		if (!RunRooms(rooms, players, workers, seconds, perSocket)) {
+			return 1;
+		}
+	}
+	return 0;
+
+}
@@ -0,0 +1,113 @@
+// Benchmark: SpriteStore::update() with SSE2 and with the scalar loop.
+//
+//   SpriteBench [steps] [seed]
+//
+// Fills stores with random sprites, 10 to 100,000 of them, cycle sized,
+// moving up to 8 pixels a step inside a 2000 x 2000 world with a random
+// bounds action each. First one store is stepped with update() and an
+// identical one with update(false) for steps steps, checking after every
+// step that both hold the same sprites in the same places with the same
+// velocities and collision rects. Then each path is timed on its own,
+// once with no BA_DIE sprites so the count stays put, and once with a
+// quarter of them dying at the bounds (left is how many are left after),
+// which adds compacting out the dead. The scalar loop may still be
+// vectorized by the compiler; on targets without SSE2 both run it.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. Tools/SpriteBench.cpp SpriteStore.cpp -o SpriteBench
+
+#include "SpriteStore.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+using namespace std;
+
+static const int WORLD_SIZE = 2000;
+static const int SPRITE_SIZE = 28;
+static const int MAX_SPEED = 8;
+
+// The first actions bounds actions, 3 for all but BA_DIE
+static void Fill(SpriteStore& store, int count, unsigned int seed, int actions) {
+
+	mt19937 random(seed);
+	uniform_int_distribution<int> place(0, WORLD_SIZE - SPRITE_SIZE);
+	uniform_int_distribution<int> speed(-MAX_SPEED, MAX_SPEED);
+	SpriteRect bounds = { 0, 0, WORLD_SIZE, WORLD_SIZE };
+	store.clear();
+	store.reserve(count);
+	for (int i = 0; i < count; i++) {
+		SpriteRect position = { place(random), place(random), SPRITE_SIZE, SPRITE_SIZE };
+		store.add(position, speed(random), speed(random), bounds, (BOUNDSACTION)(random() % actions));
+	}
+
+}
+
+static bool SameSprites(const SpriteStore& a, const SpriteStore& b) {
+
+	if (a.getCount() != b.getCount()) {
+		return false;
+	}
+	for (int i = 0; i < a.getCount(); i++) {
+		if (a.getId(i) != b.getId(i) || a.getX(i) != b.getX(i) || a.getY(i) != b.getY(i) ||
+			a.getVelocityX(i) != b.getVelocityX(i) || a.getVelocityY(i) != b.getVelocityY(i) ||
+			a.getCollisionLefts()[i] != b.getCollisionLefts()[i] || a.getCollisionTops()[i] != b.getCollisionTops()[i] ||
+			a.getCollisionRights()[i] != b.getCollisionRights()[i] ||
+			a.getCollisionBottoms()[i] != b.getCollisionBottoms()[i]) {
+			return false;
+		}
+	}
+	return true;
+
+}
+
+// Mean microseconds an update() over steps steps of a fresh store
+static double TimeUpdates(int count, unsigned int seed, int actions, int steps, bool vectorized, int& left) {
+
+	SpriteStore store;
+	Fill(store, count, seed, actions);
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (int step = 0; step < steps; step++) {
+		store.update(vectorized);
+	}
+	left = store.getCount();
+	return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / steps;
+
+}
+
+int main(int argc, char* argv[]) {
+
+	int steps = argc > 1 ? atoi(argv[1]) : 300;
+	unsigned int seed = argc > 2 ? (unsigned int)strtoul(argv[2], NULL, 10) : 1;
+	steps = steps < 1 ? 1 : steps;
+	const int counts[] = { 10, 100, 1000, 10000, 100000 };
+
+	printf("%8s %10s %10s %10s %8s %14s %14s\n", "sprites", "sse2 us", "scalar us", "ns/sprite",
+		"left", "dying sse2 us", "dying scal. us");
+	for (int count : counts) {
+		// Every action, dying ones included, step for step the same both ways
+		SpriteStore vectorized, scalar;
+		Fill(vectorized, count, seed, 4);
+		Fill(scalar, count, seed, 4);
+		for (int step = 0; step < steps; step++) {
+			int vectorizedDeaths = vectorized.update();
+			int scalarDeaths = scalar.update(false);
+			if (vectorizedDeaths != scalarDeaths || !SameSprites(vectorized, scalar)) {
+				printf("SSE2 and scalar updates differ at step %d with %d sprites\n", step, count);
+				return 1;
+			}
+		}
+
+		// Timed on their own: sprites that stay, then with a quarter dying at the bounds
+		int left;
+		double vectorizedTime = TimeUpdates(count, seed, 3, steps, true, left);
+		double scalarTime = TimeUpdates(count, seed, 3, steps, false, left);
+		double dyingTime = TimeUpdates(count, seed, 4, steps, true, left);
+		double dyingScalarTime = TimeUpdates(count, seed, 4, steps, false, left);
+		printf("%8d %10.2f %10.2f %10.2f %8d %14.2f %14.2f\n", count, vectorizedTime, scalarTime,
+			vectorizedTime * 1000.0 / count, left, dyingTime, dyingScalarTime);
+	}
+	return 0;
+
+}
@@ -0,0 +1,123 @@
+#include "Trail.h"
+#include <cstdlib>
+
+using namespace std;
+
+void Trail::clear() {
+
+	points.clear();
+	length = 0;
+
+}
+
+void Trail::reset(Arena* arena) {
+
+	points = PointVector(ArenaAllocator<TrailPoint>(arena));
+	length = 0;
+
+}
+
+void Trail::append(int x, int y) {
+
+	TrailPoint point = { x, y };
+	if (points.empty()) {
+		points.push_back(point);
+		return;
+	}
+
+	TrailPoint& last = points.back();
+	int dx = x - last.x, dy = y - last.y;
+	if (dx == 0 && dy == 0) {
+		return;
+	}
+	length += abs(dx) + abs(dy);
+
+	// Carrying on the same way slides the open end
+	if (points.size() >= 2) {
+		const TrailPoint& previous = points[points.size() - 2];
+		int lastDx = last.x - previous.x, lastDy = last.y - previous.y;
+		if (lastDx * dy == lastDy * dx && lastDx * dx + lastDy * dy > 0) {
+			last = point;
+			return;
+		}
+	}
+	points.push_back(point);
+
+}
+
+void Trail::rewind(const TrailMark& to) {
+
+	// Points are only appended or the open end slid on, so dropping the
+	// newer ones and sliding the end back undoes both
+	if (to.points < points.size()) {
+		points.resize(to.points);
+	}
+	if (!points.empty()) {
+		points.back() = to.end;
+	}
+	length = to.length;
+
+}
+
+Trail::SegmentIterator Trail::begin() const {
+
+	if (points.size() < 2) {
+		return end();
+	}
+	return SegmentIterator(&points, 1, points[0]);
+
+}
+
+Trail::SegmentIterator Trail::end() const {
+
+	TrailPoint none = { 0, 0 };
+	return SegmentIterator(&points, points.size(), none);
+
+}
+
+Trail::SegmentRange Trail::segments() const {
+
+	SegmentRange range = { begin(), end() };
+	return range;
+
+}
+
+Trail::SegmentRange Trail::segmentsSince(const TrailMark& since) const {
+
+	// Nothing had been drawn from a mark with no length yet
+	if (!extends(since) || since.length == 0) {
+		return segments();
+	}
+	if (length == since.length) {
+		SegmentRange none = { end(), end() };
+		return none;
+	}
+
+	// The open end as it was may since have slid on, or stayed put and
+	// become a corner
+	const TrailPoint& corner = points[since.corner];
+	SegmentRange range = { SegmentIterator(&points, since.corner, since.end), end() };
+	if (corner.x == since.end.x && corner.y == since.end.y) {
+		range.first = SegmentIterator(&points, since.corner + 1, corner);
+	}
+	return range;
+
+}
+
+TrailMark Trail::mark() const {
+
+	TrailMark here;
+	here.corner = points.empty() ? 0 : points.size() - 1;
+	here.end.x = points.empty() ? 0 : points.back().x;
+	here.end.y = points.empty() ? 0 : points.back().y;
+	here.length = length;
+	here.points = points.size();
+	return here;
+
+}
+
+bool Trail::extends(const TrailMark& since) const {
+
+	return !points.empty() && since.corner < points.size() && since.length <= length;
+
+}
@@ -0,0 +1,104 @@
+#ifndef TRAIL_H
+#define TRAIL_H
+
+#include <cstddef>
+#include <vector>
+#include "Arena.h"
+
+struct TrailPoint {
+	int x;
+	int y;
+};
+
+struct TrailSegment {
+	int x1, y1;
+	int x2, y2;
+};
+
+// Where a trail had got to, so a consumer can pick up only what was added
+// after it, or the trail can be wound back to it
+struct TrailMark {
+	size_t corner;				// Index of the open end at the time
+	TrailPoint end;				// Where the open end was
+	unsigned long long length;
+	size_t points;				// Point count, 0 while the trail was empty
+};
+
+// The path a cycle has left behind, kept as its corners. The last point is
+// the open end: moving on in the same direction slides it forward rather
+// than adding a point, so memory grows with the number of turns, not with
+// the number of ticks. Points are only ever appended or slid forward.
+class Trail {
+public:
+	typedef std::vector<TrailPoint, ArenaAllocator<TrailPoint>> PointVector;
+
+protected:
+	PointVector points;
+	unsigned long long length;	// Pixels covered, not counting the first
+
+public:
+	// Walks the straight segments from the start (or from a mark) to the
+	// open end
+	class SegmentIterator {
+	protected:
+		const PointVector* points;
+		size_t index;			// Segment ends at (*points)[index]
+		TrailPoint start;		// Where the first segment starts
+
+	public:
+		SegmentIterator(const PointVector* points, size_t index, TrailPoint start)
+			: points(points), index(index), start(start) {};
+
+		TrailSegment operator*() const {
+			TrailSegment segment = { start.x, start.y, (*points)[index].x, (*points)[index].y };
+			return segment;
+		};
+		SegmentIterator& operator++() {
+			start = (*points)[index];
+			index++;
+			return *this;
+		};
+		bool operator==(const SegmentIterator& other) const { return index == other.index; };
+		bool operator!=(const SegmentIterator& other) const { return index != other.index; };
+	};
+
+	struct SegmentRange {
+		SegmentIterator first;
+		SegmentIterator last;
+
+		SegmentIterator begin() const { return first; };
+		SegmentIterator end() const { return last; };
+	};
+
+	Trail(Arena* arena = nullptr) : points(ArenaAllocator<TrailPoint>(arena)), length(0) {};
+
+	void clear();
+	// Empty the trail and keep its points in arena from now on, or on the
+	// heap if that is null. Any storage from an arena is dropped unread, so
+	// this is safe to call after that arena was reset.
+	void reset(Arena* arena);
+	// Extend the trail to x, y. The first call only sets the start.
+	void append(int x, int y);
+	// Put the trail back as it was when the mark was taken, for rollback.
+	// The mark must be from this trail, since it was last reset.
+	void rewind(const TrailMark& mark);
+
+	bool empty() const { return points.empty(); };
+	size_t getPointCount() const { return points.size(); };
+	const TrailPoint& getPoint(size_t index) const { return points[index]; };
+	const TrailPoint& back() const { return points.back(); };
+	unsigned long long getLength() const { return length; };
+
+	// Every segment, or just what was added or extended since a mark. A
+	// mark from a longer trail (a new round) gives everything.
+	SegmentIterator begin() const;
+	SegmentIterator end() const;
+	SegmentRange segments() const;
+	SegmentRange segmentsSince(const TrailMark& mark) const;
+	TrailMark mark() const;
+	// Whether this is the trail the mark was taken from, grown since
+	bool extends(const TrailMark& mark) const;
+
+};
+
+#endif
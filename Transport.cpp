@@ -0,0 +1,11 @@
+#include "Transport.h"
+#include <chrono>
+
+using namespace std;
+
+long long NetNow() {
+
+	return chrono::duration_cast<chrono::microseconds>(
+		chrono::steady_clock::now().time_since_epoch()).count();
+
+}
@@ -0,0 +1,35 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// Unreliable datagrams between the peers of a networked game, addressed
+// by player index. A datagram may be lost, duplicated or overtaken by a
+// later one, and nothing blocks: receive() says 0 when nothing is waiting.
+// Sessions only see this interface, so the same session code runs over
+// UDP, an in-process loopback, or a loopback that loses and delays
+// datagrams on purpose.
+class Transport {
+public:
+	// Keeps a datagram inside one Ethernet frame with room for the headers
+	static const size_t MAX_DATAGRAM = 1200;
+
+	virtual ~Transport() {};
+
+	// Queue a datagram for a peer, false if it could not even be handed on.
+	// true says nothing about whether it will arrive.
+	virtual bool send(int peer, const uint8_t* data, size_t size) = 0;
+	// Copy the next waiting datagram into buffer and return its size, or 0
+	// if there is none. One longer than capacity is dropped.
+	virtual size_t receive(uint8_t* buffer, size_t capacity) = 0;
+
+};
+
+// Microseconds on a monotonic clock. Sessions and simulated links take one
+// so a test can run them on a clock of its own, faster than real time.
+typedef std::function<long long()> NetClock;
+long long NetNow();
+
+#endif
@@ -0,0 +1,225 @@
+#include "UdpTransport.h"
+#include <cstring>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+typedef int socklen_t;
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Whether the last socket call only failed because it would have had to wait
+static bool WouldBlock() {
+
+#ifdef _WIN32
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+	return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+
+}
+
+// Whether recvfrom() failed over one datagram rather than the socket:
+// too long for the buffer, or an ICMP port unreachable Windows reports
+// for a peer that isn't listening yet
+static bool SkippableReceiveError() {
+
+#ifdef _WIN32
+	int code = WSAGetLastError();
+	return code == WSAEMSGSIZE || code == WSAECONNRESET;
+#else
+	return errno == ECONNREFUSED || errno == EINTR;
+#endif
+
+}
+
+UdpTransport::UdpTransport() {
+
+	handle = -1;
+
+}
+
+UdpTransport::~UdpTransport() {
+
+	close();
+
+}
+
+bool UdpTransport::fail(const char* what) {
+
+	error = what;
+	close();
+	return false;
+
+}
+
+bool UdpTransport::open(uint16_t port) {
+
+	close();
+	error.clear();
+
+#ifdef _WIN32
+	WSADATA data;
+	if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+		error = "WSAStartup failed";
+		return false;
+	}
+	SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (s == INVALID_SOCKET) {
+		WSACleanup();
+		error = "socket failed";
+		return false;
+	}
+	handle = (intptr_t)s;
+	u_long nonBlocking = 1;
+	if (ioctlsocket(s, FIONBIO, &nonBlocking) != 0) {
+		return fail("ioctlsocket failed");
+	}
+#else
+	int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (s < 0) {
+		error = "socket failed";
+		return false;
+	}
+	handle = s;
+	int flags = fcntl(s, F_GETFL, 0);
+	if (flags < 0 || fcntl(s, F_SETFL, flags | O_NONBLOCK) < 0) {
+		return fail("fcntl failed");
+	}
+#endif
+
+	sockaddr_in local;
+	memset(&local, 0, sizeof(local));
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(INADDR_ANY);
+	local.sin_port = htons(port);
+	if (::bind(s, (const sockaddr*)&local, sizeof(local)) != 0) {
+		return fail("bind failed, is the port in use?");
+	}
+	return true;
+
+}
+
+void UdpTransport::close() {
+
+	if (handle == -1) {
+		return;
+	}
+#ifdef _WIN32
+	closesocket((SOCKET)handle);
+	WSACleanup();
+#else
+	::close((int)handle);
+#endif
+	handle = -1;
+
+}
+
+bool UdpTransport::setPeer(int peer, const string& host, uint16_t port) {
+
+	if (peer < 0) {
+		error = "bad peer index";
+		return false;
+	}
+
+	addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	addrinfo* found = nullptr;
+	if (getaddrinfo(host.c_str(), nullptr, &hints, &found) != 0 || found == nullptr) {
+		error = "can't resolve " + host;
+		return false;
+	}
+
+	if ((size_t)peer >= peers.size()) {
+		PeerAddress none = { 0, 0, false };
+		peers.resize(peer + 1, none);
+	}
+	peers[peer].address = ((const sockaddr_in*)found->ai_addr)->sin_addr.s_addr;
+	peers[peer].port = htons(port);
+	peers[peer].set = true;
+	freeaddrinfo(found);
+	return true;
+
+}
+
+bool UdpTransport::send(int peer, const uint8_t* data, size_t size) {
+
+	if (handle == -1 || peer < 0 || (size_t)peer >= peers.size() || !peers[peer].set) {
+		return false;
+	}
+
+	sockaddr_in to;
+	memset(&to, 0, sizeof(to));
+	to.sin_family = AF_INET;
+	to.sin_addr.s_addr = peers[peer].address;
+	to.sin_port = peers[peer].port;
+#ifdef _WIN32
+	int sent = sendto((SOCKET)handle, (const char*)data, (int)size, 0, (const sockaddr*)&to, sizeof(to));
+#else
+	ssize_t sent = sendto((int)handle, data, size, 0, (const sockaddr*)&to, sizeof(to));
+#endif
+	// A full send buffer loses the datagram like the network would
+	return sent == (long long)size || (sent < 0 && WouldBlock());
+
+}
+
+size_t UdpTransport::receive(uint8_t* buffer, size_t capacity) {
+
+	if (handle == -1) {
+		return 0;
+	}
+
+	// One byte over the limit shows a datagram was too long, POSIX would truncate it quietly
+	uint8_t scratch[MAX_DATAGRAM + 1];
+	while (true) {
+		sockaddr_in from;
+		socklen_t fromLength = sizeof(from);
+#ifdef _WIN32
+		int got = recvfrom((SOCKET)handle, (char*)scratch, (int)sizeof(scratch), 0, (sockaddr*)&from, &fromLength);
+#else
+		ssize_t got = recvfrom((int)handle, scratch, sizeof(scratch), 0, (sockaddr*)&from, &fromLength);
+#endif
+		if (got < 0) {
+			if (SkippableReceiveError()) {
+				continue;
+			}
+			return 0;
+		}
+		if (got == 0 || (size_t)got > capacity || (size_t)got > MAX_DATAGRAM) {
+			continue;
+		}
+		memcpy(buffer, scratch, (size_t)got);
+		return (size_t)got;
+	}
+
+}
+
+uint16_t UdpTransport::getPort() const {
+
+	if (handle == -1) {
+		return 0;
+	}
+	sockaddr_in local;
+	socklen_t length = sizeof(local);
+#ifdef _WIN32
+	if (getsockname((SOCKET)handle, (sockaddr*)&local, &length) != 0) {
+#else
+	if (getsockname((int)handle, (sockaddr*)&local, &length) != 0) {
+#endif
+		return 0;
+	}
+	return ntohs(local.sin_port);
+
+}
@@ -0,0 +1,48 @@
+#ifndef UDP_TRANSPORT_H
+#define UDP_TRANSPORT_H
+
+#include <string>
+#include <vector>
+#include "Transport.h"
+
+// Datagrams over a non-blocking IPv4 UDP socket, Winsock or BSD sockets
+// underneath. Each peer is an address and port given up front; anything
+// arriving from elsewhere is still handed to receive(), since the packets
+// say who sent them. Errors are kept for getError().
+class UdpTransport : public Transport {
+protected:
+	struct PeerAddress {
+		uint32_t address;		// Network byte order, as in sockaddr_in
+		uint16_t port;
+		bool set;
+	};
+
+	intptr_t handle;			// SOCKET on Windows, a file descriptor elsewhere, -1 when closed
+	std::vector<PeerAddress> peers;
+	std::string error;
+
+	bool fail(const char* what);
+
+public:
+	UdpTransport();
+	virtual ~UdpTransport();
+	UdpTransport(const UdpTransport&) = delete;
+	UdpTransport& operator=(const UdpTransport&) = delete;
+
+	// Bind to port on every interface, 0 for any free port
+	bool open(uint16_t port);
+	void close();
+	// host is a name or a dotted address
+	bool setPeer(int peer, const std::string& host, uint16_t port);
+
+	virtual bool send(int peer, const uint8_t* data, size_t size);
+	virtual size_t receive(uint8_t* buffer, size_t capacity);
+
+	bool isOpen() const { return handle != -1; };
+	// The bound port, the one picked when open() was given 0
+	uint16_t getPort() const;
+	const std::string& getError() const { return error; };
+
+};
+
+#endif